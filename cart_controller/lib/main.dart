@@ -1,13 +1,15 @@
 import 'package:flutter/material.dart';
 import 'dart:async';
-import 'dart:convert'; // For JSON
 
 // Services
+import 'services/telemetry_frame.dart';
 import 'services/udp_service.dart';
 
 // Widgets
 import 'widgets/control_pad.dart';
+import 'widgets/route_panel.dart';
 import 'widgets/sensor_bar.dart';
+import 'widgets/tuning_panel.dart';
 
 void main() {
   runApp(const RobotControllerApp());
@@ -53,6 +55,12 @@ class _FleetDashboardState extends State<FleetDashboard> with SingleTickerProvid
   bool _isScanning = false;
   String _lastLog = "Waiting for data...";
   List<int> _sensorData = [0,0,0,0,0,0];
+  int _batteryMv = 0;
+  int _batteryState = TelemetryFrame.batteryAbsent;
+  final Map<String, DateTime> _autoReplies = {}; // Last GO_STRAIGHT per cart
+  final ValueNotifier<List<TuningParam>> _params = ValueNotifier([]); // Selected cart
+  final ValueNotifier<DecisionQueueStatus> _decisions =
+      ValueNotifier(const DecisionQueueStatus()); // Selected cart
   
   // Heartbeat
   Timer? _heartbeatTimer;
@@ -64,6 +72,7 @@ class _FleetDashboardState extends State<FleetDashboard> with SingleTickerProvid
     // Initialize UDP
     _udpService = UdpService(
       onMessage: _handleMessage,
+      onTelemetry: _handleTelemetry,
     );
     _connect();
     
@@ -80,6 +89,8 @@ class _FleetDashboardState extends State<FleetDashboard> with SingleTickerProvid
   void dispose() {
     _heartbeatTimer?.cancel();
     _udpService.disconnect();
+    _params.dispose();
+    _decisions.dispose();
     super.dispose();
   }
 
@@ -88,6 +99,67 @@ class _FleetDashboardState extends State<FleetDashboard> with SingleTickerProvid
     _startScan();
   }
   
+  void _handleTelemetry(TelemetryFrame frame, String senderIp) {
+    if (frame.type == TelemetryFrame.typeCalibration) {
+      setState(() {
+        if (!_foundDevices.contains(senderIp)) _foundDevices.add(senderIp);
+        if (frame.calState == TelemetryFrame.calDone) {
+          _lastLog = "Calib $senderIp: done";
+        } else if (frame.calState == TelemetryFrame.calFailed) {
+          _lastLog = "Calib $senderIp: FAILED (kept previous)";
+        } else {
+          _lastLog = "Calib $senderIp: ${frame.calProgress}%";
+        }
+      });
+      return;
+    }
+    if (frame.type == TelemetryFrame.typeNode) {
+      final kind = frame.nodeType == TelemetryFrame.nodeFork ? "fork" : "node";
+      setState(() {
+        _lastLog = "$senderIp: $kind (${frame.nodeConfidence}%)";
+      });
+      return;
+    }
+    if (frame.type == TelemetryFrame.typeMotorId) {
+      setState(() {
+        if (frame.motorIdState == TelemetryFrame.motorIdDone) {
+          final ratio = frame.motorGain[0] > 0
+              ? (frame.motorGain[1] / frame.motorGain[0]).toStringAsFixed(2)
+              : "-";
+          _lastLog = "Motor ID $senderIp: done, R/L $ratio";
+        } else if (frame.motorIdState == TelemetryFrame.motorIdFailed) {
+          _lastLog = "Motor ID $senderIp: FAILED (kept previous)";
+        } else {
+          _lastLog = "Motor ID $senderIp: ${frame.motorIdProgress}%";
+        }
+      });
+      return;
+    }
+
+    // Auto Logic: State 4 = WAITING_HOST. Frames arrive at 62.5 Hz, so the
+    // reply is rate-limited (and repeated in case the datagram was lost).
+    if (frame.navState == 4) {
+      DateTime now = DateTime.now();
+      DateTime? last = _autoReplies[senderIp];
+      if (last == null || now.difference(last).inMilliseconds > 200) {
+        _autoReplies[senderIp] = now;
+        _udpService.sendCommand("NAV:GO_STRAIGHT", senderIp);
+        _lastLog = "Auto: STRAIGHT -> $senderIp";
+      }
+    }
+
+    setState(() {
+      if (!_foundDevices.contains(senderIp)) _foundDevices.add(senderIp);
+      _sensorData = frame.sensors;
+      _batteryMv = frame.batteryMv;
+      _batteryState = frame.batteryState;
+    });
+    if (senderIp == _selectedIp) {
+      _decisions.value = DecisionQueueStatus(
+          ack: frame.decisionAck, queued: frame.decisionsQueued);
+    }
+  }
+
   void _handleMessage(String msg, String senderIp) {
     // 1. Discovery (Heartbeat or Manual Ping)
     if (msg.contains("PONG") || msg.contains("ACK")) {
@@ -98,33 +170,28 @@ class _FleetDashboardState extends State<FleetDashboard> with SingleTickerProvid
       }
     }
     
-    // 2. Telemetry / Auto Logic
-    if (msg.startsWith("{")) {
-       try {
-        // Parse JSON
-        Map<String, dynamic> data = jsonDecode(msg);
-        
-        // Auto Logic: State 4 = WAITING_HOST
-        if (data.containsKey('s') && data['s'] == 4) {
-           _udpService.sendCommand("NAV:GO_STRAIGHT", senderIp);
-           setState(() => _lastLog = "Auto: STRAIGHT -> $senderIp");
-        }
-        
-        // Sensor Data
-        if (data.containsKey('v')) {
-           List<dynamic> rawList = data['v'];
-           setState(() {
-              _sensorData = rawList.map((e) => (e as num).toInt()).toList();
-           });
-        }
-        
-       } catch (e) {
-         // Ignore parse errors
-       }
+    // 2. Runtime parameters (tuning panel)
+    if (msg.startsWith("PARAMS:") && senderIp == _selectedIp) {
+      _params.value = TuningParam.parseList(msg.substring(7));
+      return;
     }
-    
+    if (msg.startsWith("ACK:PARAM:SET:") && senderIp == _selectedIp) {
+      final keyValue = msg.substring(14).split('=');
+      final value = keyValue.length == 2 ? double.tryParse(keyValue[1]) : null;
+      for (final param in _params.value) {
+        if (param.key == keyValue[0] && value != null) param.value = value;
+      }
+      _params.value = List.of(_params.value);
+    }
+    if (msg.startsWith("AUTOTUNE:DONE:") && senderIp == _selectedIp) {
+      _sendCommand("PARAM:LIST"); // pid.* changed on the cart
+    }
+    // Ahead of the next state frame, so quick sends number on correctly
+    final queue = DecisionQueueStatus.parseReply(msg);
+    if (queue != null && senderIp == _selectedIp) _decisions.value = queue;
+
     // 3. Mini-Console Logging
-    if (!msg.contains("CartFollower") && !msg.startsWith("{")) {
+    if (!msg.contains("CartFollower")) {
       setState(() => _lastLog = "[$senderIp] $msg");
     }
   }
@@ -137,6 +204,71 @@ class _FleetDashboardState extends State<FleetDashboard> with SingleTickerProvid
     });
   }
 
+  void _openTuning() {
+    if (_selectedIp == "ALL") {
+      setState(() => _lastLog = "Select a cart to tune");
+      return;
+    }
+    _params.value = [];
+    _sendCommand("PARAM:LIST");
+
+    showModalBottomSheet(
+      context: context,
+      isScrollControlled: true,
+      backgroundColor: Colors.transparent,
+      builder: (context) => FractionallySizedBox(
+        heightFactor: 0.7,
+        child: ValueListenableBuilder<List<TuningParam>>(
+          valueListenable: _params,
+          builder: (context, params, _) => TuningPanel(
+            params: params,
+            onSet: (key, value) => _sendCommand("PARAM:SET:$key,$value"),
+            onReload: () => _sendCommand("PARAM:LIST"),
+            onSave: () => _sendCommand("PARAM:SAVE"),
+            onReset: () {
+              _sendCommand("PARAM:RESET");
+              _sendCommand("PARAM:LIST");
+            },
+            // Relay test while following; the new gains come back below
+            onAutotune: () => _sendCommand("CMD:AUTOTUNE"),
+          ),
+        ),
+      ),
+    );
+  }
+
+  void _openRoutes() {
+    if (_selectedIp == "ALL") {
+      setState(() => _lastLog = "Select a cart to route");
+      return;
+    }
+
+    showModalBottomSheet(
+      context: context,
+      isScrollControlled: true,
+      backgroundColor: Colors.transparent,
+      builder: (context) => Padding(
+        padding: EdgeInsets.only(bottom: MediaQuery.of(context).viewInsets.bottom),
+        child: ValueListenableBuilder<DecisionQueueStatus>(
+          valueListenable: _decisions,
+          builder: (context, status, _) => RoutePanel(
+            status: status,
+            onCommand: _sendCommand,
+          ),
+        ),
+      ),
+    );
+  }
+
+  String _batteryLabel() {
+    final volts = "VIN ${(_batteryMv / 1000).toStringAsFixed(2)} V";
+    if (_batteryState == TelemetryFrame.batteryCutoff) {
+      return "$volts  CUT OFF (CMD:RESET)";
+    }
+    if (_batteryState == TelemetryFrame.batteryLow) return "$volts  LOW";
+    return volts;
+  }
+
   void _sendCommand(String cmd) {
     if (_selectedIp == "ALL") {
       _udpService.broadcast(cmd);
@@ -205,6 +337,17 @@ class _FleetDashboardState extends State<FleetDashboard> with SingleTickerProvid
                 padding: const EdgeInsets.symmetric(horizontal: 24.0, vertical: 8.0),
                 child: SensorBar(sensorValues: _sensorData),
               ),
+              if (_batteryState != TelemetryFrame.batteryAbsent)
+                Text(
+                  _batteryLabel(),
+                  style: TextStyle(
+                    fontFamily: 'monospace',
+                    fontSize: 12,
+                    color: _batteryState == TelemetryFrame.batteryOk
+                        ? Colors.greenAccent
+                        : Colors.redAccent,
+                  ),
+                ),
             ],
             
             // 2. MINI CONSOLE
@@ -256,7 +399,10 @@ class _FleetDashboardState extends State<FleetDashboard> with SingleTickerProvid
                     icon: Icons.settings_backup_restore, 
                     label: "CALIB", 
                     color: Colors.orange,
+                    // Tap: move the cart over the line by hand.
+                    // Hold: the cart pivots over the line by itself
                     onTap: () => _sendCommand("CMD:CALIBRATE"),
+                    onLongPress: () => _sendCommand("CMD:CALIBRATE:SWEEP"),
                   ),
                   _ActionButton(
                     icon: Icons.auto_mode, 
@@ -264,6 +410,18 @@ class _FleetDashboardState extends State<FleetDashboard> with SingleTickerProvid
                     color: Colors.purpleAccent,
                     onTap: () => _sendCommand("CMD:AUTO"), 
                   ),
+                  _ActionButton(
+                    icon: Icons.tune,
+                    label: "TUNE",
+                    color: Colors.cyanAccent,
+                    onTap: _openTuning,
+                  ),
+                  _ActionButton(
+                    icon: Icons.route,
+                    label: "ROUTE",
+                    color: Colors.greenAccent,
+                    onTap: _openRoutes,
+                  ),
                 ],
               ),
             )
@@ -331,21 +489,25 @@ class _ActionButton extends StatelessWidget {
   final String label;
   final Color color;
   final VoidCallback onTap;
+  final VoidCallback? onLongPress;
 
-  const _ActionButton({required this.icon, required this.label, required this.color, required this.onTap});
+  const _ActionButton({required this.icon, required this.label, required this.color, required this.onTap, this.onLongPress});
 
   @override
   Widget build(BuildContext context) {
     return Column(
       mainAxisSize: MainAxisSize.min,
       children: [
-        IconButton.filledTonal(
-          onPressed: onTap,
-          icon: Icon(icon),
-          style: IconButton.styleFrom(
-            backgroundColor: color.withOpacity(0.2),
-            foregroundColor: color,
-            fixedSize: const Size(56, 56)
+        GestureDetector(
+          onLongPress: onLongPress,
+          child: IconButton.filledTonal(
+            onPressed: onTap,
+            icon: Icon(icon),
+            style: IconButton.styleFrom(
+              backgroundColor: color.withOpacity(0.2),
+              foregroundColor: color,
+              fixedSize: const Size(56, 56)
+            ),
           ),
         ),
         const SizedBox(height: 4),
@@ -0,0 +1,229 @@
+import 'dart:typed_data';
+
+/// Decoded binary telemetry frame from a cart.
+///
+/// Layout (little-endian) is defined in
+/// firmware/LineFollower/src/TelemetryFrame.h: an 11-byte header
+/// ('C','T', version, type, payload length, seq u16, timestamp u32)
+/// followed by a type-specific payload.
+class TelemetryFrame {
+  static const int magic0 = 0x43; // 'C'
+  static const int magic1 = 0x54; // 'T'
+  static const int version = 1;
+  static const int headerSize = 11;
+
+  static const int typeState = 1;
+  static const int statePayloadSize = 26;
+  static const int stateLinePayloadSize = 29; // + line confidence and width
+  static const int stateBatteryPayloadSize = 32; // + battery
+  static const int stateQueuePayloadSize = 35; // + decision queue
+  static const int typeCalibration = 2;
+  static const int calibrationPayloadSize = 26;
+  static const int typeNode = 3;
+  static const int nodePayloadSize = 9;
+  static const int typeMotorId = 4;
+  static const int motorIdPayloadSize = 52;
+  static const int motorCurvePoints = 9;
+
+  // FRAME_STATE battery states (Battery::State)
+  static const int batteryAbsent = 0;
+  static const int batteryOk = 1;
+  static const int batteryLow = 2;
+  static const int batteryCutoff = 3;
+
+  // FRAME_CALIBRATION states (Calibrator::State)
+  static const int calRunning = 1;
+  static const int calDone = 2;
+  static const int calFailed = 3;
+
+  // FRAME_NODE event types (NodeEventType)
+  static const int nodeBar = 1;
+  static const int nodeFork = 2;
+
+  // FRAME_MOTOR_ID states (MotorIdentifier::State)
+  static const int motorIdRunning = 1;
+  static const int motorIdDone = 2;
+  static const int motorIdFailed = 3;
+
+  final int type;
+  final int seq;
+  final int timestampMs;
+
+  // FRAME_STATE fields
+  final int navState;
+  final int sensorState;
+  final int position;
+  final List<int> sensors;
+  final int pTerm;
+  final int iTerm;
+  final int dTerm;
+  final int motorLeft;
+  final int motorRight;
+  final int lineConfidence; // 0..100, 0 from older firmware
+  final int lineWidth;      // 1000 = one sensor pitch
+  final int batteryMv;      // Filtered VIN, 0 from older firmware
+  final int batteryState;
+  final int decisionAck;     // Last NAV:QUEUE decision taken, 0 before any
+  final int decisionsQueued; // Not yet taken
+
+  // FRAME_CALIBRATION fields
+  final int calState;
+  final int calProgress;
+  final List<int> calMinimum;
+  final List<int> calMaximum;
+
+  // FRAME_NODE fields
+  final int nodeType;
+  final int nodeConfidence; // 0..100
+  final int nodeWidth;      // Black sensors
+  final int nodeEdgeUs;     // Leading edge, cart micros()
+  final int nodeDelayUs;    // Leading edge to event
+
+  // FRAME_MOTOR_ID fields, [left, right]
+  final int motorIdState;
+  final int motorIdProgress;
+  final int pwmPeriod;              // Compare counts at 100 % duty
+  final List<int> motorThreshold;   // Compare counts
+  final List<int> motorGain;        // Position counts/s per 8-bit PWM step
+  final List<int> motorTauMs;
+  final List<List<int>> motorCurve; // Compare counts, commands 0..255
+
+  const TelemetryFrame({
+    required this.type,
+    required this.seq,
+    required this.timestampMs,
+    this.navState = 0,
+    this.sensorState = 0,
+    this.position = 0,
+    this.sensors = const [0, 0, 0, 0, 0, 0],
+    this.pTerm = 0,
+    this.iTerm = 0,
+    this.dTerm = 0,
+    this.motorLeft = 0,
+    this.motorRight = 0,
+    this.lineConfidence = 0,
+    this.lineWidth = 0,
+    this.batteryMv = 0,
+    this.batteryState = batteryAbsent,
+    this.decisionAck = 0,
+    this.decisionsQueued = 0,
+    this.calState = 0,
+    this.calProgress = 0,
+    this.calMinimum = const [0, 0, 0, 0, 0, 0],
+    this.calMaximum = const [0, 0, 0, 0, 0, 0],
+    this.nodeType = 0,
+    this.nodeConfidence = 0,
+    this.nodeWidth = 0,
+    this.nodeEdgeUs = 0,
+    this.nodeDelayUs = 0,
+    this.motorIdState = 0,
+    this.motorIdProgress = 0,
+    this.pwmPeriod = 0,
+    this.motorThreshold = const [0, 0],
+    this.motorGain = const [0, 0],
+    this.motorTauMs = const [0, 0],
+    this.motorCurve = const [[], []],
+  });
+
+  /// Cheap check to tell frames apart from text messages
+  static bool isFrame(Uint8List data) =>
+      data.length >= headerSize && data[0] == magic0 && data[1] == magic1;
+
+  /// Returns null for text packets, other versions, unknown types or
+  /// truncated frames. Longer payloads are accepted (fields are appended).
+  static TelemetryFrame? decode(Uint8List data) {
+    if (!isFrame(data)) return null;
+
+    final bytes = ByteData.sublistView(data);
+    final frameVersion = bytes.getUint8(2);
+    final type = bytes.getUint8(3);
+    final payloadLength = bytes.getUint8(4);
+    if (frameVersion != version || headerSize + payloadLength > data.length) {
+      return null;
+    }
+
+    final seq = bytes.getUint16(5, Endian.little);
+    final timestampMs = bytes.getUint32(7, Endian.little);
+
+    const p = headerSize;
+    if (type == typeCalibration && payloadLength >= calibrationPayloadSize) {
+      return TelemetryFrame(
+        type: type,
+        seq: seq,
+        timestampMs: timestampMs,
+        calState: bytes.getUint8(p),
+        calProgress: bytes.getUint8(p + 1),
+        calMinimum: List<int>.generate(
+            6, (i) => bytes.getUint16(p + 2 + 2 * i, Endian.little)),
+        calMaximum: List<int>.generate(
+            6, (i) => bytes.getUint16(p + 14 + 2 * i, Endian.little)),
+      );
+    }
+    if (type == typeNode && payloadLength >= nodePayloadSize) {
+      return TelemetryFrame(
+        type: type,
+        seq: seq,
+        timestampMs: timestampMs,
+        nodeType: bytes.getUint8(p),
+        nodeConfidence: bytes.getUint8(p + 1),
+        nodeWidth: bytes.getUint8(p + 2),
+        nodeEdgeUs: bytes.getUint32(p + 3, Endian.little),
+        nodeDelayUs: bytes.getUint16(p + 7, Endian.little),
+      );
+    }
+    if (type == typeMotorId && payloadLength >= motorIdPayloadSize) {
+      int model(int side, int field) =>
+          bytes.getUint16(p + 4 + 6 * side + 2 * field, Endian.little);
+      return TelemetryFrame(
+        type: type,
+        seq: seq,
+        timestampMs: timestampMs,
+        motorIdState: bytes.getUint8(p),
+        motorIdProgress: bytes.getUint8(p + 1),
+        pwmPeriod: bytes.getUint16(p + 2, Endian.little),
+        motorThreshold: [model(0, 0), model(1, 0)],
+        motorGain: [model(0, 1), model(1, 1)],
+        motorTauMs: [model(0, 2), model(1, 2)],
+        motorCurve: List<List<int>>.generate(
+            2,
+            (side) => List<int>.generate(
+                motorCurvePoints,
+                (i) => bytes.getUint16(
+                    p + 16 + 18 * side + 2 * i, Endian.little))),
+      );
+    }
+    if (type != typeState || payloadLength < statePayloadSize) return null;
+
+    return TelemetryFrame(
+      type: type,
+      seq: seq,
+      timestampMs: timestampMs,
+      navState: bytes.getUint8(p),
+      sensorState: bytes.getUint8(p + 1),
+      position: bytes.getUint16(p + 2, Endian.little),
+      sensors: List<int>.generate(
+          6, (i) => bytes.getUint16(p + 4 + 2 * i, Endian.little)),
+      pTerm: bytes.getInt16(p + 16, Endian.little),
+      iTerm: bytes.getInt16(p + 18, Endian.little),
+      dTerm: bytes.getInt16(p + 20, Endian.little),
+      motorLeft: bytes.getInt16(p + 22, Endian.little),
+      motorRight: bytes.getInt16(p + 24, Endian.little),
+      lineConfidence:
+          payloadLength >= stateLinePayloadSize ? bytes.getUint8(p + 26) : 0,
+      lineWidth: payloadLength >= stateLinePayloadSize
+          ? bytes.getUint16(p + 27, Endian.little)
+          : 0,
+      batteryMv: payloadLength >= stateBatteryPayloadSize
+          ? bytes.getUint16(p + 29, Endian.little)
+          : 0,
+      batteryState: payloadLength >= stateBatteryPayloadSize
+          ? bytes.getUint8(p + 31)
+          : batteryAbsent,
+      decisionAck: payloadLength >= stateQueuePayloadSize
+          ? bytes.getUint16(p + 32, Endian.little)
+          : 0,
+      decisionsQueued:
+          payloadLength >= stateQueuePayloadSize ? bytes.getUint8(p + 34) : 0,
+    );
+  }
+}
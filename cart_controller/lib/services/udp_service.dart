@@ -1,16 +1,20 @@
 import 'dart:io';
 
+import 'telemetry_frame.dart';
+
 /// Service for UDP communication with robot fleet
 class UdpService {
   RawDatagramSocket? _socket;
   final int robotPort;
   Function(String message, String senderIp)? onMessage;
+  Function(TelemetryFrame frame, String senderIp)? onTelemetry;
   
   bool get isConnected => _socket != null;
   
   UdpService({
     this.robotPort = 4210,
     this.onMessage,
+    this.onTelemetry,
   });
   
   /// Initialize UDP socket
@@ -23,8 +27,14 @@ class UdpService {
         if (e == RawSocketEvent.read) {
           Datagram? d = _socket!.receive();
           if (d != null) {
-            String msg = String.fromCharCodes(d.data);
             String senderIp = d.address.address;
+            if (TelemetryFrame.isFrame(d.data)) {
+              // Binary telemetry; unknown types/versions are dropped
+              TelemetryFrame? frame = TelemetryFrame.decode(d.data);
+              if (frame != null) onTelemetry?.call(frame, senderIp);
+              return;
+            }
+            String msg = String.fromCharCodes(d.data);
             onMessage?.call(msg, senderIp);
           }
         }
@@ -0,0 +1,180 @@
+import 'package:flutter/material.dart';
+
+/// Decision queue of the selected cart, from telemetry and NAV:QUEUE replies
+class DecisionQueueStatus {
+  final int ack;    // Last decision taken, 0 before any
+  final int queued; // Not yet taken
+
+  const DecisionQueueStatus({this.ack = 0, this.queued = 0});
+
+  /// Number the next new decision must carry
+  int get next => (ack + queued + 1) & 0xFFFF;
+
+  /// First decision still queued, the one NAV:REPLACE starts from
+  int get pending => (ack + 1) & 0xFFFF;
+
+  static final RegExp _reply =
+      RegExp(r'^(?:ACK|ERR):NAV:(?:QUEUE|REPLACE):(?:\w+,)?ack=(\d+),next=(\d+)');
+
+  /// From "ACK:NAV:QUEUE:ack=n,next=n" and the like; null for other messages
+  static DecisionQueueStatus? parseReply(String msg) {
+    final match = _reply.firstMatch(msg);
+    if (match == null) return null;
+    final ack = int.parse(match.group(1)!);
+    final next = int.parse(match.group(2)!);
+    return DecisionQueueStatus(ack: ack, queued: (next - ack - 1) & 0xFFFF);
+  }
+
+  @override
+  bool operator ==(Object other) =>
+      other is DecisionQueueStatus && other.ack == ack && other.queued == queued;
+
+  @override
+  int get hashCode => Object.hash(ack, queued);
+}
+
+/// Route entry sheet: node decisions sent ahead of the cart with NAV:QUEUE
+/// (after what it holds) or NAV:REPLACE (instead of what it has not taken
+/// yet), or a grid goal for the cart to plan itself (NAV:GOTO)
+class RoutePanel extends StatefulWidget {
+  static const int maxDecisions = 16; // DECISION_QUEUE_SIZE on the cart
+
+  final DecisionQueueStatus status;
+  final Function(String command) onCommand;
+
+  const RoutePanel({
+    super.key,
+    required this.status,
+    required this.onCommand,
+  });
+
+  @override
+  State<RoutePanel> createState() => _RoutePanelState();
+}
+
+class _RoutePanelState extends State<RoutePanel> {
+  final List<String> _decisions = [];
+  final TextEditingController _goalX = TextEditingController();
+  final TextEditingController _goalY = TextEditingController();
+
+  static const Map<String, IconData> _icons = {
+    'S': Icons.arrow_upward,
+    'L': Icons.turn_left,
+    'R': Icons.turn_right,
+    'P': Icons.local_parking,
+  };
+
+  @override
+  void dispose() {
+    _goalX.dispose();
+    _goalY.dispose();
+    super.dispose();
+  }
+
+  void _add(String decision) {
+    if (_decisions.length >= RoutePanel.maxDecisions) return;
+    setState(() => _decisions.add(decision));
+  }
+
+  void _send(bool replace) {
+    if (_decisions.isEmpty) return;
+    final seq = replace ? widget.status.pending : widget.status.next;
+    final verb = replace ? "REPLACE" : "QUEUE";
+    widget.onCommand("NAV:$verb:$seq,${_decisions.join()}");
+    setState(() => _decisions.clear());
+  }
+
+  void _goTo() {
+    final x = int.tryParse(_goalX.text);
+    final y = int.tryParse(_goalY.text);
+    if (x == null || y == null) return;
+    widget.onCommand("NAV:GOTO:$x,$y");
+  }
+
+  @override
+  Widget build(BuildContext context) {
+    final status = widget.status;
+    return Container(
+      padding: const EdgeInsets.fromLTRB(16, 12, 16, 16),
+      decoration: const BoxDecoration(
+        color: Color(0xFF101018),
+        borderRadius: BorderRadius.vertical(top: Radius.circular(16)),
+      ),
+      child: Column(
+        mainAxisSize: MainAxisSize.min,
+        crossAxisAlignment: CrossAxisAlignment.stretch,
+        children: [
+          Row(
+            children: [
+              const Text("ROUTE", style: TextStyle(color: Colors.white54, letterSpacing: 2, fontWeight: FontWeight.bold)),
+              const Spacer(),
+              Text("taken #${status.ack}  queued ${status.queued}",
+                style: const TextStyle(color: Colors.cyanAccent, fontSize: 12, fontFamily: 'monospace')),
+              IconButton(icon: const Icon(Icons.clear_all, color: Colors.orange), tooltip: "Flush the cart's queue", onPressed: () => widget.onCommand("NAV:FLUSH")),
+            ],
+          ),
+
+          // Decisions being entered, one per node ahead
+          Container(
+            constraints: const BoxConstraints(minHeight: 48),
+            padding: const EdgeInsets.all(8),
+            decoration: BoxDecoration(
+              border: Border.all(color: Colors.white12),
+              borderRadius: BorderRadius.circular(8),
+            ),
+            child: _decisions.isEmpty
+                ? const Text("Tap the decisions for the next nodes", style: TextStyle(color: Colors.white38))
+                : Wrap(
+                    spacing: 4,
+                    runSpacing: 4,
+                    children: _decisions.map((d) => Icon(_icons[d], color: Colors.white70, size: 20)).toList(),
+                  ),
+          ),
+          const SizedBox(height: 8),
+          Row(
+            mainAxisAlignment: MainAxisAlignment.spaceEvenly,
+            children: [
+              for (final entry in _icons.entries)
+                IconButton(icon: Icon(entry.value, color: Colors.white), tooltip: entry.key, onPressed: () => _add(entry.key)),
+              IconButton(
+                icon: const Icon(Icons.backspace_outlined, color: Colors.white54),
+                onPressed: _decisions.isEmpty ? null : () => setState(() => _decisions.removeLast()),
+              ),
+            ],
+          ),
+          Row(
+            children: [
+              Expanded(
+                child: ElevatedButton(
+                  onPressed: _decisions.isEmpty ? null : () => _send(false),
+                  child: const Text("SEND"),
+                ),
+              ),
+              const SizedBox(width: 8),
+              Expanded(
+                child: OutlinedButton(
+                  // Rerouting: whatever the cart has not taken yet is dropped
+                  onPressed: _decisions.isEmpty ? null : () => _send(true),
+                  child: const Text("REPLACE"),
+                ),
+              ),
+            ],
+          ),
+
+          const Divider(color: Colors.white12, height: 24),
+          Row(
+            children: [
+              const Text("GOTO", style: TextStyle(color: Colors.white54)),
+              const SizedBox(width: 12),
+              SizedBox(width: 56, child: TextField(controller: _goalX, keyboardType: TextInputType.number, decoration: const InputDecoration(labelText: "x", isDense: true))),
+              const SizedBox(width: 8),
+              SizedBox(width: 56, child: TextField(controller: _goalY, keyboardType: TextInputType.number, decoration: const InputDecoration(labelText: "y", isDense: true))),
+              const Spacer(),
+              ElevatedButton(onPressed: _goTo, child: const Text("GO")),
+            ],
+          ),
+        ],
+      ),
+    );
+  }
+}
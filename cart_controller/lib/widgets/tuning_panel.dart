@@ -0,0 +1,149 @@
+import 'package:flutter/material.dart';
+
+/// One runtime parameter as reported by the cart's PARAM:LIST reply
+class TuningParam {
+  final String key;
+  final bool isInt;
+  final double min;
+  final double max;
+  double value;
+
+  TuningParam({
+    required this.key,
+    required this.isInt,
+    required this.min,
+    required this.max,
+    required this.value,
+  });
+
+  /// Parses the payload after "PARAMS:": key=value|type|min|max;...
+  static List<TuningParam> parseList(String payload) {
+    final params = <TuningParam>[];
+    for (final entry in payload.split(';')) {
+      final fields = entry.split('|');
+      final keyValue = fields[0].split('=');
+      if (fields.length != 4 || keyValue.length != 2) continue;
+
+      final value = double.tryParse(keyValue[1]);
+      final min = double.tryParse(fields[2]);
+      final max = double.tryParse(fields[3]);
+      if (value == null || min == null || max == null) continue;
+
+      params.add(TuningParam(
+        key: keyValue[0],
+        isInt: fields[1] == 'i',
+        min: min,
+        max: max,
+        value: value,
+      ));
+    }
+    return params;
+  }
+
+  /// Value as sent in PARAM:SET
+  String format(double v) => isInt ? v.round().toString() : v.toStringAsFixed(4);
+}
+
+/// Live tuning sheet: sliders send PARAM:SET when released
+class TuningPanel extends StatefulWidget {
+  final List<TuningParam> params;
+  final Function(String key, String value) onSet;
+  final VoidCallback onReload;
+  final VoidCallback onSave;
+  final VoidCallback onReset;
+  final VoidCallback onAutotune;
+
+  const TuningPanel({
+    super.key,
+    required this.params,
+    required this.onSet,
+    required this.onReload,
+    required this.onSave,
+    required this.onReset,
+    required this.onAutotune,
+  });
+
+  @override
+  State<TuningPanel> createState() => _TuningPanelState();
+}
+
+class _TuningPanelState extends State<TuningPanel> {
+  // Slider positions while dragging, before the cart confirms
+  final Map<String, double> _dragging = {};
+
+  @override
+  Widget build(BuildContext context) {
+    return Container(
+      padding: const EdgeInsets.fromLTRB(16, 12, 16, 16),
+      decoration: const BoxDecoration(
+        color: Color(0xFF101018),
+        borderRadius: BorderRadius.vertical(top: Radius.circular(16)),
+      ),
+      child: Column(
+        mainAxisSize: MainAxisSize.min,
+        children: [
+          Row(
+            children: [
+              const Text("TUNING", style: TextStyle(color: Colors.white54, letterSpacing: 2, fontWeight: FontWeight.bold)),
+              const Spacer(),
+              IconButton(icon: const Icon(Icons.auto_fix_high, color: Colors.purpleAccent), tooltip: "Auto-tune PID (cart on the line)", onPressed: widget.onAutotune),
+              IconButton(icon: const Icon(Icons.refresh, color: Colors.cyanAccent), tooltip: "Reload", onPressed: widget.onReload),
+              IconButton(icon: const Icon(Icons.restore, color: Colors.orange), tooltip: "Defaults", onPressed: widget.onReset),
+              IconButton(icon: const Icon(Icons.save, color: Colors.greenAccent), tooltip: "Save to cart", onPressed: widget.onSave),
+            ],
+          ),
+          if (widget.params.isEmpty)
+            const Padding(
+              padding: EdgeInsets.all(24),
+              child: Text("Waiting for parameters...", style: TextStyle(color: Colors.white38)),
+            )
+          else
+            Flexible(
+              child: ListView(
+                shrinkWrap: true,
+                children: widget.params.map(_buildRow).toList(),
+              ),
+            ),
+        ],
+      ),
+    );
+  }
+
+  Widget _buildRow(TuningParam param) {
+    final shown = (_dragging[param.key] ?? param.value).clamp(param.min, param.max);
+    final span = param.max - param.min;
+
+    return Padding(
+      padding: const EdgeInsets.symmetric(vertical: 2),
+      child: Row(
+        children: [
+          SizedBox(
+            width: 120,
+            child: Text(param.key, style: const TextStyle(color: Colors.white70, fontSize: 12, fontFamily: 'monospace')),
+          ),
+          Expanded(
+            child: Slider(
+              value: shown.toDouble(),
+              min: param.min,
+              max: param.max,
+              divisions: param.isInt && span > 0 && span <= 1000 ? span.round() : null,
+              activeColor: Colors.cyanAccent,
+              onChanged: (v) => setState(() => _dragging[param.key] = v),
+              onChangeEnd: (v) {
+                setState(() => _dragging.remove(param.key));
+                widget.onSet(param.key, param.format(v));
+              },
+            ),
+          ),
+          SizedBox(
+            width: 64,
+            child: Text(param.format(shown.toDouble()),
+              textAlign: TextAlign.right,
+              style: const TextStyle(color: Colors.cyanAccent, fontSize: 12, fontFamily: 'monospace'),
+            ),
+          ),
+        ],
+      ),
+    );
+  }
+}
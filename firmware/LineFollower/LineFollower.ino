@@ -6,57 +6,139 @@
   - WiFi P2P Communication
   - LED Matrix Status Display
   - Line Following Logic
+  - Fixed-rate cooperative scheduler (1 kHz control task)
+  - Per-stage loop profiler (CMD:PROFILE)
+  - Non-blocking sensor calibration (CMD:CALIBRATE[:SWEEP|CANCEL])
+  - Motor characterisation (CMD:MOTOR_ID[:CANCEL|CLEAR])
+  - Relay-feedback PID auto-tune (CMD:AUTOTUNE[:rule[,relay]|:CANCEL])
 */
 
 #include "Arduino_LED_Matrix.h"
 #include "WiFiS3.h"
+#include "src/AutoTuner.h"
+#include "src/Battery.h"
+#include "src/Calibrator.h"
+#include "src/CommandParser.h"
+#include "src/FixedPID.h"
+#include "src/GridMap.h"
+#include "src/IterativeLearner.h"
 #include "src/LedController.h"
+#include "src/LineEstimator.h"
 #include "src/LineSensor.h"
 #include "src/MotorController.h"
+#include "src/MotorIdentifier.h"
 #include "src/Navigator.h"
 #include "src/NetworkManager.h"
+#include "src/NodeDetector.h"
+#include "src/ParamStore.h"
 #include "src/PIDController.h"
+#include "src/Profiler.h"
+#include "src/Scheduler.h"
+#include "src/SpeedGovernor.h"
+#include "src/TelemetryFrame.h"
+#include "src/TrackMemory.h"
+#include "src/TurnEngine.h"
 #include <Arduino.h>
 
 // Instantiate objects
 NetworkManager network;
 LedController led;
 LineSensor sensors;
+LineEstimator lineEstimator;
+NodeDetector nodeDetector;
 MotorController motors;
 PIDController pid(PID_KP, PID_KI, PID_KD);
-Navigator navigator;
+FixedPID fixedPid(PID_KP, PID_KI, PID_KD);
+GridMap gridMap;
+Navigator navigator(gridMap);
+TurnEngine turnEngine;
+SpeedGovernor governor;
+TrackMemory trackMemory;
+IterativeLearner ilc;
+Scheduler scheduler;
+Profiler profiler;
+ParamStore params;
+Calibrator calibrator(sensors, motors);
+MotorIdentifier motorId(motors);
+AutoTuner autoTuner;
+Battery battery;
 
-unsigned long lastPingTime = 0;
-const long interval = 2000; // Send ping every 2 seconds
+// Latest sensor results, produced by the control task for the others
+uint16_t position = 2500;
+LineSensor::SensorState sensorState = LineSensor::STATE_GAP;
+bool isNode = false; // On a node or fork (NodeDetector latch)
 
-// Telemetry Timer
-unsigned long lastTelemetryTime = 0;
+// Speed step the PID gains are currently scheduled for (SpeedGovernor),
+// and whether they follow it at all (gov.*_scale not both 1.0)
+uint8_t gainBlend = 0;
+bool gainsScheduled = false;
+
+// Cleared while WiFi is down: the control task then holds the motors
+bool linkUp = !ENABLE_WIFI;
+
+void controlTask();
+void networkTask();
+void heartbeatTask();
+void telemetryTask();
+void ledTask();
+void debugTask();
+void batteryTask();
+void dispatchCommand(char *msg);
+void applyParams();
+void applyGains(uint8_t blend);
+void applyAutoTune();
 
 void setup() {
   Serial.begin(115200);
+  profiler.begin();
+
+  // Runtime parameters (saved set or Config.h defaults)
+  params.begin();
+  applyParams();
 
   // Matrix initialization
   led.begin();
 
-  // Initialize Motors
+  // Initialize Motors (measured curves from CMD:MOTOR_ID, if saved)
   motors.begin();
+  if (motorId.load()) {
+    Serial.println("Motor curves loaded from EEPROM.");
+  }
 
   // Initialize Sensors
   sensors.begin();
 
-  // Initialize Navigator
+  // Initialize Navigator (segments learned or declared before, if saved)
   navigator.begin();
+  if (gridMap.load()) {
+    Serial.println("Grid map loaded from EEPROM.");
+  }
+  if (trackMemory.load()) {
+    Serial.println("Learned lap loaded from EEPROM.");
+  }
 
-  // Calibration Sequence
-  Serial.println("Starting Calibration...");
-  led.showCalibration();
-  sensors.calibrate();
-  Serial.println("Calibration Complete.");
+  // VIN (after the sensors: the scan may carry it)
+  battery.begin();
 
-  // Wait 3 seconds before starting motors so user can place robot
-  Serial.println("Get Ready! Starting in 3 seconds...");
-  led.showReset(); // Show "Filling" animation as readiness
-  delay(3000);
+  // Calibration: reuse the saved one; sweep only if missing or corrupt
+  bool freshCalibration = !sensors.loadCalibration();
+  if (freshCalibration) {
+    Serial.println("Starting Calibration...");
+    led.showCalibration();
+    sensors.calibrate();
+    sensors.saveCalibration();
+    Serial.println("Calibration Complete.");
+  } else {
+    Serial.println("Calibration loaded from EEPROM.");
+  }
+
+  // Wait 3 seconds before starting motors so user can place robot. With
+  // WiFi the app starts the motors, so only a fresh sweep needs it.
+  if (freshCalibration || !ENABLE_WIFI) {
+    Serial.println("Get Ready! Starting in 3 seconds...");
+    led.showReset(); // Show "Filling" animation as readiness
+    delay(3000);
+  }
 
   // Network initialization (Non-Blocking)
 #if ENABLE_WIFI
@@ -68,201 +150,1022 @@ void setup() {
   navigator.startAutonomous(); // Start Simple Following immediately
   led.showExplore(); // Show "Searching"/Moving animation
 #endif
+
+  // Task table: registration order is priority order for soft tasks.
+  // addTask() refuses a soft task that cannot fit after a control tick
+  constexpr uint32_t slackUs = CONTROL_PERIOD_US - CONTROL_BUDGET_US;
+  static_assert(NETWORK_BUDGET_US <= slackUs &&
+                    HEARTBEAT_BUDGET_US <= slackUs &&
+                    TELEMETRY_BUDGET_US <= slackUs && LED_BUDGET_US <= slackUs &&
+                    DEBUG_BUDGET_US <= slackUs && BATTERY_BUDGET_US <= slackUs,
+                "a soft task budget does not fit between control ticks");
+  scheduler.addTask("control", controlTask, CONTROL_PERIOD_US,
+                    CONTROL_BUDGET_US, true);
+#if ENABLE_WIFI
+  scheduler.addTask("network", networkTask, NETWORK_PERIOD_US,
+                    NETWORK_BUDGET_US);
+  scheduler.addTask("heartbeat", heartbeatTask, HEARTBEAT_PERIOD_US,
+                    HEARTBEAT_BUDGET_US);
+  scheduler.addTask("telemetry", telemetryTask, TELEMETRY_PERIOD_US,
+                    TELEMETRY_BUDGET_US);
+#endif
+  scheduler.addTask("led", ledTask, LED_PERIOD_US, LED_BUDGET_US);
+  scheduler.addTask("debug", debugTask, DEBUG_PERIOD_US, DEBUG_BUDGET_US);
+  scheduler.addTask("battery", batteryTask, BATTERY_PERIOD_US,
+                    BATTERY_BUDGET_US);
+  scheduler.begin();
 }
 
-void loop() {
+void loop() { scheduler.run(); }
+
+// --- CONTROL (hard rate): sensors -> navigation -> PID -> motors ---
+void controlTask() {
   unsigned long currentMillis = millis();
+  static bool wasFollowing = false; // FixedPID restarts on re-entry
 
-  // 0. Sensor Reading (FIRST THING: Get fresh, calibrated data)
-  uint16_t position = sensors.readLine();
-  LineSensor::SensorState sensorState = sensors.getState();
-  bool isNode = (sensorState == LineSensor::STATE_NODE);
+  // Pack below battery.cutoff: nothing moves until CMD:RESET
+  if (battery.isCutOff()) {
+    motors.stop(); // SAFETY STOP
+    wasFollowing = false;
+    return;
+  }
+
+  // CMD:CALIBRATE owns the sensors (and maybe the motors) until it is done
+  if (calibrator.isRunning()) {
+    if (!linkUp && calibrator.isSweeping()) {
+      calibrator.cancel(); // SAFETY STOP
+      return;
+    }
+    PROFILE_STAGE(profiler, STAGE_SENSORS);
+    calibrator.update(currentMillis);
+    nodeDetector.reset();
+    wasFollowing = false;
+    return;
+  }
+
+  // Sensor Reading (FIRST THING: Get fresh, calibrated data)
+  bool nodeEvent;
+  {
+    PROFILE_STAGE(profiler, STAGE_SENSORS);
+    position = sensors.readLine();
+    sensorState = sensors.getState();
+    // Always run, so telemetry has confidence/width whichever is selected
+    const LineEstimate &estimate = lineEstimator.update(
+        sensors.getRawValues(), sensorState == LineSensor::STATE_GAP, micros());
+    if (params.getInt(PARAM_LINE_ESTIMATOR) == LINE_ESTIMATOR_PEAK) {
+      position = estimate.position;
+    }
+    nodeEvent = nodeDetector.update(sensors.getRawValues(), micros());
+  }
+  isNode = nodeDetector.isInside();
   bool isLine = (sensorState == LineSensor::STATE_LINE);
 
+  // CMD:MOTOR_ID drives the motors itself, off this tick's line position
+  if (motorId.isRunning()) {
+    if (!linkUp) {
+      motorId.cancel(); // SAFETY STOP
+    } else {
+      PROFILE_STAGE(profiler, STAGE_CONTROL);
+      motorId.update(currentMillis, position, isLine);
+    }
+    wasFollowing = false;
+    return;
+  }
+
+  if (!linkUp) {
+    motors.stop(); // SAFETY STOP
+    wasFollowing = false;
+    return;
+  }
+
+  PROFILE_STAGE(profiler, STAGE_CONTROL);
+
+  // Update Navigation Logic
+  navigator.update(nodeEvent, currentMillis);
+  NavState state = navigator.getState();
+  bool tuning = false;
+
+  // The learned lap moves on with every node the navigator takes
+  static uint16_t seenNodes = 0;
+  if (navigator.getNodeCount() != seenNodes) {
+    seenNodes = navigator.getNodeCount();
+    NodeAction action = NODE_STOP;
+    if (state == NAV_FOLLOWING) {
+      action = NODE_THROUGH;
+    } else if (state == NAV_TURNING) {
+      action = navigator.getTurnDirection() == DIR_LEFT ? NODE_LEFT : NODE_RIGHT;
+    }
+    trackMemory.nodeReached(currentMillis, action);
+    ilc.nodeReached(trackMemory);
+  }
+
+  // Turns are profiled and guided by the array (TurnEngine.h); the tick
+  // that captures the new line already follows it
+  if (state == NAV_TURNING) {
+    if (!turnEngine.isActive()) {
+      turnEngine.start(navigator.getTurnDirection(),
+                       wasFollowing ? governor.getSpeed() : 0, currentMillis);
+    }
+    if (!turnEngine.update(sensors.getRawValues(), scheduler.getCurrentDtUs(),
+                           currentMillis, micros())) {
+      navigator.endTurn(turnEngine.isCaptured());
+      state = navigator.getState();
+    }
+  } else {
+    turnEngine.cancel();
+  }
+
+  // Motor Control
+  if (state == NAV_IDLE || state == NAV_WAITING_HOST) {
+    motors.stop();
+
+  } else if (state == NAV_AT_NODE) {
+    motors.stop();
+
+  } else if (state == NAV_TURNING) {
+    motors.setSpeeds(turnEngine.getLeftSpeed(), turnEngine.getRightSpeed());
+
+  } else if (state == NAV_FOLLOWING) {
+    int error = position - 2500;
+    int maxSpeed = params.getInt(PARAM_MAX_SPEED);
+    int baseSpeed;
+    int correction;
+
+    if (autoTuner.isRunning()) {
+      // CMD:AUTOTUNE: relay instead of the PID, at the speed gains are for
+      baseSpeed = params.getInt(PARAM_BASE_SPEED);
+      correction = autoTuner.update(currentMillis, error, isLine, micros());
+      if (autoTuner.getState() == AutoTuner::TUNE_DONE) applyAutoTune();
+      tuning = true;
+    } else {
+      // Curvature-scheduled base speed, and PID gains to match
+      // and, on a learned lap, what is coming up within braking distance
+      if (!wasFollowing) governor.reset();
+      governor.setPreview(trackMemory.preview(governor.getBrakingTravel()),
+                          params.getInt(PARAM_TRACK_SPEED));
+      baseSpeed = governor.update(error, scheduler.getCurrentDtUs());
+      if (gainsScheduled && governor.getGainBlend() != gainBlend)
+        applyGains(governor.getGainBlend());
+
+      // Runtime-selectable engine (pid.mode)
+      if (params.getInt(PARAM_PID_MODE) == PID_MODE_FIXED) {
+        if (!wasFollowing) fixedPid.reset(); // No derivative kick after a turn
+        correction =
+            fixedPid.compute(error, scheduler.getCurrentDtUs(), baseSpeed);
+      } else {
+        correction = pid.compute(error);
+      }
+      // Learned lap: what the curves here took on earlier laps
+      correction += ilc.update(trackMemory, error);
+    }
+    trackMemory.update(error, baseSpeed, scheduler.getCurrentDtUs());
+    int leftSpeed = baseSpeed - correction;
+    int rightSpeed = baseSpeed + correction;
+
+    leftSpeed = constrain(leftSpeed, -maxSpeed, maxSpeed);
+    rightSpeed = constrain(rightSpeed, -maxSpeed, maxSpeed);
+
+    motors.setSpeeds(leftSpeed, rightSpeed);
+  }
+  if (state != NAV_FOLLOWING) autoTuner.pause();
+  // The PID (re)starts clean after a turn or a tuning run
+  wasFollowing = (state == NAV_FOLLOWING) && !tuning;
+}
+
 #if ENABLE_WIFI
+// --- NETWORK: connection state machine + command handling ---
+void networkTask() {
   // 1. Update Network (State Machine)
-  network.update();
-  
+  {
+    PROFILE_STAGE(profiler, STAGE_NETWORK);
+    network.update();
+  }
+
   // 2. Check Connection State
-  static bool wasConnected = false; 
+  static bool wasConnected = false;
   bool isConnected = network.isConnected();
+  linkUp = isConnected;
 
   if (!isConnected) {
-      wasConnected = false; 
-      motors.stop(); // SAFETY STOP
-      
-      if (network.isConnecting()) {
-          led.showExplore(); 
-      } else {
-          led.showStop(); 
-      }
-      
-      led.update();
-      return; // SKIP the rest of the loop until connected
+    wasConnected = false;
+    motors.stop(); // SAFETY STOP
+
+    if (network.isConnecting()) {
+      led.showExplore();
+    } else {
+      led.showStop();
+    }
+    return; // Nothing else to do until connected
   }
-  
+
   if (!wasConnected && isConnected) {
-      wasConnected = true;
-      led.showStop(); 
-      Serial.println("Reconnected! LED set to Ready.");
+    wasConnected = true;
+    led.showStop();
+    Serial.println("Reconnected! LED set to Ready.");
   }
-#endif
 
-  // 3. Update LED animations
-  led.update();
+  // 3. Handle Commands (oldest first, bounded per tick)
+  for (uint8_t i = 0; i < UDP_RX_BUDGET; i++) {
+    UdpDatagram *packet = network.receive();
+    if (!packet) break;
 
-#if ENABLE_WIFI
-  // Periodic Heartbeat (2s)
-  if (currentMillis - lastPingTime > interval) {
-      lastPingTime = currentMillis;
-      if (network.isConnected()) {
-          network.sendPacket("PONG:CartFollower");
-      }
+    PROFILE_STAGE(profiler, STAGE_COMMANDS);
+    led.showPacketReceived(); // Visual Flash
+    Serial.print("Msg: ");
+    Serial.println(packet->data);
+    dispatchCommand(packet->data);
   }
+}
 
-  // --- SENSOR TELEMETRY (200ms) ---
-  if (currentMillis - lastTelemetryTime >= 200) {
-    lastTelemetryTime = currentMillis;
+// --- COMMANDS: GROUP:VERB[:args], see CommandParser.h ---
 
-    // Format: {"s":<state>, "v":[s0,s1,s2,s3,s4,s5]}
-    String json = "{";
-    json += "\"s\":" + String(navigator.getState()); 
-    uint16_t* sensorValues = sensors.getRawValues();
-    json += ",\"v\":[";
-    for(int i=0; i<SENSOR_COUNT; i++) {
-       // Normalize or just send raw? Sending raw (0-1000) is safer, app handles threshold.
-       json += String(sensorValues[i]);
-       if(i < SENSOR_COUNT-1) json += ",";
-    }
-    json += "]}";
-    
-    // Broadcast telemetry
-    network.broadcast(json);
+// Delegar comandos de navegación al Navigator
+void navCommand(const Command &cmd) {
+  navigator.processExternalCommand(cmd.verb);
+  char reply[32];
+  snprintf(reply, sizeof(reply), "ACK:%s", cmd.verb);
+  network.respondToLastSender(reply);
+}
+
+// NAV:GOTO:x,y -> ACK:NAV:GOTO:decisions, or ERR:NAV:GOTO without a pose
+// or a known way there. Drives the route without stopping at the nodes;
+// ROUTE:DONE:x,y or ROUTE:FAILED:reason follows.
+void navGotoCommand(const Command &cmd) {
+  long x, y;
+  if (!commandArgLong(cmd, 0, x) || !commandArgLong(cmd, 1, y) || x < 0 ||
+      x >= GRID_COLS || y < 0 || y >= GRID_ROWS ||
+      !navigator.goTo(GridMap::nodeAt(x, y))) {
+    network.respondToLastSender("ERR:NAV:GOTO");
+    return;
   }
-#endif
+  led.showExplore();
+  char reply[32];
+  snprintf(reply, sizeof(reply), "ACK:NAV:GOTO:%u",
+           navigator.getRouteRemaining());
+  network.respondToLastSender(reply);
+}
 
-#if ENABLE_WIFI
-  // 4. Handle Commands
-  if (network.hasNewMessage()) {
-    led.showPacketReceived(); // Visual Flash
-    String msg = network.getLastMessage();
-    Serial.println("Msg: " + msg);
-
-    // Delegar comandos de navegación al Navigator
-    if (msg.startsWith("NAV:")) {
-      String navCmd = msg.substring(4);
-      navigator.processExternalCommand(navCmd);
-      network.respondToLastSender("ACK:" + navCmd);
+// NAV:QUEUE:seq,decisions / NAV:REPLACE:seq,decisions: decisions is a run
+// of S, L, R, P (straight, left, right, park) for the nodes ahead, the first
+// numbered seq. -> ACK:NAV:QUEUE:ack=n,next=n (REPLACE alike), or
+// ERR:NAV:QUEUE:gap|full|stale,ack=n,next=n so the host can resend from
+// next or replan from ack; ERR:NAV:QUEUE alone if malformed (over
+// DECISION_QUEUE_SIZE letters, or another letter). See DecisionQueue.h.
+void queueDecisions(const Command &cmd, bool replace) {
+  static const char *const REASONS[] = {"", "gap,", "full,", "stale,"};
+  uint8_t decisions[DECISION_QUEUE_SIZE];
+  uint8_t count = 0;
+  long seq;
+  bool valid = commandArgLong(cmd, 0, seq) && seq >= 0 && seq <= 0xFFFF &&
+               cmd.argCount >= 2 && cmd.args[1][0] != '\0';
+  for (const char *c = valid ? cmd.args[1] : ""; *c && valid; c++) {
+    Decision decision;
+    valid = count < DECISION_QUEUE_SIZE && parseDecision(*c, decision);
+    if (valid) decisions[count++] = decision;
+  }
+  char reply[64];
+  if (!valid) {
+    snprintf(reply, sizeof(reply), "ERR:%s", cmd.key);
+  } else {
+    DecisionQueue::Result result =
+        navigator.queueDecisions(seq, decisions, count, replace);
+    snprintf(reply, sizeof(reply), "%s:%s:%sack=%u,next=%u",
+             result == DecisionQueue::QUEUE_OK ? "ACK" : "ERR", cmd.key,
+             REASONS[result], navigator.getDecisionAck(),
+             navigator.getNextDecisionSeq());
+  }
+  network.respondToLastSender(reply);
+}
+
+void navQueueCommand(const Command &cmd) { queueDecisions(cmd, false); }
+
+void navReplaceCommand(const Command &cmd) { queueDecisions(cmd, true); }
+
+// NAV:POSE:x,y,U|R|D|L: last node reached and the heading since (at that
+// node, if waiting for the host)
+void navPoseCommand(const Command &cmd) {
+  long x, y;
+  Direction heading;
+  if (!commandArgLong(cmd, 0, x) || !commandArgLong(cmd, 1, y) || x < 0 ||
+      x >= GRID_COLS || y < 0 || y >= GRID_ROWS || cmd.argCount < 3 ||
+      !parseDirection(cmd.args[2], heading)) {
+    network.respondToLastSender("ERR:NAV:POSE");
+    return;
+  }
+  navigator.setPose(GridMap::nodeAt(x, y), heading);
+  network.respondToLastSender("ACK:NAV:POSE");
+}
+
+// --- MAP: the GridMap NAV:GOTO plans on ---
+
+// Reply: MAP:grid=CxR,pose=x,y,H,exits=<hex digit per node, row 0 first>,
+// bit n of a digit set for a segment towards Direction n
+void mapGetCommand(const Command &cmd) {
+  char reply[32 + GRID_NODES] = "MAP:";
+  size_t len = 4;
+  len += snprintf(reply + len, sizeof(reply) - len, "grid=%ux%u,pose=",
+                  GRID_COLS, GRID_ROWS);
+  if (navigator.hasPose()) {
+    uint8_t node = navigator.getNode();
+    len += snprintf(reply + len, sizeof(reply) - len, "%u,%u,%c",
+                    GridMap::nodeX(node), GridMap::nodeY(node),
+                    directionLetter(navigator.getHeading()));
+  } else {
+    len += snprintf(reply + len, sizeof(reply) - len, "-");
+  }
+  len += snprintf(reply + len, sizeof(reply) - len, ",exits=");
+  for (uint8_t node = 0; node < GRID_NODES && len + 1 < sizeof(reply); node++) {
+    reply[len++] = "0123456789ABCDEF"[gridMap.getExits(node)];
+  }
+  reply[len] = '\0';
+  network.respondToLastSender(reply);
+}
+
+// MAP:EDGE:x,y,U|R|D|L: declare a segment instead of driving it
+void mapEdgeCommand(const Command &cmd) {
+  long x, y;
+  Direction dir;
+  if (!commandArgLong(cmd, 0, x) || !commandArgLong(cmd, 1, y) || x < 0 ||
+      x >= GRID_COLS || y < 0 || y >= GRID_ROWS || cmd.argCount < 3 ||
+      !parseDirection(cmd.args[2], dir) ||
+      !gridMap.addEdge(GridMap::nodeAt(x, y), dir)) {
+    network.respondToLastSender("ERR:MAP:EDGE");
+    return;
+  }
+  network.respondToLastSender("ACK:MAP:EDGE");
+}
+
+// Forgets every segment (live only until MAP:SAVE)
+void mapClearCommand(const Command &cmd) {
+  navigator.cancelRoute();
+  gridMap.clear();
+  network.respondToLastSender("ACK:MAP:CLEAR");
+}
+
+void mapSaveCommand(const Command &cmd) {
+  // A data flash write stalls the loop: only while parked
+  if (navigator.getState() != NAV_IDLE) {
+    network.respondToLastSender("ERR:MAP:SAVE:BUSY");
+    return;
+  }
+  gridMap.save();
+  network.respondToLastSender("ACK:MAP:SAVE");
+}
+
+// Comandos de sistema
+void autoCommand(const Command &cmd) {
+  trackMemory.restart(); // Expected to start where the learning run did
+  navigator.startAutonomous();
+  led.showExplore();
+}
+
+void stopCommand(const Command &cmd) {
+  calibrator.cancel();
+  motorId.cancel();
+  autoTuner.cancel();
+  trackMemory.cancel();
+  navigator.stop();
+  motors.setSpeeds(0, 0);
+  led.showStop();
+  network.respondToLastSender("ACK:STOP");
+}
+
+void resetCommand(const Command &cmd) {
+  battery.clearCutoff();
+  calibrator.cancel();
+  motorId.cancel();
+  autoTuner.cancel();
+  trackMemory.cancel();
+  navigator.stop();
+  navigator.resetPose();
+  motors.setSpeeds(0, 0);
+  led.showReset(); // The led task moves on to the stop cross
+  scheduler.resetStats();
+  profiler.reset();
+}
+
+void pingCommand(const Command &cmd) {
+  network.respondToLastSender("ACK:PING");
+  led.showPacketReceived();
+}
+
+void tasksCommand(const Command &cmd) {
+  char reply[8 + SCHEDULER_MAX_TASKS * SCHEDULER_STATS_LEN] = "TASKS:";
+  scheduler.formatStats(reply + 6, sizeof(reply) - 6);
+  network.respondToLastSender(reply);
+}
+
+void profileCommand(const Command &cmd) {
+  if (cmd.argCount > 0 && strcmp(cmd.args[0], "RESET") == 0) {
+    profiler.reset();
+    network.respondToLastSender("ACK:PROFILE:RESET");
+    return;
+  }
+  char reply[408] = "PROFILE:";
+  profiler.format(reply + 8, sizeof(reply) - 8);
+  network.respondToLastSender(reply);
+  profiler.printReport();
+}
+
+// Reply: NET:rx=..,drop=..,trunc=..,queued=..,peak=..,tx=..,txdrop=..
+void netCommand(const Command &cmd) {
+  char reply[128];
+  snprintf(reply, sizeof(reply),
+           "NET:rx=%lu,drop=%lu,trunc=%lu,queued=%u,peak=%u,tx=%lu,txdrop=%lu",
+           (unsigned long)network.getRxPackets(),
+           (unsigned long)network.getRxDropped(),
+           (unsigned long)network.getRxTruncated(),
+           network.getQueuedCount(), network.getRxHighWater(),
+           (unsigned long)network.getTxPackets(),
+           (unsigned long)network.getTxDropped());
+  network.respondToLastSender(reply);
+}
+
+// CMD:CALIBRATE (by hand) | CMD:CALIBRATE:SWEEP (cart pivots) |
+// CMD:CALIBRATE:CANCEL. Progress and result arrive as FRAME_CALIBRATION.
+void calibrateCommand(const Command &cmd) {
+  if (cmd.argCount > 0 && strcmp(cmd.args[0], "CANCEL") == 0) {
+    calibrator.cancel();
+    network.respondToLastSender("ACK:CALIBRATE:CANCEL");
+    return;
+  }
+  bool sweep = cmd.argCount > 0 && strcmp(cmd.args[0], "SWEEP") == 0;
+  motorId.cancel();
+  autoTuner.cancel();
+  navigator.stop();
+  calibrator.start(millis(), sweep ? params.getInt(PARAM_TURN_SPEED) : 0);
+  led.showCalibration();
+  network.respondToLastSender(sweep ? "ACK:CALIBRATE:SWEEP" : "ACK:CALIBRATE");
+}
+
+// CMD:MOTOR_ID (cart on a straight line, both wheels free to pivot) |
+// CMD:MOTOR_ID:CANCEL | CMD:MOTOR_ID:CLEAR (back to motor.min_* /
+// motor.factor_*). Progress and result arrive as FRAME_MOTOR_ID.
+void motorIdCommand(const Command &cmd) {
+  if (cmd.argCount > 0 && strcmp(cmd.args[0], "CANCEL") == 0) {
+    motorId.cancel();
+    network.respondToLastSender("ACK:MOTOR_ID:CANCEL");
+    return;
+  }
+  if (cmd.argCount > 0 && strcmp(cmd.args[0], "CLEAR") == 0) {
+    motorId.clear();
+    network.respondToLastSender("ACK:MOTOR_ID:CLEAR");
+    return;
+  }
+  calibrator.cancel();
+  autoTuner.cancel();
+  navigator.stop();
+  motorId.start(millis(), params.getInt(PARAM_MAX_PWM));
+  led.showCalibration();
+  network.respondToLastSender("ACK:MOTOR_ID");
+}
+
+// CMD:LEARN:segments (cart following or about to: the lap is the next
+// `segments` node-to-node segments from the first node seen) |
+// CMD:LEARN:CANCEL | CMD:LEARN:SAVE (parked) | CMD:LEARN:CLEAR. The result
+// arrives as LEARN:DONE:segments=n,lap_ms=n or LEARN:FAILED:reason; later
+// runs from the same start then plan their speed on it (track.speed).
+void learnCommand(const Command &cmd) {
+  const char *arg = cmd.argCount > 0 ? cmd.args[0] : "";
+  if (strcmp(arg, "CANCEL") == 0) {
+    trackMemory.cancel();
+    network.respondToLastSender("ACK:LEARN:CANCEL");
+    return;
+  }
+  if (strcmp(arg, "CLEAR") == 0) {
+    trackMemory.clear();
+    ilc.clear();
+    network.respondToLastSender("ACK:LEARN:CLEAR");
+    return;
+  }
+  if (strcmp(arg, "SAVE") == 0) {
+    // A data flash write stalls the loop: only while parked
+    if (navigator.getState() != NAV_IDLE || trackMemory.isLearning()) {
+      network.respondToLastSender("ERR:LEARN:SAVE:BUSY");
+      return;
     }
-    // Comandos de sistema
-    else if (msg.startsWith("CMD:AUTO")) {
-      navigator.startAutonomous();
-      led.showExplore();
-    } else if (msg.startsWith("CMD:STOP")) {
-      navigator.stop();
-      motors.setSpeeds(0, 0);
-      led.showStop();
-      network.respondToLastSender("ACK:STOP");
-    } else if (msg.startsWith("CMD:RESET")) {
-      navigator.stop();
-      motors.setSpeeds(0, 0);
-      led.showReset();
-      delay(1000);
-      led.showStop();
-      delay(1000);
-      led.showStop();
-    } else if (msg.startsWith("CMD:PING")) {
-      network.respondToLastSender("ACK:PING");
-      led.showPacketReceived();
-    } else if (msg.startsWith("CMD:CALIBRATE")) {
-      led.showCalibration();
-      sensors.calibrate();
-      network.respondToLastSender("ACK:CALIBRATE");
-      led.showStop();
+    trackMemory.save();
+    network.respondToLastSender("ACK:LEARN:SAVE");
+    return;
+  }
+  long segments;
+  if (!commandArgLong(cmd, 0, segments) || segments < 1 ||
+      segments > TRACK_MAX_SEGMENTS) {
+    network.respondToLastSender("ERR:LEARN");
+    return;
+  }
+  trackMemory.startLearning(segments);
+  ilc.clear(); // Indexed by the old segments
+  network.respondToLastSender("ACK:LEARN");
+}
+
+// TRACK:GET -> TRACK:n=segments,at=segment|-;ms,travel,action,curvature;...
+// per segment: action T(hrough) S(top) L R, curvature TRACK_BINS hex digits
+// (0..f = 0..1000 curvature), as learned
+void trackGetCommand(const Command &cmd) {
+  static const char ACTIONS[] = "TSLR";
+  static char reply[TRACK_MAX_SEGMENTS * (TRACK_BINS + 20) + 32];
+  size_t len = snprintf(reply, sizeof(reply), "TRACK:n=%u,at=",
+                        trackMemory.getSegmentCount());
+  len += trackMemory.isSynced()
+             ? snprintf(reply + len, sizeof(reply) - len, "%u",
+                        trackMemory.getSegmentIndex())
+             : snprintf(reply + len, sizeof(reply) - len, "-");
+  for (uint8_t i = 0; i < trackMemory.getSegmentCount(); i++) {
+    const TrackSegment &segment = trackMemory.getSegment(i);
+    len += snprintf(reply + len, sizeof(reply) - len, ";%u,%u,%c,",
+                    segment.durationMs, segment.travel,
+                    ACTIONS[segment.action & 3]);
+    for (uint8_t bin = 0; bin < TRACK_BINS && len + 1 < sizeof(reply); bin++) {
+      uint8_t level = segment.curvature[bin / 2] >> (bin % 2 ? 4 : 0) & 0x0F;
+      reply[len++] = "0123456789abcdef"[level];
     }
-    // TEST Commands
-    else if (msg.startsWith("TEST:FWD")) {
-      motors.setSpeeds(BASE_SPEED, BASE_SPEED);
-      network.respondToLastSender("ACK:FWD");
-    } else if (msg.startsWith("TEST:BWD")) {
-      motors.setSpeeds(-BASE_SPEED, -BASE_SPEED);
-      network.respondToLastSender("ACK:BWD");
-    } else if (msg.startsWith("TEST:LEFT")) {
-      motors.setSpeeds(-TURN_SPEED, TURN_SPEED);
-      network.respondToLastSender("ACK:LEFT");
-    } else if (msg.startsWith("TEST:RIGHT")) {
-      motors.setSpeeds(TURN_SPEED, -TURN_SPEED);
-      network.respondToLastSender("ACK:RIGHT");
+    reply[len] = '\0';
+  }
+  network.respondToLastSender(reply);
+}
+
+// CMD:AUTOTUNE[:GENTLE|NORMAL|AGGRESSIVE[,relay]] (cart on the track; starts
+// following if parked) | CMD:AUTOTUNE:CANCEL. The result arrives as
+// AUTOTUNE:DONE:... or AUTOTUNE:FAILED:reason; the gains apply at once and,
+// like PID:SET, are kept by PARAM:SAVE.
+void autotuneCommand(const Command &cmd) {
+  if (cmd.argCount > 0 && strcmp(cmd.args[0], "CANCEL") == 0) {
+    autoTuner.cancel();
+    network.respondToLastSender("ACK:AUTOTUNE:CANCEL");
+    return;
+  }
+  AutoTuner::Rule rule = AutoTuner::RULE_GENTLE;
+  if (cmd.argCount > 0) {
+    if (strcmp(cmd.args[0], "NORMAL") == 0) {
+      rule = AutoTuner::RULE_NORMAL;
+    } else if (strcmp(cmd.args[0], "AGGRESSIVE") == 0) {
+      rule = AutoTuner::RULE_AGGRESSIVE;
+    } else if (strcmp(cmd.args[0], "GENTLE") != 0) {
+      network.respondToLastSender("ERR:AUTOTUNE");
+      return;
     }
   }
-#endif
+  long relay = AUTOTUNE_RELAY;
+  if (cmd.argCount > 1 &&
+      (!commandArgLong(cmd, 1, relay) || relay <= 0 || relay > 255)) {
+    network.respondToLastSender("ERR:AUTOTUNE");
+    return;
+  }
+  calibrator.cancel();
+  motorId.cancel();
+  autoTuner.start(millis(), rule, relay);
+  if (navigator.getState() == NAV_IDLE) {
+    navigator.startAutonomous();
+    led.showExplore();
+  }
+  network.respondToLastSender("ACK:AUTOTUNE");
+}
 
-  // 4. Sensor Reading (Moved to top of loop)
+// PID:SET:kp,ki,kd
+void pidSetCommand(const Command &cmd) {
+  float kp, ki, kd;
+  if (!commandArgFloat(cmd, 0, kp) || !commandArgFloat(cmd, 1, ki) ||
+      !commandArgFloat(cmd, 2, kd) || kp < 0 || ki < 0 || kd < 0) {
+    network.respondToLastSender("ERR:PID:SET");
+    return;
+  }
+  if (!params.set(PARAM_PID_KP, kp) || !params.set(PARAM_PID_KI, ki) ||
+      !params.set(PARAM_PID_KD, kd)) {
+    applyParams(); // Keep whatever was accepted consistent
+    network.respondToLastSender("ERR:PID:SET");
+    return;
+  }
+  applyParams();
+  network.respondToLastSender("ACK:PID:SET");
+}
 
-  // 5. Update Navigation Logic
-  navigator.update(isNode, isLine, currentMillis);
-  NavState state = navigator.getState();
+// Reply: PID:kp,ki,kd
+void pidGetCommand(const Command &cmd) {
+  char reply[48] = "PID:";
+  size_t len = 4;
+  len += formatDecimal(reply + len, sizeof(reply) - len, pid.getKp(), 4);
+  reply[len++] = ',';
+  len += formatDecimal(reply + len, sizeof(reply) - len, pid.getKi(), 4);
+  reply[len++] = ',';
+  formatDecimal(reply + len, sizeof(reply) - len, pid.getKd(), 4);
+  network.respondToLastSender(reply);
+}
 
-  // 6. Debug Output
-  static unsigned long lastPrint = 0;
-  static NavState lastReportedState = NAV_IDLE;
+// PARAM:GET:key -> PARAM:key=value
+void paramGetCommand(const Command &cmd) {
+  int8_t id = cmd.argCount > 0 ? params.find(cmd.args[0]) : -1;
+  char reply[64];
+  if (id < 0) {
+    snprintf(reply, sizeof(reply), "ERR:PARAM:GET:%s",
+             cmd.argCount > 0 ? cmd.args[0] : "");
+  } else {
+    strcpy(reply, "PARAM:");
+    params.formatValue(id, reply + 6, sizeof(reply) - 6);
+  }
+  network.respondToLastSender(reply);
+}
+
+// PARAM:SET:key,value -> ACK:PARAM:SET:key=value (applied immediately)
+void paramSetCommand(const Command &cmd) {
+  int8_t id = cmd.argCount > 0 ? params.find(cmd.args[0]) : -1;
+  float value;
+  char reply[64];
+  if (id < 0 || !commandArgFloat(cmd, 1, value) || !params.set(id, value)) {
+    snprintf(reply, sizeof(reply), "ERR:PARAM:SET:%s",
+             cmd.argCount > 0 ? cmd.args[0] : "");
+  } else {
+    applyParams();
+    strcpy(reply, "ACK:PARAM:SET:");
+    params.formatValue(id, reply + 14, sizeof(reply) - 14);
+  }
+  network.respondToLastSender(reply);
+}
+
+// PARAMS:key=value|type|min|max;...
+void paramListCommand(const Command &cmd) {
+  // One datagram, well under the MTU. Static: 1 KB is a lot of stack
+  static char reply[1024];
+  strcpy(reply, "PARAMS:");
+  params.formatList(reply + 7, sizeof(reply) - 7);
+  network.respondToLastSender(reply);
+}
+
+void paramSaveCommand(const Command &cmd) {
+  // A data flash write stalls the loop: only while parked
+  if (navigator.getState() != NAV_IDLE) {
+    network.respondToLastSender("ERR:PARAM:SAVE:BUSY");
+    return;
+  }
+  params.save();
+  network.respondToLastSender("ACK:PARAM:SAVE");
+}
+
+// Back to Config.h defaults (live only until PARAM:SAVE)
+void paramResetCommand(const Command &cmd) {
+  params.resetDefaults();
+  applyParams();
+  network.respondToLastSender("ACK:PARAM:RESET");
+}
+
+// TEST Commands
+void testFwdCommand(const Command &cmd) {
+  int speed = params.getInt(PARAM_BASE_SPEED);
+  motors.setSpeeds(speed, speed);
+  network.respondToLastSender("ACK:FWD");
+}
+
+void testBwdCommand(const Command &cmd) {
+  int speed = params.getInt(PARAM_BASE_SPEED);
+  motors.setSpeeds(-speed, -speed);
+  network.respondToLastSender("ACK:BWD");
+}
+
+void testLeftCommand(const Command &cmd) {
+  int speed = params.getInt(PARAM_TURN_SPEED);
+  motors.setSpeeds(-speed, speed);
+  network.respondToLastSender("ACK:LEFT");
+}
+
+void testRightCommand(const Command &cmd) {
+  int speed = params.getInt(PARAM_TURN_SPEED);
+  motors.setSpeeds(speed, -speed);
+  network.respondToLastSender("ACK:RIGHT");
+}
 
-  if (millis() - lastPrint > 500) { // Slowed down UART debug to prioritize UDP
-    lastPrint = millis();
-    Serial.print("SENSORS: [");
-    uint16_t *raw = sensors.getRawValues();
-    for (int i = 0; i < 6; i++) {
-      Serial.print(raw[i] > 600 ? "X" : "_");
+// Sorted by key (checked at compile time): findCommand() binary-searches
+constexpr CommandEntry COMMANDS[] = {
+    {"CMD:AUTO", autoCommand},
+    {"CMD:AUTOTUNE", autotuneCommand},
+    {"CMD:CALIBRATE", calibrateCommand},
+    {"CMD:LEARN", learnCommand},
+    {"CMD:MOTOR_ID", motorIdCommand},
+    {"CMD:NET", netCommand},
+    {"CMD:PING", pingCommand},
+    {"CMD:PROFILE", profileCommand},
+    {"CMD:RESET", resetCommand},
+    {"CMD:STOP", stopCommand},
+    {"CMD:TASKS", tasksCommand},
+    {"MAP:CLEAR", mapClearCommand},
+    {"MAP:EDGE", mapEdgeCommand},
+    {"MAP:GET", mapGetCommand},
+    {"MAP:SAVE", mapSaveCommand},
+    {"NAV:FLUSH", navCommand},
+    {"NAV:GOTO", navGotoCommand},
+    {"NAV:GO_LEFT", navCommand},
+    {"NAV:GO_RIGHT", navCommand},
+    {"NAV:GO_STRAIGHT", navCommand},
+    {"NAV:POSE", navPoseCommand},
+    {"NAV:QUEUE", navQueueCommand},
+    {"NAV:REPLACE", navReplaceCommand},
+    {"NAV:WAIT", navCommand},
+    {"PARAM:GET", paramGetCommand},
+    {"PARAM:LIST", paramListCommand},
+    {"PARAM:RESET", paramResetCommand},
+    {"PARAM:SAVE", paramSaveCommand},
+    {"PARAM:SET", paramSetCommand},
+    {"PID:GET", pidGetCommand},
+    {"PID:SET", pidSetCommand},
+    {"TEST:BWD", testBwdCommand},
+    {"TEST:FWD", testFwdCommand},
+    {"TEST:LEFT", testLeftCommand},
+    {"TEST:RIGHT", testRightCommand},
+    {"TRACK:GET", trackGetCommand},
+};
+static_assert(commandTableSorted(COMMANDS), "COMMANDS must be sorted by key");
+
+void dispatchCommand(char *msg) {
+  Command cmd;
+  if (!parseCommand(msg, cmd)) return;
+
+  const CommandEntry *entry = findCommand(
+      COMMANDS, sizeof(COMMANDS) / sizeof(COMMANDS[0]), cmd.key);
+  // Unknown keys are not answered: the other cart's broadcasts (PONG:,
+  // STATUS_CHANGE:, ...) land here too
+  if (entry) entry->handler(cmd);
+}
+
+// --- HEARTBEAT (2s) ---
+void heartbeatTask() {
+  if (network.isConnected()) {
+    network.sendPacket("PONG:CartFollower");
+  }
+}
+
+// --- SENSOR TELEMETRY (binary FRAME_STATE, see TelemetryFrame.h) ---
+void telemetryTask() {
+  if (!network.isConnected()) return;
+  PROFILE_STAGE(profiler, STAGE_TELEMETRY);
+
+  static uint16_t seq = 0;
+  TelemetryFrame frame;
+
+  // Calibration progress replaces the state frame; the result is sent once
+  if (calibrator.getState() != Calibrator::CAL_IDLE) {
+    TelemetryCalibration calibration;
+    calibration.state = calibrator.getState();
+    calibration.progress = calibrator.getProgress();
+    calibration.minimum = sensors.getCalibrationMinimum();
+    calibration.maximum = sensors.getCalibrationMaximum();
+    frame.encodeCalibration(seq++, millis(), calibration);
+    network.broadcast(frame.data(), frame.size());
+
+    if (!calibrator.isRunning()) {
+      calibrator.clearResult();
+      led.showStop();
     }
-    Serial.print("] STATE: ");
-    Serial.println(state);
+    return;
+  }
 
-    // Broadcast state changes (Event driven)
-    if (state != lastReportedState) {
-      lastReportedState = state;
-      // Also broadcast status change to network
-#if ENABLE_WIFI
-      char buffer[32];
-      sprintf(buffer, "STATUS_CHANGE:%d", state);
-      network.broadcast(buffer);
-#endif
+  // Likewise for motor identification
+  if (motorId.getState() != MotorIdentifier::ID_IDLE) {
+    TelemetryMotorId result;
+    result.state = motorId.getState();
+    result.progress = motorId.getProgress();
+    for (uint8_t side = MOTOR_LEFT; side <= MOTOR_RIGHT; side++) {
+      const MotorIdentifier::Model &model = motorId.getModel(side);
+      result.threshold[side] = model.threshold;
+      result.gain[side] = model.gain;
+      result.tauMs[side] = model.tauMs;
+      result.curve[side] = motorId.getCurve(side);
     }
-    
-    // Matrix updates
-    if (state == NAV_FOLLOWING) {
-      led.showLinePosition(position);
-    } else if (isNode) {
-      led.showPing();
+    frame.encodeMotorId(seq++, millis(), result);
+    network.broadcast(frame.data(), frame.size());
+
+    if (!motorId.isRunning()) {
+      motorId.clearResult();
+      led.showStop();
     }
+    return;
   }
 
-  // 7. Motor Control
-  if (state == NAV_IDLE || state == NAV_WAITING_HOST) {
-    motors.stop();
+  // Auto-tune result, once, as text next to the state frames
+  if (autoTuner.getState() == AutoTuner::TUNE_DONE ||
+      autoTuner.getState() == AutoTuner::TUNE_FAILED) {
+    char report[128];
+    if (autoTuner.getState() == AutoTuner::TUNE_DONE) {
+      size_t len = snprintf(report, sizeof(report), "AUTOTUNE:DONE:tu_ms=%lu,ku=",
+                            (unsigned long)(autoTuner.getUltimatePeriodUs() / 1000));
+      len += formatDecimal(report + len, sizeof(report) - len,
+                           autoTuner.getUltimateGain(), 4);
+      len += snprintf(report + len, sizeof(report) - len, ",kp=");
+      len += formatDecimal(report + len, sizeof(report) - len, autoTuner.getKp(), 4);
+      len += snprintf(report + len, sizeof(report) - len, ",ki=");
+      len += formatDecimal(report + len, sizeof(report) - len, autoTuner.getKi(), 4);
+      len += snprintf(report + len, sizeof(report) - len, ",kd=");
+      formatDecimal(report + len, sizeof(report) - len, autoTuner.getKd(), 4);
+    } else {
+      snprintf(report, sizeof(report), "AUTOTUNE:FAILED:%s",
+               autoTuner.getFailure());
+    }
+    network.broadcast(report);
+    autoTuner.clearResult();
+  }
 
-  } else if (state == NAV_AT_NODE) {
-    motors.stop();
+  // Learning result, once, as text
+  if (trackMemory.getState() == TrackMemory::LEARN_DONE) {
+    char report[48];
+    snprintf(report, sizeof(report), "LEARN:DONE:segments=%u,lap_ms=%lu",
+             trackMemory.getSegmentCount(),
+             (unsigned long)trackMemory.getLapMs());
+    network.broadcast(report);
+    trackMemory.clearResult();
+  } else if (trackMemory.getState() == TrackMemory::LEARN_FAILED) {
+    char report[48];
+    snprintf(report, sizeof(report), "LEARN:FAILED:%s",
+             trackMemory.getFailure());
+    network.broadcast(report);
+    trackMemory.clearResult();
+  }
 
-  } else if (state == NAV_TURNING) {
-    Direction dir = navigator.getTurnDirection();
-    if (dir == DIR_LEFT) {
-      motors.setSpeeds(-TURN_SPEED, TURN_SPEED);
-    } else if (dir == DIR_RIGHT) {
-      motors.setSpeeds(TURN_SPEED, -TURN_SPEED);
+  // Route result, once, as text
+  if (navigator.getRouteState() == ROUTE_ARRIVED) {
+    char report[32];
+    uint8_t node = navigator.getNode();
+    snprintf(report, sizeof(report), "ROUTE:DONE:%u,%u", GridMap::nodeX(node),
+             GridMap::nodeY(node));
+    network.broadcast(report);
+    navigator.clearRouteResult();
+    led.showStop();
+  } else if (navigator.getRouteState() == ROUTE_FAILED) {
+    char report[48];
+    snprintf(report, sizeof(report), "ROUTE:FAILED:%s",
+             navigator.getRouteFailure());
+    network.broadcast(report);
+    navigator.clearRouteResult();
+  }
+
+  // A node event goes out once, in place of one state frame
+  static uint16_t sentNodeEvents = 0;
+  if (nodeDetector.getEventCount() != sentNodeEvents) {
+    sentNodeEvents = nodeDetector.getEventCount();
+    const NodeEvent &event = nodeDetector.getEvent();
+    TelemetryNode node;
+    node.type = event.type;
+    node.confidence = event.confidence;
+    node.width = event.width;
+    node.edgeUs = event.edgeUs;
+    node.confirmUs = event.confirmUs - event.edgeUs;
+    frame.encodeNode(seq++, millis(), node);
+    network.broadcast(frame.data(), frame.size());
+    return;
+  }
+
+  TelemetryState state;
+  state.navState = navigator.getState();
+  state.sensorState = sensorState;
+  state.position = position;
+  uint16_t *sensorValues = sensors.getRawValues();
+  for (int i = 0; i < SENSOR_COUNT; i++) state.sensors[i] = sensorValues[i];
+  if (params.getInt(PARAM_PID_MODE) == PID_MODE_FIXED) {
+    state.pTerm = fixedPid.getPTerm() + fixedPid.getFTerm();
+    state.iTerm = fixedPid.getITerm();
+    state.dTerm = fixedPid.getDTerm();
+  } else {
+    state.pTerm = pid.getPTerm();
+    state.iTerm = pid.getITerm();
+    state.dTerm = pid.getDTerm();
+  }
+  state.motorLeft = motors.getLeftOutput();
+  state.motorRight = motors.getRightOutput();
+  state.lineConfidence = lineEstimator.get().confidence;
+  state.lineWidth = lineEstimator.get().width;
+  state.batteryMv = battery.getMillivolts();
+  state.batteryState = battery.getState();
+  state.decisionAck = navigator.getDecisionAck();
+  state.decisionsQueued = navigator.getQueuedDecisions();
+
+  frame.encodeState(seq++, millis(), state);
+  network.broadcast(frame.data(), frame.size());
+}
+#endif
+
+// Pushes the runtime parameters into the objects that use them
+void applyParams() {
+  governor.setLimits(params.getInt(PARAM_BASE_SPEED),
+                     params.getInt(PARAM_STRAIGHT_SPEED),
+                     params.getInt(PARAM_SPEED_ACCEL),
+                     params.getInt(PARAM_SPEED_BRAKE));
+  // Unscheduled gains only change here, not on every speed step
+  gainsScheduled = params.get(PARAM_GOV_KP_SCALE) != 1 ||
+                   params.get(PARAM_GOV_KD_SCALE) != 1;
+  applyGains(governor.getGainBlend());
+  fixedPid.setFeedforward(params.get(PARAM_PID_KFF));
+  // Beyond base + max both wheels are already clamped
+  fixedPid.setOutputLimit(max(max(params.getInt(PARAM_BASE_SPEED),
+                                  params.getInt(PARAM_STRAIGHT_SPEED)),
+                              params.getInt(PARAM_TRACK_SPEED)) +
+                          params.getInt(PARAM_MAX_SPEED));
+  motors.setTuning(params.getInt(PARAM_MAX_PWM), params.getInt(PARAM_MIN_PWM_L),
+                   params.getInt(PARAM_MIN_PWM_R), params.get(PARAM_FACTOR_L),
+                   params.get(PARAM_FACTOR_R));
+  sensors.setBlackThreshold(params.getInt(PARAM_BLACK_THRESHOLD));
+  nodeDetector.setBlackThreshold(params.getInt(PARAM_BLACK_THRESHOLD));
+  sensors.setFilter(params.getInt(PARAM_SENSOR_MEDIAN),
+                    params.getInt(PARAM_SENSOR_SMOOTH));
+  navigator.setTiming(params.getInt(PARAM_NODE_COOLDOWN));
+  turnEngine.setProfile(params.getInt(PARAM_TURN_SPEED),
+                        params.getInt(PARAM_TURN_INNER),
+                        params.getInt(PARAM_TURN_CREEP),
+                        params.getInt(PARAM_TURN_ACCEL),
+                        params.getInt(PARAM_BASE_SPEED),
+                        params.getInt(PARAM_TURN_TIMEOUT));
+  turnEngine.setBlackThreshold(params.getInt(PARAM_BLACK_THRESHOLD));
+  battery.setLimits(params.get(PARAM_BATTERY_NOMINAL),
+                    params.get(PARAM_BATTERY_CUTOFF));
+  ilc.setGains(params.get(PARAM_ILC_GAIN), params.get(PARAM_ILC_FORGET));
+}
+
+// Tuned gains at speed.base, gov.*_scale times them at speed.straight;
+// blend (0..16) is where the governor's speed sits in between
+void applyGains(uint8_t blend) {
+  gainBlend = blend;
+  float kp = params.get(PARAM_PID_KP);
+  float kd = params.get(PARAM_PID_KD);
+  kp *= 1 + (params.get(PARAM_GOV_KP_SCALE) - 1) * blend / 16;
+  kd *= 1 + (params.get(PARAM_GOV_KD_SCALE) - 1) * blend / 16;
+  pid.setTunings(kp, params.get(PARAM_PID_KI), kd);
+  fixedPid.setTunings(kp, params.get(PARAM_PID_KI), kd);
+}
+
+// Auto-tuned gains into pid.* (the gain schedule scales them as usual),
+// unless a rule produced something outside the parameter ranges
+void applyAutoTune() {
+  const uint8_t ids[] = {PARAM_PID_KP, PARAM_PID_KI, PARAM_PID_KD};
+  const float gains[] = {autoTuner.getKp(), autoTuner.getKi(),
+                         autoTuner.getKd()};
+  for (uint8_t i = 0; i < 3; i++) {
+    const ParamDef &def = params.getDef(ids[i]);
+    if (!(gains[i] >= def.minValue && gains[i] <= def.maxValue)) {
+      autoTuner.reject("gains out of range");
+      return;
     }
+  }
+  for (uint8_t i = 0; i < 3; i++) params.set(ids[i], gains[i]);
+  applyGains(gainBlend);
+}
 
-  } else if (state == NAV_FOLLOWING) {
-    int error = position - 2500;
-    int correction = pid.compute(error);
+// --- BATTERY: VIN filter, motor compensation, low-voltage cut ---
+void batteryTask() {
+  bool wasCutOff = battery.isCutOff();
+  battery.update(millis());
+  motors.setSupplyScale(battery.getScaleQ12());
+  if (!battery.isCutOff() || wasCutOff) return;
+
+  // Once, on the edge: the control task holds the motors from here on
+  calibrator.cancel();
+  motorId.cancel();
+  autoTuner.cancel();
+  navigator.stop();
+  motors.stop(); // SAFETY STOP
+  led.showStop();
+  Serial.println("Battery below cutoff, motors off.");
+#if ENABLE_WIFI
+  char report[32];
+  snprintf(report, sizeof(report), "BATTERY:CUTOFF:mv=%u",
+           battery.getMillivolts());
+  network.broadcast(report);
+#endif
+}
 
-    int leftSpeed = BASE_SPEED - correction;
-    int rightSpeed = BASE_SPEED + correction;
+// --- LED animations ---
+void ledTask() {
+  PROFILE_STAGE(profiler, STAGE_LED);
+  led.update();
+}
+
+// --- DEBUG OUTPUT (500ms) ---
+void debugTask() {
+  PROFILE_STAGE(profiler, STAGE_DEBUG);
+  static NavState lastReportedState = NAV_IDLE;
+  NavState state = navigator.getState();
 
-    leftSpeed = constrain(leftSpeed, -MAX_SPEED, MAX_SPEED);
-    rightSpeed = constrain(rightSpeed, -MAX_SPEED, MAX_SPEED);
+  Serial.print("SENSORS: [");
+  uint16_t *raw = sensors.getRawValues();
+  for (int i = 0; i < 6; i++) {
+    Serial.print(raw[i] > sensors.getBlackThreshold() ? "X" : "_");
+  }
+  Serial.print("] STATE: ");
+  Serial.println(state);
 
-    motors.setSpeeds(leftSpeed, rightSpeed);
+  // Broadcast state changes (Event driven)
+  if (state != lastReportedState) {
+    lastReportedState = state;
+    // Also broadcast status change to network
+#if ENABLE_WIFI
+    char buffer[32];
+    sprintf(buffer, "STATUS_CHANGE:%d", state);
+    network.broadcast(buffer);
+#endif
   }
 
-  delay(1);
+  // Connection and calibration animations own the matrix
+  if (!linkUp || calibrator.isRunning()) return;
+
+  // Matrix updates
+  if (state == NAV_FOLLOWING) {
+    led.showLinePosition(position);
+  } else if (isNode) {
+    led.showPing();
+  }
 }
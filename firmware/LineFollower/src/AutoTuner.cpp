@@ -0,0 +1,139 @@
+#include "AutoTuner.h"
+
+// kp / Ku per rule. Above the textbook fractions: the relay swing crosses
+// the motor deadband (the inner wheel jumps from +min to -min PWM), so Ku is
+// the large-signal gain, well below the small-signal one the PID mostly
+// works at. Checked against cart_sim on the oval, square and slalom.
+static const float RULE_KP[] = {1.0f, 1.5f, 2.0f};
+// td / Tu, as in Ziegler-Nichols
+#define RULE_TD (1 / 8.0f)
+
+AutoTuner::AutoTuner() {
+  state = TUNE_IDLE;
+  rule = RULE_GENTLE;
+  progress = 0;
+  failure = "";
+  startTime = 0;
+  relay = AUTOTUNE_RELAY;
+  output = 0;
+  cycleOpen = false;
+  cycleStartUs = 0;
+  high = low = 0;
+  skip = 0;
+  cycles = 0;
+  periodSumUs = periodMinUs = periodMaxUs = 0;
+  amplitudeSum = 0;
+  ultimateGain = 0;
+  ultimatePeriodUs = 0;
+  kp = kd = 0;
+}
+
+void AutoTuner::start(unsigned long now, Rule rule, int relay) {
+  this->rule = rule;
+  this->relay = relay;
+  startTime = now;
+  output = relay;
+  cycleOpen = false;
+  skip = AUTOTUNE_SKIP_CYCLES;
+  cycles = 0;
+  periodSumUs = 0;
+  periodMinUs = UINT32_MAX;
+  periodMaxUs = 0;
+  amplitudeSum = 0;
+  progress = 0;
+  failure = "";
+  state = TUNE_RUNNING;
+}
+
+int AutoTuner::update(unsigned long now, int error, bool onLine,
+                      uint32_t nowUs) {
+  if (state != TUNE_RUNNING) return 0;
+  if (now - startTime >= AUTOTUNE_TIMEOUT_MS) {
+    fail("timeout");
+    return 0;
+  }
+  if (!onLine || abs(error) > AUTOTUNE_MAX_AMPLITUDE) {
+    fail("swing too wide, lower the relay"); // Off the linear part of the array
+    return 0;
+  }
+
+  if (cycleOpen) {
+    if (error > high) high = error;
+    if (error < low) low = error;
+  }
+
+  // Relay with hysteresis; a cycle runs from one switch to + to the next
+  if (output < 0 && error > AUTOTUNE_HYSTERESIS) {
+    output = relay;
+    if (cycleOpen) {
+      uint32_t period = nowUs - cycleStartUs;
+      if (skip > 0) {
+        skip--;
+      } else {
+        periodSumUs += period;
+        if (period < periodMinUs) periodMinUs = period;
+        if (period > periodMaxUs) periodMaxUs = period;
+        amplitudeSum += (high - low) / 2;
+        cycles++;
+        progress = cycles * 100 / AUTOTUNE_CYCLES;
+        if (cycles >= AUTOTUNE_CYCLES) {
+          finish();
+          return 0;
+        }
+      }
+    }
+    cycleOpen = true;
+    cycleStartUs = nowUs;
+    high = low = error;
+  } else if (output > 0 && error < -AUTOTUNE_HYSTERESIS) {
+    output = -relay;
+  }
+  return output;
+}
+
+void AutoTuner::pause() {
+  if (state != TUNE_RUNNING) return;
+  cycleOpen = false;
+  skip = AUTOTUNE_SKIP_CYCLES;
+}
+
+void AutoTuner::cancel() {
+  if (state != TUNE_RUNNING) return;
+  fail("cancelled");
+}
+
+void AutoTuner::reject(const char *reason) {
+  if (state != TUNE_DONE) return;
+  fail(reason);
+}
+
+void AutoTuner::clearResult() {
+  if (state != TUNE_RUNNING) state = TUNE_IDLE;
+}
+
+void AutoTuner::fail(const char *reason) {
+  failure = reason;
+  state = TUNE_FAILED;
+}
+
+void AutoTuner::finish() {
+  uint32_t meanUs = periodSumUs / cycles;
+  if ((periodMaxUs - periodMinUs) * 100 > (uint32_t)AUTOTUNE_SPREAD * meanUs) {
+    fail("irregular oscillation"); // Curves or noise, not a limit cycle
+    return;
+  }
+  float a = (float)amplitudeSum / cycles;
+  float h = AUTOTUNE_HYSTERESIS;
+  if (a <= h * 1.1f) {
+    fail("swing within the hysteresis, raise the relay");
+    return;
+  }
+
+  ultimateGain = 4 * relay / (PI * sqrtf(a * a - h * h));
+  ultimatePeriodUs = meanUs;
+  kp = RULE_KP[rule] * ultimateGain;
+  // D per nominal tick, as in PIDController and FixedPID
+  kd = kp * RULE_TD * meanUs / CONTROL_PERIOD_US;
+  progress = 100;
+  state = TUNE_DONE;
+}
@@ -0,0 +1,87 @@
+#ifndef AUTO_TUNER_H
+#define AUTO_TUNER_H
+
+#include <Arduino.h>
+#include "Config.h"
+
+// Line PID auto-tune (CMD:AUTOTUNE) by relay feedback (Astrom-Hagglund).
+// While the cart follows the line, a relay with hysteresis replaces the PID:
+// the correction is +relay or -relay by the side of the line the array is
+// on, which settles into a limit cycle at the loop's ultimate period Tu.
+// With a the error amplitude and h the hysteresis, the describing function
+// of the relay gives the ultimate gain Ku = 4 relay / (pi sqrt(a^2 - h^2)).
+// The chosen rule turns (Ku, Tu) into PD gains in this repo's units (kd per
+// nominal control tick). The integral stays off: the cart's heading already
+// integrates the correction, and a ZN reset time only winds up in curves.
+// Runs only on NAV_FOLLOWING ticks; a node or turn drops the partial cycle
+// and the oscillation settles again before measuring resumes.
+class AutoTuner {
+public:
+  enum State {
+    TUNE_IDLE,
+    TUNE_RUNNING,
+    TUNE_DONE,  // Gains ready, until clearResult()
+    TUNE_FAILED // Cancelled, lost the line or irregular, until clearResult()
+  };
+
+  // kp from Ku (see AutoTuner.cpp), td = Tu / 8 for all
+  enum Rule {
+    RULE_GENTLE,    // kp = Ku: well damped, first choice on a new surface
+    RULE_NORMAL,    // 1.5 Ku: about the hand-tuned Config.h gains
+    RULE_AGGRESSIVE // 2 Ku: fastest laps, more overshoot out of corners
+  };
+
+  AutoTuner();
+
+  // relay: correction amplitude (speed units)
+  void start(unsigned long now, Rule rule, int relay);
+  // One call per NAV_FOLLOWING tick, instead of the PID: the correction
+  int update(unsigned long now, int error, bool onLine, uint32_t nowUs);
+  void pause(); // Not following this tick
+  void cancel();
+  void reject(const char *reason); // Gains unusable after all
+  void clearResult();              // DONE/FAILED -> IDLE once reported
+
+  State getState() { return state; }
+  bool isRunning() { return state == TUNE_RUNNING; }
+  uint8_t getProgress() { return progress; } // 0..100
+  const char *getFailure() { return failure; }
+
+  // Valid once DONE
+  float getUltimateGain() { return ultimateGain; }
+  uint32_t getUltimatePeriodUs() { return ultimatePeriodUs; }
+  float getKp() { return kp; }
+  float getKi() { return 0; }
+  float getKd() { return kd; }
+
+private:
+  void fail(const char *reason);
+  void finish();
+
+  State state;
+  Rule rule;
+  uint8_t progress;
+  const char *failure;
+  unsigned long startTime;
+
+  int relay;
+  int output;            // Current relay side, +-relay
+  bool cycleOpen;        // cycleStartUs is a rising switch
+  uint32_t cycleStartUs;
+  int high;              // Error extremes within the cycle
+  int low;
+  uint8_t skip;          // Cycles left to settle
+
+  uint8_t cycles;        // Measured
+  uint32_t periodSumUs;
+  uint32_t periodMinUs;
+  uint32_t periodMaxUs;
+  uint32_t amplitudeSum;
+
+  float ultimateGain;
+  uint32_t ultimatePeriodUs;
+  float kp;
+  float kd;
+};
+
+#endif
@@ -0,0 +1,71 @@
+#include "Battery.h"
+#include "SensorScan.h"
+
+// Least boost: a freshly charged pack over nominal
+#define SCALE_MIN 0.5f
+
+Battery::Battery() {
+  state = VIN_ABSENT;
+  nominalMv = 0;
+  cutoffMv = 0;
+  filteredMv = 0;
+  primed = false;
+  lastUpdate = 0;
+  lowSince = 0;
+}
+
+void Battery::begin() {
+  if (!sensorScanRunning()) pinMode(PIN_BATTERY_SENSE, INPUT);
+  primed = false;
+}
+
+void Battery::setLimits(float nominal, float cutoff) {
+  nominalMv = nominal * 1000;
+  cutoffMv = cutoff * 1000;
+}
+
+uint16_t Battery::sample() {
+  if (sensorScanRunning()) {
+    SensorFrame frame;
+    return sensorScanLatest(frame) ? frame.aux : 0;
+  }
+  return analogRead(PIN_BATTERY_SENSE);
+}
+
+void Battery::update(unsigned long now) {
+  float mv = sample() * (BATTERY_ADC_REF_MV * BATTERY_DIVIDER / 1023);
+  if (!primed) {
+    filteredMv = mv;
+    primed = true;
+  } else {
+    float dt = now - lastUpdate;
+    filteredMv += (mv - filteredMv) * dt / (BATTERY_FILTER_MS + dt);
+  }
+  lastUpdate = now;
+
+  if (state == VIN_CUTOFF) return;
+  if (filteredMv < BATTERY_PRESENT_MV) {
+    state = VIN_ABSENT;
+  } else if (cutoffMv > 0 && filteredMv < cutoffMv) {
+    if (state != VIN_LOW) {
+      state = VIN_LOW;
+      lowSince = now;
+    } else if (now - lowSince >= BATTERY_CUTOFF_MS) {
+      state = VIN_CUTOFF;
+    }
+  } else {
+    state = VIN_OK;
+  }
+}
+
+void Battery::clearCutoff() {
+  if (state == VIN_CUTOFF) state = VIN_OK;
+}
+
+uint16_t Battery::getScaleQ12() {
+  if (nominalMv <= 0 || state == VIN_ABSENT) return 4096;
+  float scale = nominalMv / filteredMv;
+  if (scale < SCALE_MIN) scale = SCALE_MIN;
+  if (scale > BATTERY_SCALE_MAX) scale = BATTERY_SCALE_MAX;
+  return (uint16_t)(scale * 4096 + 0.5f);
+}
@@ -0,0 +1,48 @@
+#ifndef BATTERY_H
+#define BATTERY_H
+
+#include <Arduino.h>
+#include "Config.h"
+
+// VIN monitor and motor voltage compensation.
+// VIN reaches PIN_BATTERY_SENSE through a divider. Samples come from the
+// background scan's aux channel when it owns the ADC, from analogRead()
+// otherwise, and are low-passed against the sag of motor current steps.
+// The motors get nominal / measured as supply scale; below the cutoff for
+// BATTERY_CUTOFF_MS the monitor latches VIN_CUTOFF until cleared.
+// Under BATTERY_PRESENT_MV there is no pack (USB only): no scale, no cut.
+class Battery {
+public:
+  enum State {
+    VIN_ABSENT,
+    VIN_OK,
+    VIN_LOW,   // Under the cutoff, not for long yet
+    VIN_CUTOFF // Latched, until clearCutoff()
+  };
+
+  Battery();
+  void begin();
+  // Volts; 0 turns that feature off (battery.nominal / battery.cutoff)
+  void setLimits(float nominal, float cutoff);
+  void update(unsigned long now);
+  void clearCutoff();
+
+  State getState() { return state; }
+  bool isCutOff() { return state == VIN_CUTOFF; }
+  uint16_t getMillivolts() { return (uint16_t)(filteredMv + 0.5f); }
+  // For MotorController::setSupplyScale(), 4096 = 1.0
+  uint16_t getScaleQ12();
+
+private:
+  uint16_t sample();
+
+  State state;
+  float nominalMv;
+  float cutoffMv;
+  float filteredMv;
+  bool primed;
+  unsigned long lastUpdate;
+  unsigned long lowSince;
+};
+
+#endif
@@ -0,0 +1,66 @@
+#include "Calibrator.h"
+
+Calibrator::Calibrator(LineSensor &sensors, MotorController &motors)
+    : sensors(sensors), motors(motors) {
+  state = CAL_IDLE;
+  startTime = 0;
+  sweepSpeed = 0;
+  progress = 0;
+}
+
+void Calibrator::start(unsigned long now, int sweepSpeed) {
+  if (state == CAL_RUNNING) sensors.cancelCalibration();
+  sensors.startCalibration();
+  this->sweepSpeed = sweepSpeed;
+  startTime = now;
+  progress = 0;
+  state = CAL_RUNNING;
+  motors.stop();
+}
+
+void Calibrator::update(unsigned long now) {
+  if (state != CAL_RUNNING) return;
+
+  unsigned long elapsed = now - startTime;
+  if (elapsed >= CALIBRATION_TIME_MS) {
+    finish(sensors.isCalibrationPlausible());
+    return;
+  }
+
+  sensors.calibrationStep();
+  progress = elapsed * 100UL / CALIBRATION_TIME_MS;
+
+  if (sweepSpeed != 0) {
+    // Triangle wave around the start heading: half a leg left, then full
+    // legs alternating, so the cart is back near the line at each leg end
+    unsigned long leg = (elapsed + CALIBRATION_SWEEP_LEG_MS / 2) /
+                        CALIBRATION_SWEEP_LEG_MS;
+    if (leg % 2 == 0) {
+      motors.setSpeeds(-sweepSpeed, sweepSpeed);
+    } else {
+      motors.setSpeeds(sweepSpeed, -sweepSpeed);
+    }
+  }
+}
+
+void Calibrator::cancel() {
+  if (state != CAL_RUNNING) return;
+  finish(false);
+}
+
+void Calibrator::clearResult() {
+  if (state != CAL_RUNNING) state = CAL_IDLE;
+}
+
+void Calibrator::finish(bool success) {
+  motors.stop();
+  if (success) {
+    sensors.finishCalibration();
+    sensors.saveCalibration(); // Motors are stopped: the flash stall is harmless
+    progress = 100;
+    state = CAL_DONE;
+  } else {
+    sensors.cancelCalibration();
+    state = CAL_FAILED;
+  }
+}
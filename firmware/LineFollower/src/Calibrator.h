@@ -0,0 +1,46 @@
+#ifndef CALIBRATOR_H
+#define CALIBRATOR_H
+
+#include <Arduino.h>
+#include "Config.h"
+#include "LineSensor.h"
+#include "MotorController.h"
+
+// Non-blocking sensor calibration (CMD:CALIBRATE). update() takes one raw
+// read per control tick for CALIBRATION_TIME_MS, optionally pivoting the
+// cart left/right over the line so it calibrates itself. A plausible result
+// is applied and saved; otherwise the previous calibration is restored.
+class Calibrator {
+public:
+  enum State {
+    CAL_IDLE,
+    CAL_RUNNING,
+    CAL_DONE,   // Finished and saved, until clearResult()
+    CAL_FAILED  // Cancelled or implausible, until clearResult()
+  };
+
+  Calibrator(LineSensor &sensors, MotorController &motors);
+
+  // sweepSpeed 0: hold the motors, the cart is swept by hand
+  void start(unsigned long now, int sweepSpeed);
+  void update(unsigned long now);
+  void cancel();
+  void clearResult(); // DONE/FAILED -> IDLE once reported
+
+  State getState() { return state; }
+  bool isRunning() { return state == CAL_RUNNING; }
+  bool isSweeping() { return state == CAL_RUNNING && sweepSpeed != 0; }
+  uint8_t getProgress() { return progress; } // 0..100
+
+private:
+  void finish(bool success);
+
+  LineSensor &sensors;
+  MotorController &motors;
+  State state;
+  unsigned long startTime;
+  int sweepSpeed;
+  uint8_t progress;
+};
+
+#endif
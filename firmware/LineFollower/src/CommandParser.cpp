@@ -0,0 +1,81 @@
+#include "CommandParser.h"
+
+bool parseCommand(char *buffer, Command &cmd) {
+  cmd.key = buffer;
+  cmd.verb = nullptr;
+  cmd.argCount = 0;
+
+  // Group must be printable text ending in ':' (binary frames fail here)
+  char *p = buffer;
+  while (*p >= 'A' && *p <= 'Z') p++;
+  if (p == buffer || *p != ':') return false;
+  cmd.verb = ++p;
+
+  // Key ends at the second ':'; the rest is the argument list
+  while (*p && *p != ':') p++;
+  if (p == cmd.verb) return false;
+  if (*p == 0) return true;
+  *p++ = 0;
+
+  while (*p && cmd.argCount < COMMAND_MAX_ARGS) {
+    cmd.args[cmd.argCount++] = p;
+    while (*p && *p != ',') p++;
+    if (*p) *p++ = 0;
+  }
+  return true;
+}
+
+const CommandEntry *findCommand(const CommandEntry *table, size_t count,
+                                const char *key) {
+  size_t low = 0;
+  size_t high = count;
+  while (low < high) {
+    size_t mid = (low + high) / 2;
+    int order = commandKeyCompare(key, table[mid].key);
+    if (order == 0) return &table[mid];
+    if (order < 0) {
+      high = mid;
+    } else {
+      low = mid + 1;
+    }
+  }
+  return nullptr;
+}
+
+bool commandArgFloat(const Command &cmd, uint8_t index, float &value) {
+  if (index >= cmd.argCount || *cmd.args[index] == 0) return false;
+  char *end;
+  double parsed = strtod(cmd.args[index], &end);
+  if (*end != 0 || parsed != parsed) return false; // Trailing junk or NaN
+  value = parsed;
+  return true;
+}
+
+bool commandArgLong(const Command &cmd, uint8_t index, long &value) {
+  if (index >= cmd.argCount || *cmd.args[index] == 0) return false;
+  char *end;
+  long parsed = strtol(cmd.args[index], &end, 10);
+  if (*end != 0) return false;
+  value = parsed;
+  return true;
+}
+
+size_t formatDecimal(char *buf, size_t len, float value, uint8_t decimals) {
+  uint32_t scale = 1;
+  for (uint8_t i = 0; i < decimals; i++) scale *= 10;
+
+  bool negative = value < 0;
+  if (negative) value = -value;
+  uint32_t scaled = (uint32_t)(value * scale + 0.5f);
+
+  int n;
+  if (decimals == 0) {
+    n = snprintf(buf, len, "%s%lu", negative ? "-" : "",
+                 (unsigned long)scaled);
+  } else {
+    n = snprintf(buf, len, "%s%lu.%0*lu", negative ? "-" : "",
+                 (unsigned long)(scaled / scale), (int)decimals,
+                 (unsigned long)(scaled % scale));
+  }
+  return n < 0 ? 0 : (size_t)n;
+}
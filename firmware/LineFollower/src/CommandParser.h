@@ -0,0 +1,60 @@
+#ifndef COMMAND_PARSER_H
+#define COMMAND_PARSER_H
+
+#include <Arduino.h>
+
+#define COMMAND_MAX_ARGS 6
+
+// Zero-allocation parser for the UDP text protocol:
+//
+//   GROUP:VERB[:arg,arg,...]      e.g. "NAV:GO_LEFT", "PID:SET:0.09,0,1"
+//
+// parseCommand() tokenizes the receive buffer in place (separators become
+// '\0'), so every pointer in Command refers into that buffer and stays
+// valid until the next packet is read.
+struct Command {
+  const char *key;  // "GROUP:VERB", the dispatch key
+  const char *verb; // Points into key, after "GROUP:"
+  const char *args[COMMAND_MAX_ARGS];
+  uint8_t argCount;
+};
+
+typedef void (*CommandHandler)(const Command &cmd);
+
+struct CommandEntry {
+  const char *key;
+  CommandHandler handler;
+};
+
+constexpr int commandKeyCompare(const char *a, const char *b) {
+  while (*a && *a == *b) {
+    a++;
+    b++;
+  }
+  return (int)(unsigned char)*a - (int)(unsigned char)*b;
+}
+
+// Use in a static_assert next to the table: findCommand() binary-searches
+template <size_t N>
+constexpr bool commandTableSorted(const CommandEntry (&table)[N]) {
+  for (size_t i = 1; i < N; i++) {
+    if (commandKeyCompare(table[i - 1].key, table[i].key) >= 0) return false;
+  }
+  return true;
+}
+
+// False if the buffer does not look like GROUP:VERB
+bool parseCommand(char *buffer, Command &cmd);
+
+// nullptr if the key is not in the (sorted) table
+const CommandEntry *findCommand(const CommandEntry *table, size_t count,
+                                const char *key);
+
+// Argument helpers; false if missing or not a complete number
+bool commandArgFloat(const Command &cmd, uint8_t index, float &value);
+bool commandArgLong(const Command &cmd, uint8_t index, long &value);
+
+// Fixed-point rendering of a float without printf("%f") support
+size_t formatDecimal(char *buf, size_t len, float value, uint8_t decimals);
+
+#endif
@@ -20,6 +20,10 @@
 // Communication
 #define UDP_PORT 4210
 #define BROADCAST_IP "255.255.255.255" // Broadcast to all local devices
+#define UDP_RX_QUEUE_LEN 8      // Datagrams buffered between network ticks
+#define UDP_RX_MAX_PAYLOAD 128  // Longer packets are truncated (and counted)
+#define UDP_RX_BUDGET 1         // Max packets handled per network tick
+#define UDP_TX_BUFFER 2048      // Bytes of queued sends (8-byte header each)
 
 // --- Sensors & Actuators ---
 // QTR-8A (Analog) Sensor Pins
@@ -29,6 +33,12 @@ const uint8_t SENSOR_COUNT = 6;
 #define PIN_SENSOR_EMITTER                                                     \
   6 // Connect 'LEDON' or 'EMITTER' pin here for ambient light rejection
 
+// Background ADC scan (SensorScan.h) instead of blocking QTRSensors reads:
+// a timer rescans the array and the control task takes the freshest frame.
+// Off by default; while it runs nothing else may use analogRead().
+#define SENSOR_ADC_SCAN false
+#define SENSOR_SCAN_PERIOD_US 250 // 4 kHz, four frames per control tick
+
 // --- Motors (L298N) ---
 // Left Motor (D2, D3, D4)
 #define PIN_M1_EN 3
@@ -42,14 +52,34 @@ const uint8_t SENSOR_COUNT = 6;
 
 // --- PID & Speed Control ---
 // --- PID & Speed Control ---
+// Defaults only: the PID, speed, PWM and factor values below are runtime
+// parameters (ParamStore.h; PARAM:SET / PARAM:SAVE over UDP).
 #define PID_KP 0.09 // Increased for sharper turns (Mid-point)
 #define PID_KI 0.0
 #define PID_KD 1.0 // High Damping maintained
 
+// Line PID engine (pid.mode): float PIDController or Q16 FixedPID
+#define PID_MODE_FLOAT 0
+#define PID_MODE_FIXED 1
+#define PID_MODE PID_MODE_FIXED
+#define PID_KFF 0.0            // FixedPID speed feedforward
+#define PID_D_FILTER_US 2000   // FixedPID derivative low-pass time constant
+
 #define BASE_SPEED 30 // Increased for reliable movement
 #define MAX_SPEED 180 // PID headroom
 #define TURN_SPEED 90 // Sharper turns with higher power
 
+// Speed governor (SpeedGovernor.h): BASE_SPEED is the curve speed
+#define STRAIGHT_SPEED 90    // Base speed with no curvature in sight
+#define SPEED_ACCEL 200      // Speed units per second, speeding up
+#define SPEED_BRAKE 2000     // ... and slowing down
+#define GOV_KP_SCALE 1.0     // PID gains at STRAIGHT_SPEED, x tuned gains
+#define GOV_KD_SCALE 1.0
+#define GOV_ERROR_FULL 800   // Standing |error| that means full curvature
+#define GOV_RATE_FULL 20000  // |error| rate (counts/s) that means the same
+#define GOV_ATTACK_US 5000   // Curvature filter, rising
+#define GOV_RELEASE_US 200000 // ... and falling
+
 // Voltage Safety Limit for 11.1V Battery -> 6V Motors
 // Calculation: (6V / 11.1V) * 255 ~= 138.
 // User Request: Increased power for better traction/movement.
@@ -65,6 +95,29 @@ const uint8_t SENSOR_COUNT = 6;
 #define SPEED_FACTOR_L 1.0
 #define SPEED_FACTOR_R 0.9
 
+// Enable pins run on the RA4M1 GPT timers (PwmOut) instead of analogWrite()'s
+// 490 Hz / 8 bit. The MIN/MAX values above stay in 8-bit units and are scaled
+// to the period; the deadband moves with the frequency, so re-check
+// motor.min_l / motor.min_r after changing it.
+#define MOTOR_PWM_FREQ_HZ 10000
+#define MOTOR_PWM_CLOCK_HZ 48000000UL // GPT count clock (PCLKD)
+#define MOTOR_PWM_PERIOD (MOTOR_PWM_CLOCK_HZ / MOTOR_PWM_FREQ_HZ) // Steps
+#define MOTOR_CURVE_POINTS 9 // Measured command -> PWM breakpoints per motor
+
+// --- BATTERY (VIN divider, see docs/pinout.md) ---
+// MAX_PWM_LIMIT and the deadband hold at battery.nominal; duties are scaled
+// by nominal / measured to keep the motor voltage as the pack drains. Both
+// battery.* default to 0 (off): an unfitted divider leaves the pin floating.
+#define PIN_BATTERY_SENSE 10     // D10 (P103, AN019): the one free ADC pin
+#define BATTERY_DIVIDER 4.03f    // (R1 + R2) / R2, 100k over 33k
+#define BATTERY_ADC_REF_MV 5000  // analogRead() full scale
+#define BATTERY_NOMINAL 0.0      // V, e.g. 11.1 for the 3S pack; 0 = no scaling
+#define BATTERY_CUTOFF 0.0       // V, e.g. 9.6 (3.2 V/cell); 0 = no cut
+#define BATTERY_PRESENT_MV 5000  // Less: USB power, no pack on VIN
+#define BATTERY_FILTER_MS 500    // Low-pass time constant (motor current sags)
+#define BATTERY_CUTOFF_MS 2000   // Under the floor this long before cutting
+#define BATTERY_SCALE_MAX 1.5f   // Most boost (the pack at 2/3 of nominal)
+
 // --- SONAR (HC-SR04) ---
 // LOGIC DISABLED IN MAIN LOOP, DEFINES KEPT FOR COMPILATION
 #define PIN_SONAR_TRIG 12
@@ -72,8 +125,129 @@ const uint8_t SENSOR_COUNT = 6;
 #define SONAR_MAX_DIST_CM 200
 #define OBSTACLE_DIST_CM 15
 
-// --- NODE DETECTION ---
-#define NODE_THICKNESS_MS 100 // Time all sensors must be black to count as Node
-#define NODE_COOLDOWN_MS 1000 // Debounce time after leaving a node
+// --- SCHEDULER (microseconds) ---
+// Control runs on a fixed 1 kHz grid; the rest are soft tasks that only
+// start when their budget fits before the next control tick. A soft budget
+// plus CONTROL_BUDGET_US may not exceed CONTROL_PERIOD_US (addTask refuses
+// the task), so modem traffic is split into steps of one transaction each.
+#define CONTROL_PERIOD_US 1000 // Sensors + Navigation + PID + Motors
+#define CONTROL_BUDGET_US 300  // ~240 of it is the sensor read
+#define NETWORK_PERIOD_US 2000 // WiFi state machine + UDP commands
+#define NETWORK_BUDGET_US 700  // One modem transaction + one command
+#define HEARTBEAT_PERIOD_US 2000000
+#define HEARTBEAT_BUDGET_US 100 // Sends only queue; network sends them
+#define TELEMETRY_PERIOD_US 16000 // 62.5 Hz binary frames
+#define TELEMETRY_BUDGET_US 200
+#define LED_PERIOD_US 20000
+#define LED_BUDGET_US 100
+#define DEBUG_PERIOD_US 500000 // Slowed down UART debug to prioritize UDP
+#define DEBUG_BUDGET_US 300
+#define BATTERY_PERIOD_US 20000 // VIN sample + filter
+#define BATTERY_BUDGET_US 100
+
+// --- PROFILER ---
+// Per-stage timing histograms, read back with CMD:PROFILE.
+// Set to false to compile the instrumentation out entirely.
+#define ENABLE_PROFILER true
+
+// --- NODE DETECTION (NodeDetector.h) ---
+#define NODE_CONFIRM_US 1000  // Pattern must hold this long past its leading edge
+#define NODE_CLEAR_MS 20      // Plain line this long before the next node
+#define NODE_MIN_BLACK 5      // Black sensors for a bar (one less if it grew both ways)
+#define NODE_LINE_MAX_BLACK 3 // Wider than this is not a plain line
+#define NODE_EARLY 100        // Sensors turn black this far below sensor.black
+#define NODE_HYSTERESIS 200   // ... and white again this far below that
+#define NODE_COOLDOWN_MS 200  // Navigator: ignore nodes this long after one
+#define LINE_BLACK_THRESHOLD 600 // Calibrated reading (0-1000) counted as black
+
+// --- SENSOR FILTER (sensor.median, sensor.smooth) ---
+#define SENSOR_OVERSAMPLE 4      // Conversions averaged per reading: 1, 2 or 4
+#define SENSOR_MEDIAN 3          // Running median over 1, 3 or 5 frames
+#define SENSOR_SMOOTH 1          // IIR y += (x - y) / 2^n per frame, 0 = off
+#define SENSOR_SMOOTH_MAX 4
+#define SENSOR_SMOOTH_FRACTION 4 // Extra bits of IIR state below a count
+#define SENSOR_FILTER_SIMD true  // Packed Cortex-M4 SIMD path (SensorFilter.h)
+
+// --- LINE POSITION (line.estimator) ---
+#define LINE_ESTIMATOR_QTR 0      // QTR weighted average
+#define LINE_ESTIMATOR_PEAK 1     // LineEstimator parabolic peak fit
+#define LINE_ESTIMATOR LINE_ESTIMATOR_PEAK
+#define LINE_MIN_CONFIDENCE 20    // Fits below this are not trusted for rate
+#define LINE_PLATEAU_TOLERANCE 50 // Readings this close to the peak are "flat top"
+#define LINE_GAP_HOLD_MS 150      // Extrapolate across a gap this long
+
+// --- TURNS (TurnEngine.h; TURN_SPEED is the outer wheel's cruise) ---
+#define TURN_INNER 0            // Inner wheel, % of the outer: -100 pivots
+#define TURN_CREEP_MS 0         // Straight on past the node, 0 = as needed
+#define TURN_PIVOT_CREEP_MS 100 // As needed with the inner wheel reversing
+#define TURN_ACCEL 2000         // Wheel speed ramps, speed units per second
+#define TURN_HANDOFF_US 20000   // The PID takes over this long before centre
+#define TURN_TIMEOUT_MS 1500    // Give up and resume following
+
+// --- CALIBRATION ---
+#define CALIBRATION_GROUP 10         // Reads per noise-rejection group
+#define CALIBRATION_BOOT_READS 1500  // Blocking sweep in setup()
+#define CALIBRATION_TIME_MS 3000     // CMD:CALIBRATE, one read per control tick
+#define CALIBRATION_SWEEP_LEG_MS 500 // Pivot one way per leg (CMD:CALIBRATE:SWEEP)
+// TIME a multiple of LEG: the sweep ends on the heading it started from
+
+// --- MOTOR IDENTIFICATION (CMD:MOTOR_ID) ---
+// Each wheel in turn pivots the cart over a straight line while the other
+// holds; the line position serves as the heading sensor
+#define MOTORID_SETTLE_MS 300  // Stopped before each test
+#define MOTORID_RAMP_RATE 20   // PWM (8-bit) per second, start threshold search
+#define MOTORID_MOVE 150       // Position counts that mean "turning"
+#define MOTORID_STEPS 4        // Step levels, threshold .. motor.max_pwm
+#define MOTORID_STEP_MARGIN 4  // Lowest step above the threshold (PWM, 8-bit)
+#define MOTORID_MARK 100       // First timing mark past the start (counts)
+#define MOTORID_STEP_MS 1500   // Longest step
+#define MOTORID_RETURN_MS 3000 // Longest drive back between tests
+#define MOTORID_FLOOR 30       // Speed for command 1, % of the top speed
+
+// --- PID AUTO-TUNE (CMD:AUTOTUNE) ---
+// Relay feedback around the line at speed.base, see AutoTuner.h
+#define AUTOTUNE_RELAY 40           // Default correction amplitude (speed units)
+#define AUTOTUNE_HYSTERESIS 100     // Error band the relay holds through
+#define AUTOTUNE_SKIP_CYCLES 2      // Settling cycles, not measured
+#define AUTOTUNE_CYCLES 6           // Measured cycles
+#define AUTOTUNE_MAX_AMPLITUDE 2000 // |error| that aborts: relay too strong
+#define AUTOTUNE_SPREAD 30          // Largest period spread, % of the mean
+#define AUTOTUNE_TIMEOUT_MS 20000
+
+// --- ROUTES (GridMap.h, NAV:GOTO) ---
+// Nodes lie on a grid with one segment between neighbours: x grows to the
+// right (DIR_RIGHT), y upwards (DIR_UP). GRID_COLS * GRID_ROWS <= 64.
+#define GRID_COLS 8
+#define GRID_ROWS 8
+#define GRID_START_X 0       // Pose at boot and CMD:RESET: leaving this node
+#define GRID_START_Y 0
+#define GRID_START_HEADING 0 // ... this way (Direction, 0 = DIR_UP)
+#define ROUTE_EDGE_COST 10   // Planner cost of a segment
+#define ROUTE_TURN_COST 6    // ... extra for a turn at its start node
+#define ROUTE_MAX_STEPS 32   // Decisions in one route
+#define DECISION_QUEUE_SIZE 16 // NAV:QUEUE decisions held ahead of the cart
+
+// --- TRACK LEARNING (TrackMemory.h) ---
+#define TRACK_MAX_SEGMENTS 16 // Node-to-node segments in a learned lap
+#define TRACK_BINS 32         // Curvature samples per segment, 4 bit each
+#define TRACK_SLOTS 64        // Recording resolution within a segment
+#define TRACK_SLOT_TRAVEL 500 // First slot width (speed x ms), doubles as needed
+#define TRACK_FILTER_US 20000 // Curvature low-pass while recording
+#define TRACK_MATCH 35        // % off a learned segment's travel: not that one
+#define TRACK_SPEED 0         // Top speed on learned straights, 0 = speed.straight
+#define GOV_PREVIEW_LEAD_MS 150 // Look this far past the braking distance
+
+// Iterative learning control on the learned lap (IterativeLearner.h)
+#define ILC_BINS 32      // Feedforward steps per segment
+#define ILC_GAIN 0.06    // ilc.gain: speed units per count of mean error, per lap
+#define ILC_FORGET 0.95  // ilc.forget: share of the profile kept per lap
+#define ILC_MAX 60       // |feedforward| bound, speed units
+
+// --- EEPROM LAYOUT (R4: emulated in 8 KB data flash, see Storage.h) ---
+#define EEPROM_PARAMS_ADDR 0 // ParamStore record (140 bytes with 32 params)
+#define EEPROM_CALIBRATION_ADDR 256 // LineSensor min/max record
+#define EEPROM_MOTOR_ADDR 512 // MotorIdentifier curves (~60 bytes)
+#define EEPROM_MAP_ADDR 768 // GridMap segments (GRID_COLS * GRID_ROWS bytes)
+#define EEPROM_TRACK_ADDR 1024 // TrackMemory lap (~360 bytes)
 
 #endif
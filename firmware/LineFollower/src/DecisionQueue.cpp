@@ -0,0 +1,55 @@
+#include "DecisionQueue.h"
+
+static const char LETTERS[] = "SLRP";
+
+bool parseDecision(char letter, Decision &decision) {
+  const char *found = letter ? strchr(LETTERS, letter) : nullptr;
+  if (!found) return false;
+  decision = (Decision)(found - LETTERS);
+  return true;
+}
+
+DecisionQueue::DecisionQueue() {
+  head = 0;
+  count = 0;
+  ack = 0;
+}
+
+DecisionQueue::Result DecisionQueue::append(uint16_t firstSeq,
+                                            const uint8_t *decisions,
+                                            uint8_t count) {
+  // Position of firstSeq from the front; negative: already taken
+  int16_t offset = (int16_t)(firstSeq - (uint16_t)(ack + 1));
+  if (offset > this->count) return QUEUE_GAP;
+  int16_t skip = this->count - offset; // Already queued or taken
+  if (skip >= count) return QUEUE_OK;  // A plain resend
+  if (this->count + (count - skip) > DECISION_QUEUE_SIZE) return QUEUE_FULL;
+
+  for (uint8_t i = skip; i < count; i++) {
+    entries[(head + this->count) % DECISION_QUEUE_SIZE] = decisions[i];
+    this->count++;
+  }
+  return QUEUE_OK;
+}
+
+DecisionQueue::Result DecisionQueue::replace(uint16_t firstSeq,
+                                             const uint8_t *decisions,
+                                             uint8_t count) {
+  int16_t offset = (int16_t)(firstSeq - (uint16_t)(ack + 1));
+  if (offset < 0) return QUEUE_STALE;
+  if (offset > this->count) return QUEUE_GAP;
+  if (offset + count > DECISION_QUEUE_SIZE) return QUEUE_FULL;
+  this->count = offset;
+  return append(firstSeq, decisions, count);
+}
+
+void DecisionQueue::flush() { count = 0; }
+
+bool DecisionQueue::take(Decision &decision) {
+  if (count == 0) return false;
+  decision = (Decision)entries[head];
+  head = (head + 1) % DECISION_QUEUE_SIZE;
+  count--;
+  ack++;
+  return true;
+}
@@ -0,0 +1,53 @@
+#ifndef DECISION_QUEUE_H
+#define DECISION_QUEUE_H
+
+#include <Arduino.h>
+#include "Config.h"
+
+// What to do at a node, relative to the heading
+enum Decision {
+  DECISION_STRAIGHT, // 'S'
+  DECISION_LEFT,     // 'L'
+  DECISION_RIGHT,    // 'R'
+  DECISION_PARK      // 'P': stop on the node
+};
+
+bool parseDecision(char letter, Decision &decision);
+
+// Node decisions the host sends ahead of the cart (NAV:QUEUE), one taken
+// per node event so the cart never waits for a round trip.
+// Decisions are numbered consecutively (u16, wrapping) by the host: the
+// front entry is ack + 1, the next new one ack + 1 + count. A resend that
+// overlaps what is queued or taken only adds the new tail, so the host can
+// simply repeat a message it got no ACK for. Nothing is queued past a gap.
+class DecisionQueue {
+public:
+  enum Result {
+    QUEUE_OK,
+    QUEUE_GAP,   // First number past the next expected one
+    QUEUE_FULL,  // Would exceed DECISION_QUEUE_SIZE; nothing queued
+    QUEUE_STALE  // Replace from a decision already taken
+  };
+
+  DecisionQueue();
+
+  // Decisions firstSeq, firstSeq + 1, ...
+  Result append(uint16_t firstSeq, const uint8_t *decisions, uint8_t count);
+  // Drops the pending decisions from firstSeq on, then appends
+  Result replace(uint16_t firstSeq, const uint8_t *decisions, uint8_t count);
+  void flush(); // Drops every pending decision; numbering goes on from ack
+
+  bool take(Decision &decision); // Front entry; false when empty
+  bool isEmpty() { return count == 0; }
+  uint8_t getCount() { return count; }
+  uint16_t getAck() { return ack; } // Last taken, 0 before the first
+  uint16_t getNextSeq() { return ack + 1 + count; }
+
+private:
+  uint8_t entries[DECISION_QUEUE_SIZE]; // Decision, ring from head
+  uint8_t head;
+  uint8_t count;
+  uint16_t ack;
+};
+
+#endif
@@ -0,0 +1,99 @@
+#include "FixedPID.h"
+
+#define Q16_SHIFT 16
+
+static int32_t toQ16(float value) { return (int32_t)lroundf(value * 65536.0f); }
+
+static int64_t clamp64(int64_t value, int64_t limit) {
+  if (value > limit) return limit;
+  if (value < -limit) return -limit;
+  return value;
+}
+
+FixedPID::FixedPID(float kp, float ki, float kd) {
+  kff = 0;
+  outputLimit = BASE_SPEED + MAX_SPEED;
+  filterTauUs = PID_D_FILTER_US;
+  setTunings(kp, ki, kd);
+  reset();
+}
+
+void FixedPID::setTunings(float kp, float ki, float kd) {
+  this->kp = toQ16(kp);
+  this->ki = toQ16(ki);
+  this->kd = toQ16(kd);
+  updateIntegralLimit();
+}
+
+// Q32 of kff / 1000, so compute() needs a shift instead of a division
+void FixedPID::setFeedforward(float kff) {
+  this->kff = (int32_t)lroundf(kff * 65536.0f * 65.536f);
+}
+
+void FixedPID::setOutputLimit(int limit) {
+  outputLimit = limit;
+  updateIntegralLimit();
+}
+
+void FixedPID::setDerivativeFilter(uint32_t tauUs) { filterTauUs = tauUs; }
+
+void FixedPID::reset() {
+  integral = 0;
+  lastError = 0;
+  filteredRate = 0;
+  primed = false;
+  pTerm = iTerm = dTerm = fTerm = 0;
+}
+
+void FixedPID::updateIntegralLimit() {
+  // |ki * integral| <= limit; the only 64-bit division, kept off the tick
+  maxIntegral = ki > 0 ? ((int64_t)outputLimit << 32) / ki : 0;
+}
+
+int FixedPID::compute(int error, uint32_t dtUs, int speed) {
+  // A stalled loop counts as a few periods at most, not one huge step;
+  // a bunched-up tick is not allowed to blow up the derivative either
+  if (dtUs < CONTROL_PERIOD_US / 4) dtUs = CONTROL_PERIOD_US / 4;
+  if (dtUs > 4 * CONTROL_PERIOD_US) dtUs = 4 * CONTROL_PERIOD_US;
+
+  // Both fit 32 bits for the clamped dt: hardware divides only
+  int32_t ticks = (dtUs << Q16_SHIFT) / CONTROL_PERIOD_US;       // Q16
+  int32_t perTick = ((uint32_t)CONTROL_PERIOD_US << Q16_SHIFT) / dtUs;
+
+  // D: change per nominal tick, then first-order low-pass
+  int32_t rate = primed ? (error - lastError) * perTick : 0;
+  lastError = error;
+  primed = true;
+  if (filterTauUs == 0) {
+    filteredRate = rate;
+  } else {
+    int32_t alpha = (dtUs << Q16_SHIFT) / (filterTauUs + dtUs);
+    filteredRate += ((int64_t)(rate - filteredRate) * alpha) >> Q16_SHIFT;
+  }
+
+  int64_t limit = (int64_t)outputLimit << Q16_SHIFT;
+  int64_t p = (int64_t)kp * error;
+  int64_t d = ((int64_t)kd * filteredRate) >> Q16_SHIFT;
+  int64_t f = ((int64_t)kff * (speed * error)) >> Q16_SHIFT;
+
+  // I: conditional integration against the unclamped output
+  int64_t i = 0;
+  if (ki == 0) {
+    integral = 0;
+  } else {
+    int64_t candidate =
+        clamp64(integral + (int64_t)error * ticks, maxIntegral);
+    int64_t trial = p + d + f + (((int64_t)ki * candidate) >> Q16_SHIFT);
+    bool windingUp = (trial > limit && error > 0) || (trial < -limit && error < 0);
+    if (!windingUp) integral = candidate;
+    i = ((int64_t)ki * integral) >> Q16_SHIFT;
+  }
+
+  pTerm = clamp64(p, INT32_MAX);
+  iTerm = clamp64(i, INT32_MAX);
+  dTerm = clamp64(d, INT32_MAX);
+  fTerm = clamp64(f, INT32_MAX);
+
+  int64_t output = clamp64(p + i + d + f, limit);
+  return (int)(output / 65536); // Truncates toward zero, like PIDController
+}
@@ -0,0 +1,58 @@
+#ifndef FIXED_PID_H
+#define FIXED_PID_H
+
+#include <Arduino.h>
+#include "Config.h"
+
+// Q16.16 fixed-point line PID (pid.mode = PID_MODE_FIXED). Same gains as
+// PIDController: I and D are normalised to the nominal control period, so
+// at exactly CONTROL_PERIOD_US both give the same P/I/D, and a late or
+// early tick is weighted by its measured dt instead.
+// - Anti-windup: the integral only grows while the output is unsaturated
+//   (or when it pulls out of saturation), and is bounded by the limit.
+// - The derivative is low-passed (first order, PID_D_FILTER_US).
+// - Speed feedforward: kff * speed * error / 1000. The correction needed
+//   to hold a curve grows with speed, P alone leaves a growing error.
+class FixedPID {
+public:
+  FixedPID(float kp, float ki, float kd);
+
+  void setTunings(float kp, float ki, float kd);
+  void setFeedforward(float kff);
+  void setOutputLimit(int limit);          // |output| bound
+  void setDerivativeFilter(uint32_t tauUs); // 0 disables the filter
+  void reset();                             // Before (re)starting to follow
+
+  // error: position - centre; dtUs: measured time since the last call;
+  // speed: base speed the correction is applied around
+  int compute(int error, uint32_t dtUs, int speed);
+
+  // Contributions of the last compute() call (for telemetry)
+  float getPTerm() { return pTerm / 65536.0f; }
+  float getITerm() { return iTerm / 65536.0f; }
+  float getDTerm() { return dTerm / 65536.0f; }
+  float getFTerm() { return fTerm / 65536.0f; }
+
+private:
+  void updateIntegralLimit();
+
+  int32_t kp;  // Q16
+  int32_t ki;
+  int32_t kd;
+  int32_t kff;            // Q32 of kff / 1000
+  int32_t outputLimit;
+  uint32_t filterTauUs;
+
+  int64_t integral;       // Q16, error x nominal ticks
+  int64_t maxIntegral;
+  int32_t lastError;
+  int32_t filteredRate;   // Q16, error change per nominal tick
+  bool primed;            // lastError is valid
+
+  int32_t pTerm;          // Q16 output units
+  int32_t iTerm;
+  int32_t dTerm;
+  int32_t fTerm;
+};
+
+#endif
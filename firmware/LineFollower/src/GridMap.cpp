@@ -0,0 +1,68 @@
+#include "GridMap.h"
+#include "Storage.h"
+
+#define GRID_MAP_MAGIC 0x4D47 // "GM"
+#define GRID_MAP_VERSION 1
+
+static_assert(GRID_NODES <= 64, "node indices are int8_t, states uint8_t");
+
+static const char LETTERS[] = "URDL";
+
+bool parseDirection(const char *text, Direction &dir) {
+  if (!text || !text[0] || text[1]) return false;
+  const char *found = strchr(LETTERS, text[0]);
+  if (!found) return false;
+  dir = (Direction)(found - LETTERS);
+  return true;
+}
+
+char directionLetter(Direction dir) { return dir < DIR_NONE ? LETTERS[dir] : '-'; }
+
+GridMap::GridMap() { clear(); }
+
+bool GridMap::load() {
+  // The record holds no size of its own: a new grid changes the length
+  return loadRecord(EEPROM_MAP_ADDR, GRID_MAP_MAGIC, GRID_MAP_VERSION, exits,
+                    sizeof(exits));
+}
+
+void GridMap::save() {
+  saveRecord(EEPROM_MAP_ADDR, GRID_MAP_MAGIC, GRID_MAP_VERSION, exits,
+             sizeof(exits));
+}
+
+void GridMap::clear() { memset(exits, 0, sizeof(exits)); }
+
+int8_t GridMap::neighbor(uint8_t node, Direction dir) {
+  uint8_t x = nodeX(node), y = nodeY(node);
+  switch (dir) {
+  case DIR_UP:
+    return y + 1 < GRID_ROWS ? nodeAt(x, y + 1) : -1;
+  case DIR_RIGHT:
+    return x + 1 < GRID_COLS ? nodeAt(x + 1, y) : -1;
+  case DIR_DOWN:
+    return y > 0 ? nodeAt(x, y - 1) : -1;
+  case DIR_LEFT:
+    return x > 0 ? nodeAt(x - 1, y) : -1;
+  default:
+    return -1;
+  }
+}
+
+bool GridMap::addEdge(uint8_t node, Direction dir) {
+  int8_t other = neighbor(node, dir);
+  if (other < 0) return false;
+  exits[node] |= 1 << dir;
+  exits[other] |= 1 << rotate(dir, 2);
+  return true;
+}
+
+uint8_t GridMap::getEdgeCount() const {
+  uint8_t count = 0;
+  for (uint8_t node = 0; node < GRID_NODES; node++) {
+    // Each segment once, from its lower/left end
+    if (exits[node] & (1 << DIR_UP)) count++;
+    if (exits[node] & (1 << DIR_RIGHT)) count++;
+  }
+  return count;
+}
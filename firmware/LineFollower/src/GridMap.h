@@ -0,0 +1,50 @@
+#ifndef GRID_MAP_H
+#define GRID_MAP_H
+
+#include <Arduino.h>
+#include "Config.h"
+
+// Headings on the grid, clockwise; relative turns use DIR_LEFT/DIR_RIGHT
+enum Direction { DIR_UP, DIR_RIGHT, DIR_DOWN, DIR_LEFT, DIR_NONE };
+
+#define GRID_NODES (GRID_COLS * GRID_ROWS)
+
+// Quarter turns clockwise (negative: anticlockwise)
+inline Direction rotate(Direction heading, int8_t quarters) {
+  return (Direction)((heading + quarters + 4) & 3);
+}
+
+// "U", "R", "D", "L"
+bool parseDirection(const char *text, Direction &dir);
+char directionLetter(Direction dir);
+
+// Which segments join the grid nodes, one exit bit per heading and node.
+// Learned from the segments the cart drives (Navigator) or declared by the
+// host (MAP:EDGE); RAM only until save().
+class GridMap {
+public:
+  GridMap();
+
+  bool load();
+  void save();
+  void clear();
+
+  static uint8_t nodeAt(uint8_t x, uint8_t y) { return y * GRID_COLS + x; }
+  static uint8_t nodeX(uint8_t node) { return node % GRID_COLS; }
+  static uint8_t nodeY(uint8_t node) { return node / GRID_COLS; }
+  // Next node that way, -1 off the grid
+  static int8_t neighbor(uint8_t node, Direction dir);
+
+  bool hasEdge(uint8_t node, Direction dir) const {
+    return exits[node] & (1 << dir);
+  }
+  uint8_t getExits(uint8_t node) const { return exits[node]; }
+  // Both ends; false off the grid
+  bool addEdge(uint8_t node, Direction dir);
+  uint8_t getEdgeCount() const;
+
+private:
+  uint8_t exits[GRID_NODES];
+};
+
+#endif
@@ -0,0 +1,72 @@
+#include "IterativeLearner.h"
+
+IterativeLearner::IterativeLearner() {
+  setGains(ILC_GAIN, ILC_FORGET);
+  clear();
+}
+
+void IterativeLearner::setGains(float gain, float forget) {
+  gainQ8 = (int32_t)(gain * 16 * 256 + 0.5f);
+  forgetQ8 = (int32_t)(forget * 256 + 0.5f);
+}
+
+void IterativeLearner::clear() {
+  memset(profiles, 0, sizeof(profiles));
+  segment = -1;
+  output = 0;
+}
+
+int IterativeLearner::update(TrackMemory &track, int error) {
+  output = 0;
+  if (!track.isSynced() || track.isLearning()) {
+    segment = -1;
+    return 0;
+  }
+  uint8_t index = track.getSegmentIndex();
+  if (segment != index) {
+    segment = index;
+    memset(errorSum, 0, sizeof(errorSum));
+    memset(samples, 0, sizeof(samples));
+  }
+  uint32_t length = (uint32_t)track.getSegment(index).travel * 100;
+  uint32_t travel = track.getTravel();
+  if (length == 0 || travel >= length) return 0; // Past the learned end
+
+  // Position in bins, Q8
+  uint32_t at = (uint32_t)((uint64_t)travel * ILC_BINS * 256 / length);
+  uint8_t bin = at >> 8;
+  int32_t frac = at & 0xFF;
+  errorSum[bin] += error;
+  if (samples[bin] < UINT16_MAX) samples[bin]++;
+
+  const int16_t *profile = profiles[index];
+  int32_t next = bin + 1 < ILC_BINS ? profile[bin + 1] : profile[bin];
+  int32_t sixteenths = (profile[bin] * (256 - frac) + next * frac) / 256;
+  output = sixteenths / 16;
+  return output;
+}
+
+void IterativeLearner::nodeReached(TrackMemory &track) {
+  uint8_t count = track.getSegmentCount();
+  // Confirmed only when the memory moved on to the segment after it
+  if (segment >= 0 && count > 0 && track.isSynced() &&
+      track.getSegmentIndex() == (segment + 1) % count) {
+    commit(segment);
+  }
+  segment = -1;
+}
+
+void IterativeLearner::commit(uint8_t segment) {
+  int32_t mean[ILC_BINS];
+  for (uint8_t b = 0; b < ILC_BINS; b++) {
+    mean[b] = samples[b] ? errorSum[b] / samples[b] : 0;
+  }
+  int16_t *profile = profiles[segment];
+  for (uint8_t b = 0; b < ILC_BINS; b++) {
+    uint8_t before = b > 0 ? b - 1 : b;
+    uint8_t after = b + 1 < ILC_BINS ? b + 1 : b;
+    int32_t error = (mean[before] + 2 * mean[b] + mean[after]) / 4;
+    int32_t value = (profile[b] * forgetQ8 + error * gainQ8) / 256;
+    profile[b] = constrain(value, -ILC_MAX * 16, ILC_MAX * 16);
+  }
+}
@@ -0,0 +1,52 @@
+#ifndef ITERATIVE_LEARNER_H
+#define ITERATIVE_LEARNER_H
+
+#include <Arduino.h>
+#include "Config.h"
+#include "TrackMemory.h"
+
+// Iterative learning control (ILC) on the learned lap: a feedforward
+// steering profile per TrackMemory segment, added to the line PID's
+// correction. The PID only reacts to the error a curve has already caused;
+// a lap later the profile steers into it beforehand.
+//
+// The profile is indexed by position: ILC_BINS steps over the segment's
+// learned travel, interpolated in between. While a segment is driven, the
+// line error is averaged per bin; once the next node confirms that it was
+// that segment, each bin is updated from lap k to lap k + 1 as
+//   u(b) = forget * u(b) + gain * e(b)
+// with e smoothed [1 2 1] over neighbouring bins. No lead for the steering
+// lag: bins are a fixed share of segments of any length, and on the long
+// slalom segment even one bin ahead overshoots. forget < 1 bounds what the
+// profile can build up and lets it follow a track that changes. Only the
+// segment being driven is buffered: the profiles plus one segment of sums.
+class IterativeLearner {
+public:
+  IterativeLearner();
+
+  // gain: speed units per count of mean error; forget: 0..1
+  void setGains(float gain, float forget);
+  void clear(); // All profiles to zero (the lap was relearned)
+
+  // Each following tick: the feedforward for here, 0 off the learned lap;
+  // records the tick's error
+  int update(TrackMemory &track, int error);
+  // After TrackMemory::nodeReached(): commits the segment just driven
+  void nodeReached(TrackMemory &track);
+
+  int getFeedforward() { return output; }
+
+private:
+  void commit(uint8_t segment);
+
+  int32_t gainQ8;   // Profile units (1/16 speed) per count of error, Q8
+  int32_t forgetQ8; // Q8
+
+  int16_t profiles[TRACK_MAX_SEGMENTS][ILC_BINS]; // 1/16 speed unit
+  int8_t segment;   // Being recorded, -1 for none
+  int32_t errorSum[ILC_BINS];
+  uint16_t samples[ILC_BINS];
+  int output;
+};
+
+#endif
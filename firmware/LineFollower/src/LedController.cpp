@@ -1,7 +1,10 @@
 #include "LedController.h"
 
+#define RESET_FILL_MS 1000 // Full matrix shown before the stop cross
+
 LedController::LedController() {
     isAnimating = false;
+    resetPending = false;
     lastAnimationTime = 0;
 }
 
@@ -17,6 +20,12 @@ void LedController::showPing() {
 }
 
 void LedController::update() {
+    // Second half of showReset(), without blocking the scheduler
+    if (resetPending && (millis() - lastAnimationTime >= RESET_FILL_MS)) {
+        resetPending = false;
+        showStop();
+    }
+
     // Keep the PING frame for 200ms, then revert to IDLE
     if (isAnimating && (millis() - lastAnimationTime > 2000)) {
          // Auto-clear after 2 seconds only for PING. 
@@ -138,6 +147,7 @@ void LedController::showReset() {
     }
     matrix.renderBitmap(frame, 8, 12);
     isAnimating = true;
+    resetPending = true;
     lastAnimationTime = millis();
 }
 
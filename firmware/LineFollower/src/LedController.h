@@ -16,13 +16,14 @@ public:
     void showLinePosition(uint16_t position); // Single dot moving
     void showStop();
     void showExplore();
-    void showReset();
+    void showReset(); // Full fill, then the stop cross from update()
     void showPacketReceived();
 
 private:
     ArduinoLEDMatrix matrix;
     unsigned long lastAnimationTime;
     bool isAnimating;
+    bool resetPending; // Full fill up, stop cross still to come
 };
 
 #endif
@@ -0,0 +1,127 @@
+#include "LineEstimator.h"
+
+#define LINE_MAX_POSITION ((SENSOR_COUNT - 1) * 1000L)
+
+// Distance (thousandths of a pitch) from a dark sensor to where the
+// reading falls to `level` on the way to its lighter neighbour
+static int32_t crossing(int32_t dark, int32_t light, int32_t level) {
+  if (dark <= light) return 500;
+  return (dark - level) * 1000 / (dark - light);
+}
+
+LineEstimator::LineEstimator() { reset(); }
+
+void LineEstimator::reset() {
+  estimate.position = LINE_MAX_POSITION / 2;
+  estimate.confidence = 0;
+  estimate.width = 0;
+  estimate.extrapolated = false;
+  tracking = false;
+  lastPosition = LINE_MAX_POSITION / 2;
+  lastUs = 0;
+  rate = 0;
+}
+
+const LineEstimate &LineEstimator::update(const uint16_t *values, bool gap,
+                                          uint32_t nowUs) {
+  if (gap) {
+    extrapolate(nowUs);
+    return estimate;
+  }
+
+  fit(values);
+
+  // Lateral rate from consecutive good fits, lightly low-passed
+  if (tracking && estimate.confidence >= LINE_MIN_CONFIDENCE) {
+    uint32_t dtUs = nowUs - lastUs;
+    if (dtUs > 0 && dtUs < 50000) {
+      int32_t instant =
+          (int32_t)((estimate.position - lastPosition) * 1000000LL / dtUs);
+      rate += (instant - rate) / 4;
+    }
+  } else {
+    rate = 0;
+  }
+  tracking = estimate.confidence >= LINE_MIN_CONFIDENCE;
+  lastPosition = estimate.position;
+  lastUs = nowUs;
+  return estimate;
+}
+
+void LineEstimator::fit(const uint16_t *values) {
+  uint8_t peak = 0;
+  uint16_t lowest = values[0];
+  for (uint8_t i = 1; i < SENSOR_COUNT; i++) {
+    if (values[i] > values[peak]) peak = i;
+    if (values[i] < lowest) lowest = values[i];
+  }
+
+  // The tape is wider than the pitch, so several sensors can saturate:
+  // take the flat top as the peak, from its first to its last sensor
+  uint8_t first = peak;
+  uint8_t last = peak;
+  int32_t top = values[peak] - LINE_PLATEAU_TOLERANCE;
+  while (first > 0 && values[first - 1] >= top) first--;
+  while (last < SENSOR_COUNT - 1 && values[last + 1] >= top) last++;
+
+  // Parabola through (first-1, peak, last+1); past an edge the floor is white
+  int32_t left = first > 0 ? values[first - 1] : 0;
+  int32_t centre = values[peak];
+  int32_t right = last < SENSOR_COUNT - 1 ? values[last + 1] : 0;
+  int32_t curvature = left - 2 * centre + right;
+  int32_t offset = 0; // Thousandths of a pitch, -500..500
+  if (curvature < 0) {
+    offset = 500 * (left - right) / curvature;
+    offset = constrain(offset, -500, 500);
+  }
+  int32_t position = (first + last) * 500L + offset;
+  estimate.position = constrain(position, 0, LINE_MAX_POSITION);
+  estimate.extrapolated = false;
+
+  // Width at half the peak contrast, with interpolated crossings
+  int32_t half = (centre + lowest) / 2;
+  int32_t leftEdge = 0;
+  int32_t rightEdge = LINE_MAX_POSITION;
+  for (int8_t i = first; i > 0; i--) {
+    if (values[i - 1] <= half) {
+      leftEdge = i * 1000L - crossing(values[i], values[i - 1], half);
+      break;
+    }
+  }
+  for (int8_t i = last; i < SENSOR_COUNT - 1; i++) {
+    if (values[i + 1] <= half) {
+      rightEdge = i * 1000L + crossing(values[i], values[i + 1], half);
+      break;
+    }
+  }
+  estimate.width = rightEdge - leftEdge;
+
+  // Contrast sets the confidence; a peak on the end sensor may be a line
+  // that is already mostly off the array
+  int32_t confidence = (centre - lowest) / 10;
+  if (first == 0 || last == SENSOR_COUNT - 1) confidence /= 2;
+  estimate.confidence = constrain(confidence, 0, 100);
+}
+
+void LineEstimator::extrapolate(uint32_t nowUs) {
+  estimate.extrapolated = true;
+  estimate.width = 0;
+  if (!tracking) {
+    estimate.confidence = 0;
+    return; // Keep whatever was last reported
+  }
+
+  uint32_t sinceUs = nowUs - lastUs;
+  uint32_t holdUs = LINE_GAP_HOLD_MS * 1000UL;
+  if (sinceUs >= holdUs) {
+    // Lost: stay on the side the line left by, as QTR does
+    estimate.position = lastPosition < LINE_MAX_POSITION / 2 ? 0 : LINE_MAX_POSITION;
+    estimate.confidence = 0;
+    return;
+  }
+
+  int32_t position = lastPosition + (int32_t)((int64_t)rate * sinceUs / 1000000);
+  estimate.position = constrain(position, 0, LINE_MAX_POSITION);
+  estimate.confidence =
+      (uint32_t)LINE_MIN_CONFIDENCE * (holdUs - sinceUs) / holdUs;
+}
@@ -0,0 +1,41 @@
+#ifndef LINE_ESTIMATOR_H
+#define LINE_ESTIMATOR_H
+
+#include <Arduino.h>
+#include "Config.h"
+
+struct LineEstimate {
+  uint16_t position;   // 0..(SENSOR_COUNT - 1) * 1000, same scale as QTR
+  uint8_t confidence;  // 0..100
+  uint16_t width;      // Dark span at half peak, 1000 = one sensor pitch
+  bool extrapolated;   // Gap: position predicted from recent motion
+};
+
+// Alternative to QTR's weighted average (line.estimator = 1). A parabola
+// through the darkest sensor and its neighbours gives the peak with
+// sub-sensor resolution and no pull toward the array centre when the line
+// reaches an edge. On a gap the last position is carried forward at the
+// last lateral rate for LINE_GAP_HOLD_MS, with confidence fading out, then
+// held at the edge the line left by.
+class LineEstimator {
+public:
+  LineEstimator();
+  void reset();
+
+  // values: calibrated 0..1000 (LineSensor::getRawValues());
+  // gap: LineSensor::getState() == STATE_GAP
+  const LineEstimate &update(const uint16_t *values, bool gap, uint32_t nowUs);
+  const LineEstimate &get() { return estimate; }
+
+private:
+  void fit(const uint16_t *values);
+  void extrapolate(uint32_t nowUs);
+
+  LineEstimate estimate;
+  bool tracking;          // lastPosition/rate are valid
+  int32_t lastPosition;
+  uint32_t lastUs;        // Last good fit
+  int32_t rate;           // Filtered, position units per second
+};
+
+#endif
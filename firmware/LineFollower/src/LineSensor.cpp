@@ -1,6 +1,26 @@
 #include "LineSensor.h"
+#include "Storage.h"
+
+#define CALIBRATION_MAGIC 0x4351 // "QC"
+#define CALIBRATION_VERSION 1
+#define CALIBRATION_MIN_SPAN 100 // Raw counts between white and black
+
+struct CalibrationRecord {
+    uint8_t sensorCount;
+    uint8_t reserved;
+    uint16_t minimum[SENSOR_COUNT];
+    uint16_t maximum[SENSOR_COUNT];
+};
 
 LineSensor::LineSensor() {
+    blackThreshold = LINE_BLACK_THRESHOLD;
+    calibrated = false;
+    groupReads = 0;
+    savedCalibrated = false;
+    scanning = false;
+    frameSeq = 0;
+    staleFrames = 0;
+    lastPosition = 0;
 }
 
 void LineSensor::begin() {
@@ -9,23 +29,157 @@ void LineSensor::begin() {
     
     // Optional: set emitter pin if used, otherwise they are always on or tied to VCC
     qtr.setEmitterPin(PIN_SENSOR_EMITTER); 
+    qtr.setSamplesPerSensor(SENSOR_OVERSAMPLE);
+
+    // Marking the data initialized keeps the library from allocating its own
+    qtr.calibrationOn.minimum = calMinimum;
+    qtr.calibrationOn.maximum = calMaximum;
+    qtr.calibrationOn.initialized = true;
+    qtr.resetCalibration();
+
+    if (SENSOR_ADC_SCAN) {
+        // Emitters stay on: the scan never goes through qtr.read()
+        qtr.emittersOn();
+        // VIN rides along for the Battery monitor
+        scanning = sensorScanBegin(SENSOR_PINS, SENSOR_COUNT,
+                                   SENSOR_SCAN_PERIOD_US, PIN_BATTERY_SENSE);
+        if (!scanning) Serial.println("Sensor scan unavailable, using QTR reads.");
+    }
 }
 
 void LineSensor::calibrate() {
     Serial.println("Calibrating sensors... Move sensor over line!");
-    
-    // Calibrate for approx 3 seconds (150 iters)
-    for (uint16_t i = 0; i < 150; i++) {
-        qtr.calibrate();
-        
-        // Print progress every 20 iterations
-        if (i % 20 == 0) Serial.print(".");
+    startCalibration();
+
+    // Same number of reads as 150 qtr.calibrate() calls (approx 3 seconds)
+    for (uint16_t i = 0; i < CALIBRATION_BOOT_READS; i++) {
+        calibrationStep();
+        if (scanning) delayMicroseconds(SENSOR_SCAN_PERIOD_US); // Fresh frame each step
+
+        // Print progress every 200 reads
+        if (i % 200 == 0) Serial.print(".");
     }
     Serial.println("\nCalibration Done.");
+    finishCalibration();
+}
+
+void LineSensor::startCalibration() {
+    memcpy(savedMinimum, calMinimum, sizeof(calMinimum));
+    memcpy(savedMaximum, calMaximum, sizeof(calMaximum));
+    savedCalibrated = calibrated;
+    qtr.resetCalibration();
+    groupReads = 0;
+}
+
+void LineSensor::calibrationStep() {
+    uint16_t values[SENSOR_COUNT];
+    if (!readRaw(values)) return;
+    for (uint8_t i = 0; i < SENSOR_COUNT; i++) {
+        if (groupReads == 0 || values[i] > groupMaximum[i]) groupMaximum[i] = values[i];
+        if (groupReads == 0 || values[i] < groupMinimum[i]) groupMinimum[i] = values[i];
+    }
+    if (++groupReads < CALIBRATION_GROUP) return;
+
+    // As qtr.calibrate(): only widen by values seen in the whole group
+    for (uint8_t i = 0; i < SENSOR_COUNT; i++) {
+        if (groupMinimum[i] > calMaximum[i]) calMaximum[i] = groupMinimum[i];
+        if (groupMaximum[i] < calMinimum[i]) calMinimum[i] = groupMaximum[i];
+    }
+    groupReads = 0;
+}
+
+static bool spanPlausible(const uint16_t *minimum, const uint16_t *maximum) {
+    // A sweep that never saw the line is useless even if it was saved
+    for (uint8_t i = 0; i < SENSOR_COUNT; i++) {
+        if (maximum[i] < minimum[i] + CALIBRATION_MIN_SPAN) return false;
+    }
+    return true;
+}
+
+bool LineSensor::isCalibrationPlausible() {
+    return spanPlausible(calMinimum, calMaximum);
+}
+
+void LineSensor::finishCalibration() {
+    calibrated = true;
+    filter.reset(); // Calibration reads bypass it; don't blend in stale history
+}
+
+void LineSensor::cancelCalibration() {
+    memcpy(calMinimum, savedMinimum, sizeof(calMinimum));
+    memcpy(calMaximum, savedMaximum, sizeof(calMaximum));
+    calibrated = savedCalibrated;
+}
+
+bool LineSensor::loadCalibration() {
+    CalibrationRecord record;
+    if (!loadRecord(EEPROM_CALIBRATION_ADDR, CALIBRATION_MAGIC,
+                    CALIBRATION_VERSION, &record, sizeof(record))) {
+        return false;
+    }
+    if (record.sensorCount != SENSOR_COUNT) return false;
+
+    if (!spanPlausible(record.minimum, record.maximum)) return false;
+
+    memcpy(calMinimum, record.minimum, sizeof(calMinimum));
+    memcpy(calMaximum, record.maximum, sizeof(calMaximum));
+    calibrated = true;
+    return true;
+}
+
+void LineSensor::saveCalibration() {
+    CalibrationRecord record;
+    record.sensorCount = SENSOR_COUNT;
+    record.reserved = 0;
+    memcpy(record.minimum, calMinimum, sizeof(calMinimum));
+    memcpy(record.maximum, calMaximum, sizeof(calMaximum));
+    saveRecord(EEPROM_CALIBRATION_ADDR, CALIBRATION_MAGIC, CALIBRATION_VERSION,
+               &record, sizeof(record));
+}
+
+bool LineSensor::readRaw(uint16_t *values) {
+    if (!scanning) {
+        qtr.read(values);
+        return true;
+    }
+
+    SensorFrame frame;
+    if (!sensorScanLatest(frame)) return false;
+    if (frame.seq == frameSeq) staleFrames++;
+    frameSeq = frame.seq;
+    memcpy(values, frame.values, sizeof(frame.values));
+    return true;
 }
 
 uint16_t LineSensor::readLine() {
-    return qtr.readLineBlack(trustedSensorValues);
+    // Same result as qtr.readLineBlack(), but with the filter in between
+    uint16_t raw[SENSOR_COUNT];
+    if (!readRaw(raw)) return lastPosition;
+    filter.apply(raw);
+
+    bool onLine = false;
+    uint32_t avg = 0;
+    uint16_t sum = 0;
+    for (uint8_t i = 0; i < SENSOR_COUNT; i++) {
+        int32_t value = 0;
+        if (calMaximum[i] > calMinimum[i]) {
+            value = ((int32_t)raw[i] - calMinimum[i]) * 1000 / (calMaximum[i] - calMinimum[i]);
+        }
+        trustedSensorValues[i] = constrain(value, 0, 1000);
+
+        if (trustedSensorValues[i] > 200) onLine = true;
+        if (trustedSensorValues[i] > 50) {
+            avg += (uint32_t)trustedSensorValues[i] * (i * 1000);
+            sum += trustedSensorValues[i];
+        }
+    }
+
+    if (!onLine) {
+        // Off the line: report the edge it was last seen on
+        return lastPosition < (SENSOR_COUNT - 1) * 1000 / 2 ? 0 : (SENSOR_COUNT - 1) * 1000;
+    }
+    lastPosition = avg / sum;
+    return lastPosition;
 }
 
 uint16_t* LineSensor::getRawValues() {
@@ -39,12 +193,12 @@ bool LineSensor::isNodeDetected() {
 }
 
 LineSensor::SensorState LineSensor::getState() {
-    // 1. Count black sensors (threshold > 600)
+    // 1. Count black sensors (threshold > 600 by default)
     int blackCount = 0;
     bool sensorIsBlack[SENSOR_COUNT];
     
     for (uint8_t i = 0; i < SENSOR_COUNT; i++) {
-        sensorIsBlack[i] = (trustedSensorValues[i] > 600);
+        sensorIsBlack[i] = (trustedSensorValues[i] > blackThreshold);
         if (sensorIsBlack[i]) blackCount++;
     }
 
@@ -4,14 +4,41 @@
 #include <Arduino.h>
 #include <QTRSensors.h>
 #include "Config.h"
+#include "SensorFilter.h"
+#include "SensorScan.h"
 
 class LineSensor {
 public:
     LineSensor();
     void begin();
-    void calibrate(); // Blocking calibration routine
+    void calibrate(); // Blocking calibration routine (starts from scratch)
+
+    // Incremental calibration, one raw read per step (see Calibrator). The
+    // previous calibration is kept aside until finish or cancel.
+    void startCalibration();
+    void calibrationStep();
+    bool isCalibrationPlausible(); // Every sensor saw both line and floor
+    void finishCalibration();
+    void cancelCalibration(); // Restores the previous calibration
+    const uint16_t *getCalibrationMinimum() { return calMinimum; }
+    const uint16_t *getCalibrationMaximum() { return calMaximum; }
+
+    // Calibration persistence (EEPROM, versioned + CRC)
+    bool loadCalibration(); // False if missing, corrupt or implausible
+    void saveCalibration();
+    bool isCalibrated() { return calibrated; }
     uint16_t readLine(); // Returns position (0 to 5000 for 6 sensors)
+    void setFilter(uint8_t median, uint8_t smooth) {
+        filter.setMedian(median);
+        filter.setSmoothing(smooth);
+    }
     uint16_t* getRawValues(); // For debugging
+
+    // Background scan (SENSOR_ADC_SCAN): sequence number of the frame the
+    // last read used, and reads that found no newer frame than the one before
+    bool isScanning() { return scanning; }
+    uint32_t getFrameSeq() { return frameSeq; }
+    uint32_t getStaleFrames() { return staleFrames; }
     
     // Debug / State Logic
     enum SensorState {
@@ -22,11 +49,34 @@ public:
     };
     
     SensorState getState();
+    void setBlackThreshold(uint16_t threshold) { blackThreshold = threshold; }
+    uint16_t getBlackThreshold() { return blackThreshold; }
     bool isNodeDetected(); // Keep for legacy compatibility if needed
 
 private:
     QTRSensors qtr;
+    bool scanning;
+    uint32_t frameSeq;
+    uint32_t staleFrames;
+    uint16_t lastPosition; // Edge memory, as QTRSensors keeps
+    SensorFilter filter;   // Raw readings, before calibration
+
+    bool readRaw(uint16_t *values); // False if no frame is available yet
     uint16_t trustedSensorValues[SENSOR_COUNT];
+    uint16_t blackThreshold;
+
+    // qtr.calibrationOn points here instead of at the library's heap arrays
+    uint16_t calMinimum[SENSOR_COUNT];
+    uint16_t calMaximum[SENSOR_COUNT];
+    bool calibrated;
+
+    // Incremental calibration state
+    uint16_t groupMinimum[SENSOR_COUNT];
+    uint16_t groupMaximum[SENSOR_COUNT];
+    uint8_t groupReads;
+    uint16_t savedMinimum[SENSOR_COUNT];
+    uint16_t savedMaximum[SENSOR_COUNT];
+    bool savedCalibrated;
 };
 
 #endif
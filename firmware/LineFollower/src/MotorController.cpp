@@ -1,18 +1,123 @@
 #include "MotorController.h"
 
-MotorController::MotorController() {}
+#if defined(ARDUINO_ARCH_RENESAS)
+// One store to the port's PCNTR3 (POSR sets in the low half, PORR clears in
+// the high half) instead of digitalWrite()'s pin table walk and PFS access
+static void writeDirectionPin(uint8_t pin, uint8_t level) {
+  uint32_t io = (uint32_t)g_pin_cfg[pin].pin;
+  R_PORT0_Type *port =
+      (R_PORT0_Type *)((uint32_t)R_PORT0 +
+                       ((io >> 8) & 0x0F) * ((uint32_t)R_PORT1 - (uint32_t)R_PORT0));
+  uint32_t mask = 1UL << (io & 0x0F);
+  port->PCNTR3 = level ? mask : mask << 16;
+}
+#else
+static void writeDirectionPin(uint8_t pin, uint8_t level) {
+  digitalWrite(pin, level);
+}
+#endif
+
+// 8-bit PWM units to compare counts
+static uint16_t toCounts(float pwm) {
+  if (pwm <= 0) return 0;
+  if (pwm >= 255) return MOTOR_PWM_PERIOD;
+  return (uint16_t)(pwm * MOTOR_PWM_PERIOD / 255 + 0.5f);
+}
+
+MotorController::MotorController()
+    : leftPwm(PIN_M1_EN), rightPwm(PIN_M2_EN) {
+  pwmReady = false;
+  supplyScale = 4096;
+  left.pinIN1 = PIN_M1_IN1;
+  left.pinIN2 = PIN_M1_IN2;
+  right.pinIN1 = PIN_M2_IN3;
+  right.pinIN2 = PIN_M2_IN4;
+  left.measured = false;
+  right.measured = false;
+  left.direction = right.direction = 2;
+  left.duty = right.duty = 0xFFFF; // Force the first write
+  left.output = right.output = 0;
+  setTuning(MAX_PWM_LIMIT, MIN_PWM_L, MIN_PWM_R, SPEED_FACTOR_L,
+            SPEED_FACTOR_R);
+}
+
+void MotorController::setTuning(int maxPwm, int minPwmL, int minPwmR,
+                                float factorL, float factorR) {
+  this->maxPwm = maxPwm;
+  this->minPwmL = minPwmL;
+  this->minPwmR = minPwmR;
+  this->factorL = factorL;
+  this->factorR = factorR;
+  buildTable(left, minPwmL, factorL);
+  buildTable(right, minPwmR, factorR);
+}
+
+void MotorController::setCurve(uint8_t side, const uint16_t *pwm) {
+  Channel &channel = side == MOTOR_LEFT ? left : right;
+  for (uint8_t i = 0; i < MOTOR_CURVE_POINTS; i++) {
+    channel.curve[i] = pwm[i] < MOTOR_PWM_PERIOD ? pwm[i] : MOTOR_PWM_PERIOD;
+  }
+  channel.measured = true;
+  buildTable(channel, side == MOTOR_LEFT ? minPwmL : minPwmR,
+             side == MOTOR_LEFT ? factorL : factorR);
+}
+
+void MotorController::clearCurves() {
+  left.measured = false;
+  right.measured = false;
+  setTuning(maxPwm, minPwmL, minPwmR, factorL, factorR);
+}
+
+void MotorController::buildTable(Channel &channel, int minPwm, float factor) {
+  uint16_t cap = toCounts(maxPwm);
+  channel.table[0] = 0;
+  for (int speed = 1; speed < 256; speed++) {
+    uint16_t counts;
+    if (channel.measured) {
+      // Piecewise linear between the measured breakpoints
+      int32_t scaled = (int32_t)speed * (MOTOR_CURVE_POINTS - 1);
+      uint8_t k = scaled / 255;
+      int32_t frac = scaled % 255;
+      if (k >= MOTOR_CURVE_POINTS - 1) {
+        counts = channel.curve[MOTOR_CURVE_POINTS - 1];
+      } else {
+        int32_t a = channel.curve[k];
+        int32_t b = channel.curve[k + 1];
+        counts = a + ((b - a) * frac + 127) / 255;
+      }
+    } else {
+      // Speed matching factor, then the deadband: 1..255 onto minPwm..maxPwm
+      int matched = speed * factor;
+      if (matched > 255) matched = 255;
+      counts = matched > 0
+                   ? toCounts(minPwm + (float)matched * (maxPwm - minPwm) / 255)
+                   : 0;
+    }
+    channel.table[speed] = counts < cap ? counts : cap;
+  }
+}
 
 void MotorController::begin() {
   // Left Motor
-  pinMode(PIN_M1_EN, OUTPUT);
   pinMode(PIN_M1_IN1, OUTPUT);
   pinMode(PIN_M1_IN2, OUTPUT);
 
   // Right Motor
-  pinMode(PIN_M2_EN, OUTPUT);
   pinMode(PIN_M2_IN3, OUTPUT);
   pinMode(PIN_M2_IN4, OUTPUT);
 
+  // Enable pins: raw compare counts of the 48 MHz GPT clock
+  pwmReady = leftPwm.begin(MOTOR_PWM_PERIOD, 0, true) &&
+             rightPwm.begin(MOTOR_PWM_PERIOD, 0, true);
+  if (!pwmReady) {
+    leftPwm.end();
+    rightPwm.end();
+    pinMode(PIN_M1_EN, OUTPUT);
+    pinMode(PIN_M2_EN, OUTPUT);
+  }
+
+  left.direction = right.direction = 2;
+  left.duty = right.duty = 0xFFFF;
   stop();
 }
 
@@ -27,52 +132,56 @@ void MotorController::turnLeft(int speed) { setSpeeds(-speed, speed); }
 void MotorController::turnRight(int speed) { setSpeeds(speed, -speed); }
 
 void MotorController::setSpeeds(int leftSpeed, int rightSpeed) {
-  // Apply Speed Matching Factors
-  leftSpeed = leftSpeed * SPEED_FACTOR_L;
-  rightSpeed = rightSpeed * SPEED_FACTOR_R;
-
-  // Apply Deadband Correction for Left Motor
-  if (leftSpeed > 0) {
-    leftSpeed = map(leftSpeed, 0, 255, MIN_PWM_L, MAX_PWM_LIMIT);
-  } else if (leftSpeed < 0) {
-    leftSpeed = map(leftSpeed, -255, 0, -MAX_PWM_LIMIT, -MIN_PWM_L);
-  }
-
-  // Apply Deadband Correction for Right Motor
-  if (rightSpeed > 0) {
-    rightSpeed = map(rightSpeed, 0, 255, MIN_PWM_R, MAX_PWM_LIMIT);
-  } else if (rightSpeed < 0) {
-    rightSpeed = map(rightSpeed, -255, 0, -MAX_PWM_LIMIT, -MIN_PWM_R);
-  }
-
-  setMotor(PIN_M1_EN, PIN_M1_IN1, PIN_M1_IN2, leftSpeed);
-  setMotor(PIN_M2_EN, PIN_M2_IN3, PIN_M2_IN4, rightSpeed);
+  setMotor(left, leftPwm, PIN_M1_EN, leftSpeed);
+  setMotor(right, rightPwm, PIN_M2_EN, rightSpeed);
 }
 
-void MotorController::setMotor(int pinPWM, int pinIN1, int pinIN2, int speed) {
+void MotorController::setMotor(Channel &channel, PwmOut &pwm, uint8_t pinPWM,
+                               int speed) {
   // constrain speed to -255 to 255
   if (speed > 255)
     speed = 255;
   if (speed < -255)
     speed = -255;
 
-  if (speed > 0) {
-    // Forward
-    digitalWrite(pinIN1, HIGH);
-    digitalWrite(pinIN2, LOW);
-    analogWrite(pinPWM, speed);
-  } else if (speed < 0) {
-    // Backward
-    digitalWrite(pinIN1, LOW);
-    digitalWrite(pinIN2, HIGH);
-    analogWrite(pinPWM, -speed); // PWM is always positive
-  } else {
-    // Stop (Coast or Brake? Let's use Brake: HIGH/HIGH or LOW/LOW)
-    // LOW/LOW is "Coast" (wheels spin free)
-    // HIGH/LOW + 0 PWM is Brake
-    // Let's use simple LOW/LOW for now to save power
-    digitalWrite(pinIN1, LOW);
-    digitalWrite(pinIN2, LOW);
-    analogWrite(pinPWM, 0);
+  uint32_t duty = channel.table[speed < 0 ? -speed : speed];
+  duty = (duty * supplyScale + 2048) >> 12;
+  if (duty > MOTOR_PWM_PERIOD) duty = MOTOR_PWM_PERIOD;
+  writeMotor(channel, pwm, pinPWM, speed > 0 ? 1 : -1, duty);
+}
+
+void MotorController::setDuties(int32_t leftDuty, int32_t rightDuty) {
+  const int32_t limit = MOTOR_PWM_PERIOD;
+  leftDuty = constrain(leftDuty, -limit, limit);
+  rightDuty = constrain(rightDuty, -limit, limit);
+  writeMotor(left, leftPwm, PIN_M1_EN, leftDuty > 0 ? 1 : -1,
+             leftDuty < 0 ? -leftDuty : leftDuty);
+  writeMotor(right, rightPwm, PIN_M2_EN, rightDuty > 0 ? 1 : -1,
+             rightDuty < 0 ? -rightDuty : rightDuty);
+}
+
+void MotorController::writeMotor(Channel &channel, PwmOut &pwm, uint8_t pinPWM,
+                                 int8_t direction, uint16_t duty) {
+  if (duty == 0) direction = 0;
+
+  if (direction != channel.direction) {
+    // Forward HIGH/LOW, backward LOW/HIGH, stopped LOW/LOW ("Coast", wheels
+    // spin free, saves power)
+    writeDirectionPin(channel.pinIN1, direction > 0 ? HIGH : LOW);
+    writeDirectionPin(channel.pinIN2, direction < 0 ? HIGH : LOW);
+    channel.direction = direction;
   }
+
+  if (duty != channel.duty) {
+    if (pwmReady) {
+      pwm.pulseWidth_raw(duty);
+    } else {
+      analogWrite(pinPWM, (uint32_t)duty * 255 / MOTOR_PWM_PERIOD);
+    }
+    channel.duty = duty;
+  }
+
+  channel.output =
+      direction * (int)(((uint32_t)duty * 255 + MOTOR_PWM_PERIOD / 2) /
+                        MOTOR_PWM_PERIOD);
 }
@@ -2,16 +2,23 @@
 #define MOTOR_CONTROLLER_H
 
 #include <Arduino.h>
+#include <pwm.h>
 #include "Config.h"
 
+enum MotorSide { MOTOR_LEFT, MOTOR_RIGHT };
+
+// Commands go through a per-motor lookup table (|speed| 0..255 -> GPT
+// compare counts), built from the deadband/factor tuning or from a measured
+// curve. Direction pins are only written when the direction changes, and
+// on the R4 straight to the port set/reset register.
 class MotorController {
 public:
     MotorController();
     void begin();
-    
+
     // speed: -255 to 255 (Negative for reverse)
     void setSpeeds(int leftSpeed, int rightSpeed);
-    
+
     // Convenience methods
     void stop();
     void forward(int speed);
@@ -19,8 +26,61 @@ public:
     void turnLeft(int speed);
     void turnRight(int speed);
 
+    // Deadband and matching (defaults from Config.h)
+    void setTuning(int maxPwm, int minPwmL, int minPwmR, float factorL,
+                   float factorR);
+
+    // Measured curve: MOTOR_CURVE_POINTS compare values (of MOTOR_PWM_PERIOD)
+    // for commands evenly spaced over 0..255 (0 itself always stops).
+    // Replaces the deadband/factor mapping of that side (still
+    // capped at maxPwm) until clearCurves().
+    void setCurve(uint8_t side, const uint16_t *pwm);
+    void clearCurves();
+
+    // Battery compensation, Q12 (4096 = 1.0): table duties are multiplied by
+    // it so a command keeps the same mean motor voltage as VIN sags. Limits
+    // like motor.max_pwm then hold in volts at battery.nominal; the result is
+    // only clamped to full duty. Raw setDuties() are not scaled.
+    void setSupplyScale(uint16_t scaleQ12) { supplyScale = scaleQ12; }
+    uint16_t getSupplyScale() { return supplyScale; }
+
+    // Signed compare counts straight to the bridge, bypassing the table
+    // (motor identification). Clamped to MOTOR_PWM_PERIOD, not to maxPwm.
+    void setDuties(int32_t leftDuty, int32_t rightDuty);
+
+    // Signed PWM actually applied (after the table), in 8-bit units
+    int getLeftOutput() { return left.output; }
+    int getRightOutput() { return right.output; }
+
 private:
-    void setMotor(int pinPWM, int pinIN1, int pinIN2, int speed);
+    struct Channel {
+        uint8_t pinIN1;
+        uint8_t pinIN2;
+        int8_t direction; // As last written: 1, -1, 0 (coast); 2 = unknown
+        uint16_t duty;    // Compare value last written
+        int output;
+        bool measured;
+        uint16_t curve[MOTOR_CURVE_POINTS];
+        uint16_t table[256];
+    };
+
+    void buildTable(Channel &channel, int minPwm, float factor);
+    void setMotor(Channel &channel, PwmOut &pwm, uint8_t pinPWM, int speed);
+    void writeMotor(Channel &channel, PwmOut &pwm, uint8_t pinPWM,
+                    int8_t direction, uint16_t duty);
+
+    Channel left;
+    Channel right;
+    PwmOut leftPwm;
+    PwmOut rightPwm;
+    bool pwmReady; // GPT running; otherwise analogWrite() at 8 bit
+    uint16_t supplyScale;
+
+    int maxPwm;
+    int minPwmL;
+    int minPwmR;
+    float factorL;
+    float factorR;
 };
 
 #endif
@@ -0,0 +1,329 @@
+#include "MotorIdentifier.h"
+#include "Storage.h"
+
+#define MOTOR_ID_MAGIC 0x4D49 // "IM"
+#define MOTOR_ID_VERSION 1
+
+// Range searched for the wheel time constant (s)
+#define FIT_TAU_MIN 0.001f
+#define FIT_TAU_MAX 1.0f
+
+// Position counts per sensor pitch
+#define PITCH 1000
+
+struct MotorIdRecord {
+  uint16_t period; // MOTOR_PWM_PERIOD the curves are in
+  uint16_t reserved;
+  MotorIdentifier::Model models[2];
+  uint16_t curves[2][MOTOR_CURVE_POINTS];
+};
+
+// 8-bit PWM units to compare counts
+static int32_t pwmToCounts(int32_t pwm) {
+  return pwm * (int32_t)MOTOR_PWM_PERIOD / 255;
+}
+
+MotorIdentifier::MotorIdentifier(MotorController &motors) : motors(motors) {
+  state = ID_IDLE;
+  phase = PHASE_SETTLE;
+  progress = 0;
+  phaseStart = 0;
+  side = MOTOR_LEFT;
+  step = 0;
+  testsDone = 0;
+  maxDuty = 0;
+  direction = 1;
+  origin = 0;
+  home = 0;
+  homeSet = false;
+  marks = 0;
+  measured = false;
+  memset(models, 0, sizeof(models));
+  memset(curves, 0, sizeof(curves));
+}
+
+bool MotorIdentifier::load() {
+  MotorIdRecord record;
+  if (!loadRecord(EEPROM_MOTOR_ADDR, MOTOR_ID_MAGIC, MOTOR_ID_VERSION, &record,
+                  sizeof(record))) {
+    return false;
+  }
+  // Curves measured at another PWM frequency do not carry over
+  if (record.period != MOTOR_PWM_PERIOD) return false;
+
+  memcpy(models, record.models, sizeof(models));
+  memcpy(curves, record.curves, sizeof(curves));
+  motors.setCurve(MOTOR_LEFT, curves[MOTOR_LEFT]);
+  motors.setCurve(MOTOR_RIGHT, curves[MOTOR_RIGHT]);
+  measured = true;
+  return true;
+}
+
+void MotorIdentifier::clear() {
+  if (state == ID_RUNNING) finish(false);
+  motors.clearCurves();
+  invalidateRecord(EEPROM_MOTOR_ADDR);
+  measured = false;
+  memset(models, 0, sizeof(models));
+  memset(curves, 0, sizeof(curves));
+}
+
+void MotorIdentifier::start(unsigned long now, int maxPwm) {
+  maxDuty = pwmToCounts(maxPwm);
+  side = MOTOR_LEFT;
+  step = 0;
+  testsDone = 0;
+  progress = 0;
+  threshold[MOTOR_LEFT] = threshold[MOTOR_RIGHT] = -1;
+  homeSet = false;
+  state = ID_RUNNING;
+  begin(PHASE_SETTLE, now);
+}
+
+void MotorIdentifier::begin(Phase next, unsigned long now) {
+  phase = next;
+  phaseStart = now;
+  if (next == PHASE_SETTLE) drive(0);
+}
+
+void MotorIdentifier::drive(int32_t duty) {
+  if (side == MOTOR_LEFT) {
+    motors.setDuties(duty, 0);
+  } else {
+    motors.setDuties(0, duty);
+  }
+}
+
+void MotorIdentifier::update(unsigned long now, uint16_t position, bool onLine) {
+  if (state != ID_RUNNING) return;
+  if (!onLine) {
+    finish(false); // Only meaningful with the line under the array
+    return;
+  }
+
+  unsigned long elapsed = now - phaseStart;
+  int32_t travel = direction * ((int32_t)position - origin);
+
+  switch (phase) {
+  case PHASE_SETTLE:
+    if (elapsed < MOTORID_SETTLE_MS) break;
+    origin = position;
+    if (!homeSet) {
+      home = position;
+      homeSet = true;
+    }
+    if (step >= MOTORID_STEPS) {
+      if (!finishMotor()) {
+        finish(false);
+        return;
+      }
+      if (side == MOTOR_RIGHT) {
+        finish(buildCurves());
+        return;
+      }
+      side = MOTOR_RIGHT;
+      step = 0;
+    }
+    if (threshold[side] < 0) {
+      begin(PHASE_RAMP, now);
+    } else {
+      // Steps evenly from just above the threshold up to motor.max_pwm
+      int32_t low = threshold[side] + pwmToCounts(MOTORID_STEP_MARGIN);
+      if (low >= maxDuty) {
+        finish(false); // No room between start and the PWM limit
+        return;
+      }
+      stepDuty[side][step] =
+          low + (maxDuty - low) * step / (MOTORID_STEPS - 1);
+      marks = 0;
+      begin(PHASE_STEP, now);
+      drive(stepDuty[side][step]);
+    }
+    break;
+
+  case PHASE_RAMP: {
+    int32_t ramp = (int32_t)((uint32_t)elapsed * MOTORID_RAMP_RATE *
+                             MOTOR_PWM_PERIOD / 255000UL);
+    if (ramp > maxDuty) {
+      finish(false); // Never moved
+      return;
+    }
+    drive(ramp);
+    int32_t moved = (int32_t)position - origin;
+    if (abs(moved) >= MOTORID_MOVE) {
+      direction = moved > 0 ? 1 : -1;
+      threshold[side] = ramp;
+      testsDone++;
+      begin(PHASE_RETURN, now);
+    }
+    break;
+  }
+
+  case PHASE_STEP:
+    if (travel >= MOTORID_MARK + marks * PITCH) {
+      markMs[marks++] = elapsed;
+      if (marks == 3) {
+        fitStep();
+        step++;
+        testsDone++;
+        begin(PHASE_RETURN, now);
+      }
+    } else if (travel <= -MOTORID_MOVE || elapsed >= MOTORID_STEP_MS) {
+      finish(false); // Turning the wrong way or too slowly
+      return;
+    }
+    break;
+
+  case PHASE_RETURN:
+    if (direction * ((int32_t)position - home) <= -PITCH) {
+      begin(PHASE_SETTLE, now);
+    } else if (elapsed >= MOTORID_RETURN_MS) {
+      finish(false);
+      return;
+    } else {
+      // Same wheel backwards, well above the start threshold
+      drive(-(threshold[side] + maxDuty) / 2);
+    }
+    break;
+  }
+
+  progress = testsDone * 100 / (2 * (1 + MOTORID_STEPS));
+}
+
+// Line travel of a first-order wheel t seconds after a unit step
+static float firstOrder(float t, float tau) {
+  return t - tau * (1 - expf(-t / tau));
+}
+
+void MotorIdentifier::fitStep() {
+  // The marks are a pitch apart, so F(t3) - F(t2) = F(t2) - F(t1): solve
+  // for tau (bisection, geometric), then v from the two pitches
+  float t1 = markMs[0] / 1000.0f;
+  float t2 = markMs[1] / 1000.0f;
+  float t3 = markMs[2] / 1000.0f;
+  float lo = FIT_TAU_MIN, hi = FIT_TAU_MAX, tau;
+  if (t3 - 2 * t2 + t1 >= 0) {
+    tau = lo; // No longer speeding up over the marks
+  } else if (firstOrder(t3, hi) - 2 * firstOrder(t2, hi) + firstOrder(t1, hi) <= 0) {
+    tau = hi;
+  } else {
+    for (uint8_t i = 0; i < 24; i++) {
+      tau = sqrtf(lo * hi);
+      float h = firstOrder(t3, tau) - 2 * firstOrder(t2, tau) + firstOrder(t1, tau);
+      if (h < 0) lo = tau;
+      else hi = tau;
+    }
+    tau = sqrtf(lo * hi);
+  }
+  stepTau[side][step] = tau;
+  stepRate[side][step] = 2 * PITCH / (firstOrder(t3, tau) - firstOrder(t1, tau));
+}
+
+bool MotorIdentifier::finishMotor() {
+  Model &model = pendingModels[side];
+  const float *rate = stepRate[side];
+  if (rate[MOTORID_STEPS - 1] <= 0) return false;
+
+  // Gain: least-squares slope of rate over the step PWM (8-bit)
+  float meanX = 0, meanY = 0, tau = 0;
+  uint8_t tauCount = 0;
+  for (uint8_t k = 0; k < MOTORID_STEPS; k++) {
+    meanX += stepDuty[side][k] * 255.0f / MOTOR_PWM_PERIOD;
+    meanY += rate[k];
+    if (rate[k] > 0) {
+      tau += stepTau[side][k];
+      tauCount++;
+    }
+  }
+  meanX /= MOTORID_STEPS;
+  meanY /= MOTORID_STEPS;
+  tau /= tauCount;
+  float sxy = 0, sxx = 0;
+  for (uint8_t k = 0; k < MOTORID_STEPS; k++) {
+    float x = stepDuty[side][k] * 255.0f / MOTOR_PWM_PERIOD - meanX;
+    sxy += x * (rate[k] - meanY);
+    sxx += x * x;
+  }
+  float gain = sxx > 0 ? sxy / sxx : 0;
+  if (gain <= 0) return false;
+
+  // The ramp is seen a time constant late: take that much PWM back off
+  int32_t lag = (int32_t)(tau * MOTORID_RAMP_RATE * MOTOR_PWM_PERIOD / 255);
+  threshold[side] = threshold[side] > lag ? threshold[side] - lag : 0;
+
+  model.threshold = threshold[side];
+  model.gain = gain < 65535 ? (uint16_t)gain : 65535;
+  model.tauMs = (uint16_t)(tau * 1000 + 0.5f);
+  return true;
+}
+
+bool MotorIdentifier::buildCurves() {
+  // Rate over duty per motor, from rest at the threshold; monotonic so it
+  // can be inverted. Commands span MOTORID_FLOOR..100 % of the slower
+  // motor's top rate, like the deadband mapping, which never asked a turning
+  // wheel for less than motor.min_*
+  float knotRate[2][MOTORID_STEPS + 1];
+  int32_t knotDuty[2][MOTORID_STEPS + 1];
+  float top = 0;
+  for (uint8_t s = 0; s < 2; s++) {
+    knotRate[s][0] = 0;
+    knotDuty[s][0] = threshold[s];
+    for (uint8_t k = 0; k < MOTORID_STEPS; k++) {
+      float r = stepRate[s][k];
+      knotRate[s][k + 1] = r > knotRate[s][k] ? r : knotRate[s][k];
+      knotDuty[s][k + 1] = stepDuty[s][k];
+    }
+    float sideTop = knotRate[s][MOTORID_STEPS];
+    if (s == 0 || sideTop < top) top = sideTop; // The slower motor sets 255
+  }
+  if (top <= 0) return false;
+
+  for (uint8_t s = 0; s < 2; s++) {
+    uint8_t k = 0;
+    for (uint8_t j = 0; j < MOTOR_CURVE_POINTS; j++) {
+      float target = top * (MOTORID_FLOOR + (100.0f - MOTORID_FLOOR) * j /
+                                                (MOTOR_CURVE_POINTS - 1)) / 100;
+      while (k < MOTORID_STEPS - 1 && knotRate[s][k + 1] < target) k++;
+      float r0 = knotRate[s][k], r1 = knotRate[s][k + 1];
+      int32_t d0 = knotDuty[s][k], d1 = knotDuty[s][k + 1];
+      float frac = r1 > r0 ? (target - r0) / (r1 - r0) : 0;
+      if (frac > 1) frac = 1;
+      pendingCurves[s][j] = (uint16_t)(d0 + (d1 - d0) * frac + 0.5f);
+    }
+  }
+  return true;
+}
+
+void MotorIdentifier::cancel() {
+  if (state != ID_RUNNING) return;
+  finish(false);
+}
+
+void MotorIdentifier::clearResult() {
+  if (state != ID_RUNNING) state = ID_IDLE;
+}
+
+void MotorIdentifier::finish(bool success) {
+  motors.stop();
+  if (!success) {
+    state = ID_FAILED;
+    return;
+  }
+
+  memcpy(models, pendingModels, sizeof(models));
+  memcpy(curves, pendingCurves, sizeof(curves));
+  motors.setCurve(MOTOR_LEFT, curves[MOTOR_LEFT]);
+  motors.setCurve(MOTOR_RIGHT, curves[MOTOR_RIGHT]);
+  measured = true;
+
+  // Motors are stopped: the flash stall is harmless
+  MotorIdRecord record;
+  record.period = MOTOR_PWM_PERIOD;
+  record.reserved = 0;
+  memcpy(record.models, models, sizeof(models));
+  memcpy(record.curves, curves, sizeof(curves));
+  saveRecord(EEPROM_MOTOR_ADDR, MOTOR_ID_MAGIC, MOTOR_ID_VERSION, &record,
+             sizeof(record));
+  progress = 100;
+  state = ID_DONE;
+}
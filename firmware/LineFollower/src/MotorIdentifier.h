@@ -0,0 +1,105 @@
+#ifndef MOTOR_IDENTIFIER_H
+#define MOTOR_IDENTIFIER_H
+
+#include <Arduino.h>
+#include "Config.h"
+#include "MotorController.h"
+
+// Motor characterisation (CMD:MOTOR_ID), non-blocking like the Calibrator.
+//
+// There are no encoders, so each wheel in turn pivots the cart about the
+// other (stopped) wheel with the array over a straight piece of line: the
+// line then moves across the array at a rate proportional to that wheel's
+// speed, the same for both sides. Per motor:
+//   - a slow PWM ramp until the line starts to move: start threshold;
+//   - MOTORID_STEPS steps from rest up to motor.max_pwm. The position is not
+//     linear in the heading between sensors (it flattens where a sensor
+//     saturates) but repeats every 1000 counts, so the first passes of
+//     start + MOTORID_MARK, + 1000 and + 2000 are exactly one sensor pitch
+//     apart. A first-order wheel, x(t) = v (t - tau (1 - e^(-t/tau))),
+//     through those three marks gives the steady rate v and the time
+//     constant tau;
+//   - after each test the same wheel backs up to a pitch behind the start
+//     heading, so the next step has two pitches of array ahead.
+// The rate tables of both motors are then inverted into command -> PWM
+// curves that are linear in speed and give both wheels the same speed for
+// the same command: MOTORID_FLOOR % of the slower motor's top speed at 1 (the
+// job motor.min_* did) up to all of it at 255. They replace motor.min_* / motor.factor_* in the MotorController
+// and are saved; anything implausible keeps the previous curves.
+class MotorIdentifier {
+public:
+  enum State {
+    ID_IDLE,
+    ID_RUNNING,
+    ID_DONE,   // Finished and saved, until clearResult()
+    ID_FAILED  // Cancelled, lost the line or implausible, until clearResult()
+  };
+
+  struct Model {
+    uint16_t threshold; // Compare counts where the wheel starts turning
+    uint16_t gain;      // Line rate (position counts/s) per 8-bit PWM step
+    uint16_t tauMs;     // Mean time constant over the steps
+  };
+
+  MotorIdentifier(MotorController &motors);
+
+  // Saved curves, if any, into the MotorController (boot)
+  bool load();
+  // Back to the motor.min_* / motor.factor_* mapping; forgets the record
+  void clear();
+
+  // maxPwm: motor.max_pwm (8-bit), the top step
+  void start(unsigned long now, int maxPwm);
+  // One call per control tick with that tick's line reading
+  void update(unsigned long now, uint16_t position, bool onLine);
+  void cancel();
+  void clearResult(); // DONE/FAILED -> IDLE once reported
+
+  State getState() { return state; }
+  bool isRunning() { return state == ID_RUNNING; }
+  uint8_t getProgress() { return progress; } // 0..100
+  bool hasCurves() { return measured; }
+  const Model &getModel(uint8_t side) { return models[side]; }
+  const uint16_t *getCurve(uint8_t side) { return curves[side]; }
+
+private:
+  enum Phase { PHASE_SETTLE, PHASE_RAMP, PHASE_STEP, PHASE_RETURN };
+
+  void begin(Phase next, unsigned long now);
+  void drive(int32_t duty);
+  void fitStep();
+  bool finishMotor();
+  bool buildCurves();
+  void finish(bool success);
+
+  MotorController &motors;
+  State state;
+  Phase phase;
+  uint8_t progress;
+  unsigned long phaseStart;
+
+  uint8_t side;     // MOTOR_LEFT / MOTOR_RIGHT under test
+  uint8_t step;     // Current step level
+  uint8_t testsDone;
+  int32_t maxDuty;  // Compare counts
+  int8_t direction; // Sign of the line motion when this wheel goes forward
+  int32_t origin;   // Line position at the start of a test
+  int32_t home;     // ... of the first test
+  bool homeSet;
+
+  unsigned long markMs[3]; // Since the step started
+  uint8_t marks;
+
+  int32_t threshold[2];
+  int32_t stepDuty[2][MOTORID_STEPS];
+  float stepRate[2][MOTORID_STEPS]; // Position counts/s
+  float stepTau[2][MOTORID_STEPS];  // s
+  Model pendingModels[2];           // This run, installed on success
+  uint16_t pendingCurves[2][MOTOR_CURVE_POINTS];
+
+  bool measured; // Installed curves, from a run or the saved record
+  Model models[2];
+  uint16_t curves[2][MOTOR_CURVE_POINTS];
+};
+
+#endif
@@ -1,28 +1,48 @@
 #include "Navigator.h"
 
-Navigator::Navigator() {
+Navigator::Navigator(GridMap &map) : map(map) {
   currentState = NAV_IDLE;
   isAutonomous = false;
   lastNodeTime = 0;
+  nodeCount = 0;
 
-  currentTurnState = TURN_IDLE;
-  turnStartTime = 0;
   targetTurnDirection = DIR_NONE;
+
+  route.goal = 0;
+  route.length = 0;
+  routeStep = 0;
+  routeState = ROUTE_IDLE;
+  routeFailure = "";
+  resetPose();
+
+  setTiming(NODE_COOLDOWN_MS);
+}
+
+void Navigator::setTiming(unsigned long nodeCooldown) {
+  nodeCooldownMs = nodeCooldown;
 }
 
 void Navigator::begin() { currentState = NAV_IDLE; }
 
-void Navigator::update(bool nodeDetected, bool lineDetected,
-                       unsigned long currentMillis) {
+void Navigator::update(bool nodeDetected, unsigned long currentMillis) {
   if (currentState == NAV_IDLE)
     return;
 
   // Debounce Node Detection
-  if (nodeDetected && (currentMillis - lastNodeTime > NODE_COOLDOWN_MS)) {
+  if (nodeDetected && (currentMillis - lastNodeTime > nodeCooldownMs)) {
     // Only trigger node if we are FOLLOWING (not already turning or stuck)
     if (currentState == NAV_FOLLOWING) {
       lastNodeTime = currentMillis;
-      
+      nodeCount++;
+      advancePose();
+
+      if (routeState == ROUTE_ACTIVE) {
+        // Planned decision: no stop, no round trip to the host
+        followRoute();
+      } else if (!queue.isEmpty()) {
+        // Sent ahead by the host: no stop either
+        takeDecision();
+      } else {
 #if ENABLE_WIFI
       // Hybrid Architecture: Stop and wait for Host (App) instruction
       // Even in "AUTO" mode, we wait for the App to send "GO_STRAIGHT" to keep logic consistent
@@ -34,36 +54,13 @@ void Navigator::update(bool nodeDetected, bool lineDetected,
       // Offline Mode: Self-manage
       handleNodeArrival();
 #endif
-    }
-  }
-
-  // --- TURN LOGIC UPDATE ---
-  if (currentState == NAV_TURNING) {
-    if (currentTurnState == TURN_BLIND) {
-      // Phase 1: Blind Wait
-      if (currentMillis - turnStartTime >
-          300) { // 300ms blind spin (adjust for 90 deg approx)
-        currentTurnState = TURN_CAPTURE;
-      }
-    } else if (currentTurnState == TURN_CAPTURE) {
-      // Phase 2: Wait for Center Sensor (Line Capture)
-      if (lineDetected) {
-        Serial.println("NAV: Turn Complete (Line Captured)");
-        currentState = NAV_FOLLOWING;
-        currentTurnState = TURN_IDLE;
-      }
-
-      // Timeout safety (1.5s max)
-      if (currentMillis - turnStartTime > 1500) {
-        Serial.println("NAV: Turn Timeout!");
-        currentState = NAV_FOLLOWING; // Try to recover
-        currentTurnState = TURN_IDLE;
       }
     }
   }
 }
 
 void Navigator::startAutonomous() {
+  atNode = false; // Parked on a node: on along the heading
   isAutonomous = true;
   currentState = NAV_FOLLOWING;
   Serial.println("NAV: Starting Autonomous Mode (Simple)");
@@ -84,35 +81,191 @@ void Navigator::handleNodeArrival() {
 
 Direction Navigator::getTurnDirection() { return targetTurnDirection; }
 
+void Navigator::endTurn(bool captured) {
+  if (currentState != NAV_TURNING) return;
+  if (captured) {
+    Serial.println("NAV: Turn Complete (Line Captured)");
+  } else {
+    Serial.println("NAV: Turn Timeout!");
+  }
+  currentState = NAV_FOLLOWING; // Captured or not: try to recover
+}
+
 void Navigator::turnLeft() {
+  heading = rotate(heading, -1);
+  atNode = false;
   currentState = NAV_TURNING;
-  currentTurnState = TURN_BLIND;
   targetTurnDirection = DIR_LEFT;
-  turnStartTime = millis();
 }
 
 void Navigator::turnRight() {
+  heading = rotate(heading, 1);
+  atNode = false;
   currentState = NAV_TURNING;
-  currentTurnState = TURN_BLIND;
   targetTurnDirection = DIR_RIGHT;
-  turnStartTime = millis();
 }
 
-void Navigator::goStraight() { currentState = NAV_FOLLOWING; }
+void Navigator::goStraight() {
+  atNode = false;
+  currentState = NAV_FOLLOWING;
+}
 
-void Navigator::stop() { currentState = NAV_IDLE; isAutonomous = false; }
+void Navigator::stop() {
+  cancelRoute();
+  queue.flush(); // Decided for a run that is over
+  currentState = NAV_IDLE;
+  isAutonomous = false;
+}
 
-void Navigator::processExternalCommand(String cmd) {
-  if (cmd == "GO_LEFT")
+void Navigator::processExternalCommand(const char *cmd) {
+  if (strcmp(cmd, "FLUSH") == 0) {
+    flushDecisions(); // Only the queue: what the cart is doing goes on
+    return;
+  }
+  cancelRoute(); // The host is driving again
+  if (strcmp(cmd, "GO_LEFT") == 0)
     turnLeft();
-  else if (cmd == "GO_RIGHT")
+  else if (strcmp(cmd, "GO_RIGHT") == 0)
     turnRight();
-  else if (cmd == "GO_STRAIGHT")
+  else if (strcmp(cmd, "GO_STRAIGHT") == 0)
     goStraight();
-  else if (cmd == "WAIT")
+  else if (strcmp(cmd, "WAIT") == 0)
     currentState = NAV_WAITING_HOST;
   // else if (cmd == "STOP") stop(); // Optional
 
   Serial.print("NAV: Executed Command: ");
   Serial.println(cmd);
 }
+
+void Navigator::setPose(uint8_t node, Direction heading) {
+  cancelRoute();
+  this->node = node;
+  this->heading = heading;
+  poseValid = true;
+  atNode = currentState == NAV_WAITING_HOST || currentState == NAV_AT_NODE;
+}
+
+void Navigator::resetPose() {
+  node = GridMap::nodeAt(GRID_START_X, GRID_START_Y);
+  heading = (Direction)GRID_START_HEADING;
+  poseValid = true;
+  atNode = false;
+}
+
+// One segment along the heading: that segment exists, learn it
+void Navigator::advancePose() {
+  atNode = true; // A node either way, for the decision queue
+  if (!poseValid) return;
+  int8_t next = GridMap::neighbor(node, heading);
+  if (next < 0) {
+    poseValid = false; // Off the grid: the pose was wrong
+    Serial.println("NAV: Pose lost (off the grid)");
+  } else {
+    map.addEdge(node, heading);
+    node = next;
+  }
+  if (!poseValid && routeState == ROUTE_ACTIVE) failRoute("pose lost");
+}
+
+bool Navigator::goTo(uint8_t goal) {
+  if (!poseValid) return false;
+  // The first decision is here if one is pending, else at the node ahead
+  uint8_t start = node;
+  if (!atNode) {
+    int8_t ahead = GridMap::neighbor(node, heading);
+    if (ahead < 0) return false;
+    start = ahead;
+  }
+  cancelRoute();
+  if (!planner.plan(map, start, heading, goal, route)) return false;
+  queue.flush(); // The route decides now
+  routeStep = 0;
+  routeState = ROUTE_ACTIVE;
+  routeFailure = "";
+  isAutonomous = true;
+
+  if (atNode) {
+    followRoute();
+  } else if (currentState == NAV_IDLE) {
+    currentState = NAV_FOLLOWING;
+  }
+  Serial.print("NAV: Route of ");
+  Serial.print(route.length);
+  Serial.println(" decisions");
+  return true;
+}
+
+void Navigator::followRoute() {
+  if (node == route.goal) {
+    // Park on the goal; the next route decides here
+    currentState = NAV_IDLE;
+    isAutonomous = false;
+    routeState = ROUTE_ARRIVED;
+    Serial.println("NAV: Route complete");
+    return;
+  }
+  if (routeStep >= route.length) {
+    failRoute("off route"); // A node was missed or seen twice
+    currentState = NAV_IDLE;
+    return;
+  }
+  Direction exit = (Direction)route.headings[routeStep++];
+  uint8_t turn = (exit - heading) & 3;
+  if (turn == 1) {
+    turnRight();
+  } else if (turn == 3) {
+    turnLeft();
+  } else {
+    goStraight();
+  }
+}
+
+void Navigator::cancelRoute() {
+  if (routeState == ROUTE_ACTIVE) failRoute("cancelled");
+}
+
+void Navigator::failRoute(const char *reason) {
+  routeFailure = reason;
+  routeState = ROUTE_FAILED;
+  Serial.print("NAV: Route failed: ");
+  Serial.println(reason);
+}
+
+void Navigator::clearRouteResult() {
+  if (routeState != ROUTE_ACTIVE) routeState = ROUTE_IDLE;
+}
+
+DecisionQueue::Result Navigator::queueDecisions(uint16_t firstSeq,
+                                                const uint8_t *decisions,
+                                                uint8_t count, bool replace) {
+  DecisionQueue::Result result =
+      replace ? queue.replace(firstSeq, decisions, count)
+              : queue.append(firstSeq, decisions, count);
+  if (result != DecisionQueue::QUEUE_OK) return result;
+  cancelRoute(); // The host is driving again
+  if (currentState == NAV_WAITING_HOST && atNode) takeDecision();
+  return result;
+}
+
+void Navigator::flushDecisions() { queue.flush(); }
+
+void Navigator::takeDecision() {
+  Decision decision;
+  if (!queue.take(decision)) return;
+  switch (decision) {
+  case DECISION_LEFT:
+    turnLeft();
+    break;
+  case DECISION_RIGHT:
+    turnRight();
+    break;
+  case DECISION_PARK:
+    // Like a route goal; the rest of the queue waits for CMD:AUTO
+    currentState = NAV_IDLE;
+    isAutonomous = false;
+    break;
+  default:
+    goStraight();
+    break;
+  }
+}
@@ -2,6 +2,9 @@
 #define NAVIGATOR_H
 
 #include "Config.h"
+#include "DecisionQueue.h"
+#include "GridMap.h"
+#include "RoutePlanner.h"
 #include <Arduino.h>
 
 enum NavState {
@@ -12,46 +15,103 @@ enum NavState {
   NAV_WAITING_HOST // Hybrid Arch: Pause for Host
 };
 
-enum TurnState {
-  TURN_IDLE,
-  TURN_BLIND,  // Phase 1: Blind rotation for X ms
-  TURN_CAPTURE // Phase 2: Sensor polling for line
+// NAV:GOTO progress
+enum RouteState {
+  ROUTE_IDLE,
+  ROUTE_ACTIVE,
+  ROUTE_ARRIVED, // Until clearRouteResult()
+  ROUTE_FAILED   // Pose lost or cancelled, until clearRouteResult()
 };
 
-enum Direction { DIR_UP, DIR_RIGHT, DIR_DOWN, DIR_LEFT, DIR_NONE };
-
+// Pose on the GridMap: the node last reached and the heading since. Each
+// node event moves one segment along the heading, teaching the map that
+// segment; turns rotate the heading. With a route the decision at each node
+// comes from it, so the cart drives through without waiting for the host;
+// without one, from the host's decision queue if it sent any ahead.
 class Navigator {
 public:
-  Navigator();
+  Navigator(GridMap &map);
   void begin();
-  void update(bool nodeDetected, bool lineDetected,
-              unsigned long currentMillis);
+  void update(bool nodeDetected, unsigned long currentMillis);
 
   void startAutonomous(); // Renamed from startExploration
   void stop();
 
   NavState getState();
+  uint16_t getNodeCount() { return nodeCount; } // Nodes taken, wraps
   Direction getTurnDirection(); 
+  // The turn is driven outside (TurnEngine): back to following once it
+  // found the new line (captured) or gave up
+  void endTurn(bool captured);
 
   // Command Interface
-  void processExternalCommand(String cmd); 
+  void processExternalCommand(const char *cmd);
+
+  // Timing (ms, defaults from Config.h)
+  void setTiming(unsigned long nodeCooldown);
 
   void turnLeft();
   void turnRight();
   void goStraight();
 
+  // Pose (GRID_START_* until set)
+  void setPose(uint8_t node, Direction heading);
+  void resetPose();
+  bool hasPose() { return poseValid; }
+  uint8_t getNode() { return node; }
+  Direction getHeading() { return heading; }
+
+  // Plans from the pose to `goal` and starts driving it (following, if
+  // idle). False without a pose or a known way there.
+  bool goTo(uint8_t goal);
+  void cancelRoute();
+  RouteState getRouteState() { return routeState; }
+  const char *getRouteFailure() { return routeFailure; }
+  uint8_t getRouteRemaining() { return route.length - routeStep; }
+  void clearRouteResult(); // ARRIVED/FAILED -> IDLE once reported
+
+  // Host decisions ahead of the cart (NAV:QUEUE / NAV:REPLACE, see
+  // DecisionQueue.h), one per node event while no route is active. Queueing
+  // ends a route and answers a node the cart is waiting at.
+  DecisionQueue::Result queueDecisions(uint16_t firstSeq,
+                                       const uint8_t *decisions, uint8_t count,
+                                       bool replace);
+  void flushDecisions();
+  uint16_t getDecisionAck() { return queue.getAck(); }
+  uint8_t getQueuedDecisions() { return queue.getCount(); }
+  uint16_t getNextDecisionSeq() { return queue.getNextSeq(); }
+
 private:
   NavState currentState;
   unsigned long lastNodeTime;
+  uint16_t nodeCount;
 
   // Turn Variables
-  TurnState currentTurnState;
-  unsigned long turnStartTime;
   Direction targetTurnDirection;
 
   bool isAutonomous;
 
+  unsigned long nodeCooldownMs;
+
   void handleNodeArrival();
+  void advancePose();
+  void followRoute();
+  void failRoute(const char *reason);
+  void takeDecision();
+
+  GridMap &map;
+  RoutePlanner planner;
+  uint8_t node;
+  Direction heading;
+  bool poseValid;
+  bool atNode; // Reached `node`, no decision taken there yet
+
+  Route route;
+  uint8_t routeStep;
+  RouteState routeState;
+  const char *routeFailure;
+
+  DecisionQueue queue;
 };
 
 #endif
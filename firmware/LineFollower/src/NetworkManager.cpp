@@ -1,7 +1,17 @@
 #include "NetworkManager.h"
 
 NetworkManager::NetworkManager() {
-  newMessageAvailable = false;
+  rxHead = 0;
+  rxCount = 0;
+  replyPort = 0;
+  rxPackets = 0;
+  rxDropped = 0;
+  rxTruncated = 0;
+  rxHighWater = 0;
+  txPackets = 0;
+  txDropped = 0;
+  sendTurn = false;
+  clearTx();
   lastPingTime = 0;
   state = DISCONNECTED;
   connectionAttempts = 0;
@@ -102,72 +112,174 @@ void NetworkManager::update() {
                state = DISCONNECTED;
                WiFi.disconnect();
            }
+           return; // That was this call's modem transaction
        }
        break;
   }
 #endif
 
-  // Only process UDP if Connected
-  if (state == CONNECTED || state == OFFLINE) { // Allow AP/Offline logic
-      // In OFFLINE we might want to skip UDP, but keeping it safe.
-      if (state == CONNECTED) {
-        int packetSize = Udp.parsePacket();
-        if (packetSize) {
-            int len = Udp.read(packetBuffer, 255);
-            if (len > 0) packetBuffer[len] = 0;
-            lastMessage = String(packetBuffer);
-            newMessageAvailable = true;
-            // Serial.println("Msg: " + lastMessage);
-        }
-      }
+  // Only process UDP if Connected; nothing queued is sent after a reconnect
+  if (state != CONNECTED) {
+    clearTx();
+    return;
   }
+
+  // Each parsePacket() and each send step is one modem round trip of a few
+  // hundred us, so do just one per call and alternate while sends wait
+  if (txCount > 0 && sendTurn) {
+    sendStep();
+  } else {
+    pollUdp();
+  }
+  sendTurn = !sendTurn;
 }    
 
+void NetworkManager::pollUdp() {
+  // Several packets can arrive between ticks (phones + the other cart):
+  // they wait in the modem and then in rxQueue, one read per update()
+  int packetSize = Udp.parsePacket();
+  if (packetSize <= 0) return;
+  rxPackets++;
+
+  if (rxCount >= UDP_RX_QUEUE_LEN) {
+    rxDropped++; // Keep the older ones; parsePacket() discards this one
+    return;
+  }
+
+  UdpDatagram &d = rxQueue[(rxHead + rxCount) % UDP_RX_QUEUE_LEN];
+  // Keep one byte for the terminator
+  int len = Udp.read(d.data, sizeof(d.data) - 1);
+  if (len <= 0) return;
+  if (packetSize > len) rxTruncated++;
+  d.data[len] = 0;
+  d.len = len;
+  d.ip = Udp.remoteIP();
+  d.port = Udp.remotePort();
+
+  rxCount++;
+  if (rxCount > rxHighWater) rxHighWater = rxCount;
+}
+
+UdpDatagram *NetworkManager::receive() {
+  if (rxCount == 0) return nullptr;
+  UdpDatagram *d = &rxQueue[rxHead];
+  rxHead = (rxHead + 1) % UDP_RX_QUEUE_LEN;
+  rxCount--;
+
+  replyIp = d->ip;
+  replyPort = d->port;
+  return d;
+}
+
+
+bool NetworkManager::enqueue(const IPAddress &ip, uint16_t port,
+                             const uint8_t *data, size_t len) {
+  size_t need = sizeof(UdpTxHeader) + len;
+  if (txCount == 0) clearTx();
+
+  uint16_t at;
+  if (txWrap == 0 && txTail + need <= sizeof(txBuffer)) {
+    at = txTail; // Room after the tail
+  } else if (txWrap == 0 && need <= txHead) {
+    txWrap = txTail; // Room at the front, before the oldest record
+    at = 0;
+  } else if (txWrap != 0 && txTail + need <= txHead) {
+    at = txTail;
+  } else {
+    txDropped++;
+    return false;
+  }
+
+  UdpTxHeader header;
+  header.len = len;
+  header.port = port;
+  for (uint8_t i = 0; i < 4; i++) header.ip[i] = ip[i];
+  memcpy(txBuffer + at, &header, sizeof(header));
+  memcpy(txBuffer + at + sizeof(header), data, len);
+  txTail = at + need;
+  txCount++;
+  return true;
+}
+
+void NetworkManager::sendStep() {
+  UdpTxHeader header;
+  memcpy(&header, txBuffer + txHead, sizeof(header));
+
+  // beginPacket(), write() and endPacket() are separate modem commands
+  switch (txStep) {
+    case 0:
+      if (Udp.beginPacket(IPAddress(header.ip[0], header.ip[1], header.ip[2],
+                                    header.ip[3]),
+                          header.port) != 1) {
+        txDropped++;
+        popTx();
+        return;
+      }
+      txStep = 1;
+      break;
+    case 1:
+      Udp.write(txBuffer + txHead + sizeof(header), header.len);
+      txStep = 2;
+      break;
+    default:
+      if (Udp.endPacket() == 1) {
+        txPackets++;
+      } else {
+        txDropped++;
+      }
+      popTx();
+      break;
+  }
+}
 
-bool NetworkManager::sendPacket(const String &message) {
+void NetworkManager::popTx() {
+  UdpTxHeader header;
+  memcpy(&header, txBuffer + txHead, sizeof(header));
+  txHead += sizeof(header) + header.len;
+  txStep = 0;
+  if (--txCount == 0) {
+    clearTx();
+  } else if (txWrap != 0 && txHead == txWrap) {
+    txHead = 0; // The rest starts over at the front
+    txWrap = 0;
+  }
+}
+
+void NetworkManager::clearTx() {
+  txHead = 0;
+  txTail = 0;
+  txWrap = 0;
+  txCount = 0;
+  txStep = 0;
+}
+
+bool NetworkManager::sendPacket(const char *message) {
   // For carts, we typically broadcast if we don't know the other IP,
   // or we could store the peer IP. For simplicity, we broadcast here
   // or assume a fixed IP scheme if in AP mode.
   // However, 255.255.255.255 works for local subnets usually.
 
   // Note: IPAddress(255, 255, 255, 255) is the broadcast address
-
-  if (Udp.beginPacket(IPAddress(255, 255, 255, 255), UDP_PORT) == 1) {
-    Udp.write(message.c_str());
-    Udp.endPacket();
-    return true;
-  }
-  return false;
+  return enqueue(IPAddress(255, 255, 255, 255), UDP_PORT,
+                 (const uint8_t *)message, strlen(message));
 }
 
-void NetworkManager::broadcast(const String &message) {
+void NetworkManager::broadcast(const char *message) {
   sendPacket(message); // sendPacket already targets 255.255.255.255
 }
 
-bool NetworkManager::respondToLastSender(const String &message) {
-  // Reply directly to the device that sent the last packet
-  if (Udp.beginPacket(Udp.remoteIP(), Udp.remotePort()) == 1) {
-    Udp.write(message.c_str());
-    Udp.endPacket();
-    return true;
-  }
-  return false;
-}
-
-void NetworkManager::sendTelemetry(int state, int sensors, float distance) {
-  // Formato JSON simple: {"s":state, "v":sensors, "d":dist}
-  String json = "{\"s\":" + String(state) + ",\"v\":" + String(sensors) +
-                ",\"d\":" + String(distance, 1) + "}";
-  sendPacket(json);
+bool NetworkManager::broadcast(const uint8_t *data, size_t len) {
+  return enqueue(IPAddress(255, 255, 255, 255), UDP_PORT, data, len);
 }
 
-bool NetworkManager::hasNewMessage() {
-  bool temp = newMessageAvailable;
-  newMessageAvailable = false;
-  return temp;
+bool NetworkManager::respondToLastSender(const char *message) {
+  // Reply directly to the device that sent the packet being handled
+  // (Udp.remoteIP() may already belong to a later queued packet)
+  if (replyPort == 0) return false;
+  return enqueue(replyIp, replyPort, (const uint8_t *)message,
+                 strlen(message));
 }
 
-String NetworkManager::getLastMessage() { return lastMessage; }
 
 
 bool NetworkManager::isConnected() {
@@ -6,6 +6,14 @@
 #include <WiFiS3.h>
 
 
+// One received packet, null-terminated, with its sender
+struct UdpDatagram {
+  char data[UDP_RX_MAX_PAYLOAD];
+  uint8_t len;
+  IPAddress ip;
+  uint16_t port;
+};
+
 class NetworkManager {
 public:
   enum ConnectionState {
@@ -17,22 +25,61 @@ public:
 
   NetworkManager();
   void begin(); // Now non-blocking
-  void update(); // Handles state machine
-  bool sendPacket(const String &message);
-  void broadcast(const String &message); // Explicit broadcast
-  bool respondToLastSender(const String &message);
-  String getLastMessage();
-  bool hasNewMessage();
-  void sendTelemetry(int nodeId, int sensorState, float distance);
+  // Handles the state machine, then polls for one packet or moves the send
+  // queue on by one step: never more than one modem transaction per call
+  void update();
+  // Sends are queued and go out from update(); false if the queue is full
+  bool sendPacket(const char *message);
+  void broadcast(const char *message); // Explicit broadcast
+  bool broadcast(const uint8_t *data, size_t len); // Binary frames
+  bool respondToLastSender(const char *message); // Sender of receive()
+  // Oldest queued datagram, or nullptr. Writable (for in-place parsing)
+  // and valid until the next receive()/update().
+  UdpDatagram *receive();
+  uint8_t getQueuedCount() { return rxCount; }
+
+  // Receive statistics since boot
+  uint32_t getRxPackets() { return rxPackets; }
+  uint32_t getRxDropped() { return rxDropped; }     // Queue was full
+  uint32_t getRxTruncated() { return rxTruncated; } // Longer than a slot
+  uint8_t getRxHighWater() { return rxHighWater; }
+  uint32_t getTxPackets() { return txPackets; }
+  uint32_t getTxDropped() { return txDropped; } // Queue full or send failed
   
   bool isConnected();
   bool isConnecting();
 
 private:
   WiFiUDP Udp;
-  char packetBuffer[255];
-  String lastMessage;
-  bool newMessageAvailable;
+  // Receive ring buffer, filled by update()
+  UdpDatagram rxQueue[UDP_RX_QUEUE_LEN];
+  uint8_t rxHead; // Next slot to hand out
+  uint8_t rxCount;
+  IPAddress replyIp;
+  uint16_t replyPort;
+
+  uint32_t rxPackets;
+  uint32_t rxDropped;
+  uint32_t rxTruncated;
+  uint8_t rxHighWater;
+
+  // Send queue: records of UdpTxHeader + payload, kept contiguous so each
+  // payload goes to Udp.write() in one piece. A record that does not fit at
+  // the end starts over at 0, and txWrap marks where the old data ends.
+  struct UdpTxHeader {
+    uint16_t len;
+    uint16_t port;
+    uint8_t ip[4];
+  };
+  uint8_t txBuffer[UDP_TX_BUFFER];
+  uint16_t txHead; // Oldest record
+  uint16_t txTail; // Next free byte
+  uint16_t txWrap; // 0 unless the tail has wrapped past txHead
+  uint8_t txCount;
+  uint8_t txStep;  // Of the head record: begin, write, end
+  bool sendTurn;   // update() alternates between polling and sending
+  uint32_t txPackets;
+  uint32_t txDropped;
   unsigned long lastPingTime;
   
   ConnectionState state;
@@ -41,6 +88,12 @@ private:
 
   void checkConnection();
   void printWifiStatus();
+  void pollUdp();
+  bool enqueue(const IPAddress &ip, uint16_t port, const uint8_t *data,
+               size_t len);
+  void sendStep();
+  void popTx();
+  void clearTx();
 };
 
 #endif
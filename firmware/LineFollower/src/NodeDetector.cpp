@@ -0,0 +1,115 @@
+#include "NodeDetector.h"
+
+NodeDetector::NodeDetector() {
+  eventCount = 0;
+  event.type = NODE_EVENT_NONE;
+  event.confidence = 0;
+  event.width = 0;
+  event.edgeUs = 0;
+  event.confirmUs = 0;
+  setBlackThreshold(LINE_BLACK_THRESHOLD);
+  reset();
+}
+
+void NodeDetector::setBlackThreshold(uint16_t threshold) {
+  enterThreshold = threshold > NODE_EARLY ? threshold - NODE_EARLY : 0;
+  exitThreshold =
+      enterThreshold > NODE_HYSTERESIS ? enterThreshold - NODE_HYSTERESIS : 0;
+}
+
+void NodeDetector::reset() {
+  for (uint8_t i = 0; i < SENSOR_COUNT; i++) black[i] = false;
+  lineFirst = -1;
+  lineLast = -1;
+  phase = PHASE_ARMED;
+  candidateType = NODE_EVENT_NONE;
+  edgeUs = 0;
+  clearSinceUs = 0;
+  clearing = false;
+}
+
+bool NodeDetector::update(const uint16_t *values, uint32_t nowUs) {
+  uint8_t count = 0;
+  uint8_t segments = 0;
+  int8_t first = -1;
+  int8_t last = -1;
+  for (uint8_t i = 0; i < SENSOR_COUNT; i++) {
+    black[i] = values[i] >= (black[i] ? exitThreshold : enterThreshold);
+    if (!black[i]) continue;
+    count++;
+    if (first < 0) first = i;
+    last = i;
+    if (i == 0 || !black[i - 1]) segments++;
+  }
+  bool plain = segments <= 1 && count <= NODE_LINE_MAX_BLACK;
+
+  // What this frame alone looks like
+  uint8_t type = NODE_EVENT_NONE;
+  if (segments >= 2) {
+    type = NODE_EVENT_FORK;
+  } else if (count >= NODE_MIN_BLACK) {
+    type = NODE_EVENT_NODE;
+  } else if (count >= NODE_MIN_BLACK - 1 && lineFirst >= 0 &&
+             first < lineFirst && last > lineLast) {
+    type = NODE_EVENT_NODE; // Widened both ways at once: a bar, not a curve
+  }
+
+  if (phase == PHASE_ARMED) {
+    if (type != NODE_EVENT_NONE) {
+      phase = PHASE_CANDIDATE;
+      candidateType = type;
+      edgeUs = nowUs;
+    } else if (count == 0) {
+      lineFirst = -1; // Nothing to grow from after a gap
+    } else if (plain) {
+      lineFirst = first;
+      lineLast = last;
+    }
+  } else if (phase == PHASE_CANDIDATE) {
+    if (type == NODE_EVENT_NONE) {
+      phase = PHASE_ARMED; // A blip, not a node
+    } else if (type == NODE_EVENT_NODE) {
+      candidateType = NODE_EVENT_NODE; // A fork that closes into a bar
+    }
+  } else {
+    // Latched: re-arm once the array has been back on a plain line a while
+    if (!plain) {
+      clearing = false;
+    } else if (!clearing) {
+      clearing = true;
+      clearSinceUs = nowUs;
+    } else if (nowUs - clearSinceUs >= NODE_CLEAR_MS * 1000UL) {
+      phase = PHASE_ARMED;
+      lineFirst = -1;
+    }
+  }
+
+  if (phase != PHASE_CANDIDATE || nowUs - edgeUs < NODE_CONFIRM_US) {
+    return false;
+  }
+
+  event.type = candidateType;
+  event.confidence = confidence(values, count);
+  event.width = count;
+  event.edgeUs = edgeUs;
+  event.confirmUs = nowUs;
+  eventCount++;
+  phase = PHASE_LATCHED;
+  clearing = false;
+  return true;
+}
+
+uint8_t NodeDetector::confidence(const uint16_t *values, uint8_t count) {
+  // Half for how much of the array is covered, half for how dark it is
+  if (count == 0) return 0;
+  uint32_t sum = 0;
+  for (uint8_t i = 0; i < SENSOR_COUNT; i++) {
+    if (black[i]) sum += values[i];
+  }
+  int32_t mean = sum / count;
+  int32_t contrast = 0;
+  if (enterThreshold < 1000 && mean > enterThreshold) {
+    contrast = (mean - enterThreshold) * 50 / (1000 - enterThreshold);
+  }
+  return constrain(count * 50 / SENSOR_COUNT + contrast, 0, 100);
+}
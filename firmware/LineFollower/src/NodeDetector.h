@@ -0,0 +1,67 @@
+#ifndef NODE_DETECTOR_H
+#define NODE_DETECTOR_H
+
+#include <Arduino.h>
+#include "Config.h"
+
+// Streaming node / fork classifier over the calibrated sensor frames.
+//
+// Each sensor turns black and white again with hysteresis, on a band set
+// below sensor.black so a bar is seen from its leading edge. A frame looks
+// like a node when the black run is wide (NODE_MIN_BLACK), or slightly
+// narrower but grown on both sides of where the line was; a curve only
+// slides the line sideways. Two separate black runs look like a fork. The
+// pattern must hold for NODE_CONFIRM_US before an event is emitted, stamped
+// with the leading edge; then the detector stays latched until the array
+// has seen a plain line (or nothing) for NODE_CLEAR_MS.
+
+enum NodeEventType {
+  NODE_EVENT_NONE,
+  NODE_EVENT_NODE, // Bar across the line
+  NODE_EVENT_FORK  // Line splits (LineSensor::STATE_COMPLEX)
+};
+
+struct NodeEvent {
+  uint8_t type;
+  uint8_t confidence; // 0..100
+  uint8_t width;      // Black sensors when confirmed
+  uint32_t edgeUs;    // micros() of the leading edge
+  uint32_t confirmUs; // micros() when the event was emitted
+};
+
+class NodeDetector {
+public:
+  NodeDetector();
+  void setBlackThreshold(uint16_t threshold); // sensor.black
+  void reset();
+
+  // One call per control tick; true when an event is emitted
+  bool update(const uint16_t *values, uint32_t nowUs);
+  const NodeEvent &getEvent() { return event; }
+  uint16_t getEventCount() { return eventCount; }
+  bool isInside() { return phase != PHASE_ARMED; } // On a (candidate) node
+
+private:
+  enum Phase { PHASE_ARMED, PHASE_CANDIDATE, PHASE_LATCHED };
+
+  uint16_t enterThreshold;
+  uint16_t exitThreshold;
+  bool black[SENSOR_COUNT];
+
+  // Bounds of the plain line in the last frame that showed one
+  int8_t lineFirst;
+  int8_t lineLast;
+
+  Phase phase;
+  uint8_t candidateType;
+  uint32_t edgeUs;
+  uint32_t clearSinceUs;
+  bool clearing;
+
+  NodeEvent event;
+  uint16_t eventCount;
+
+  uint8_t confidence(const uint16_t *values, uint8_t count);
+};
+
+#endif
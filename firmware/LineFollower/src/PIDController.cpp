@@ -8,6 +8,10 @@ PIDController::PIDController(float kp, float ki, float kd) {
     this->target = 2500; // Default center for QTR-8 (0-5000)
     this->lastError = 0;
     this->integral = 0;
+
+    this->pTerm = 0;
+    this->iTerm = 0;
+    this->dTerm = 0;
 }
 
 void PIDController::setTunings(float kp, float ki, float kd) {
@@ -33,7 +37,10 @@ int PIDController::compute(int error) {
     lastError = error;
     
     // PID Calculation
-    float output = (Kp * P) + (Ki * I) + (Kd * D);
+    pTerm = Kp * P;
+    iTerm = Ki * I;
+    dTerm = Kd * D;
+    float output = pTerm + iTerm + dTerm;
     
     return (int)output;
 }
@@ -10,6 +10,15 @@ public:
     int compute(int error);
     void setTarget(int target); // Usually 2500 (Center)
 
+    float getKp() { return Kp; }
+    float getKi() { return Ki; }
+    float getKd() { return Kd; }
+
+    // Contributions of the last compute() call (for telemetry)
+    float getPTerm() { return pTerm; }
+    float getITerm() { return iTerm; }
+    float getDTerm() { return dTerm; }
+
 private:
     float Kp;
     float Ki;
@@ -18,6 +27,10 @@ private:
     int target;
     int lastError;
     long integral;
+
+    float pTerm;
+    float iTerm;
+    float dTerm;
 };
 
 #endif
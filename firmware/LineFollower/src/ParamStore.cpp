@@ -0,0 +1,128 @@
+#include "ParamStore.h"
+#include "CommandParser.h"
+#include "Storage.h"
+
+#define PARAM_DEF_ENTRY(id, key, type, def, min, max) {key, type, def, min, max},
+static const ParamDef PARAM_DEFS[PARAM_COUNT] = {PARAM_TABLE(PARAM_DEF_ENTRY)};
+#undef PARAM_DEF_ENTRY
+
+#define PARAMS_MAGIC 0x5350 // "PS"
+#define PARAMS_VERSION 1
+
+struct ParamRecord {
+  uint16_t schema;
+  uint16_t count;
+  float values[PARAM_COUNT];
+};
+static_assert(EEPROM_PARAMS_ADDR + STORAGE_HEADER_SIZE + sizeof(ParamRecord) <=
+                  EEPROM_CALIBRATION_ADDR,
+              "params record runs into the calibration record");
+
+ParamStore::ParamStore() {
+  schema = 0;
+  dirty = false;
+  for (uint8_t i = 0; i < PARAM_COUNT; i++) {
+    values[i] = PARAM_DEFS[i].defaultValue;
+  }
+}
+
+void ParamStore::begin() {
+  schema = 0xFFFF;
+  for (uint8_t i = 0; i < PARAM_COUNT; i++) {
+    schema = crc16((const uint8_t *)PARAM_DEFS[i].key,
+                   strlen(PARAM_DEFS[i].key) + 1, schema);
+  }
+
+  if (load()) {
+    Serial.println("Params: loaded from EEPROM.");
+  } else {
+    resetDefaults();
+    dirty = false;
+    Serial.println("Params: no valid saved set, using defaults.");
+  }
+}
+
+bool ParamStore::set(uint8_t id, float value) {
+  if (id >= PARAM_COUNT) return false;
+  const ParamDef &def = PARAM_DEFS[id];
+  if (!(value >= def.minValue && value <= def.maxValue)) return false;
+
+  if (def.type == PARAM_INT) value = (float)lroundf(value);
+  if (values[id] != value) {
+    values[id] = value;
+    dirty = true;
+  }
+  return true;
+}
+
+int8_t ParamStore::find(const char *key) {
+  for (uint8_t i = 0; i < PARAM_COUNT; i++) {
+    if (strcmp(key, PARAM_DEFS[i].key) == 0) return i;
+  }
+  return -1;
+}
+
+const ParamDef &ParamStore::getDef(uint8_t id) { return PARAM_DEFS[id]; }
+
+bool ParamStore::load() {
+  ParamRecord record;
+  if (!loadRecord(EEPROM_PARAMS_ADDR, PARAMS_MAGIC, PARAMS_VERSION, &record,
+                  sizeof(record))) {
+    return false;
+  }
+  if (record.schema != schema || record.count != PARAM_COUNT) return false;
+
+  // Re-validate: ranges may have tightened since the set was saved
+  for (uint8_t i = 0; i < PARAM_COUNT; i++) {
+    values[i] = PARAM_DEFS[i].defaultValue;
+    set(i, record.values[i]);
+  }
+  dirty = false;
+  return true;
+}
+
+void ParamStore::save() {
+  ParamRecord record;
+  record.schema = schema;
+  record.count = PARAM_COUNT;
+  memcpy(record.values, values, sizeof(values));
+  saveRecord(EEPROM_PARAMS_ADDR, PARAMS_MAGIC, PARAMS_VERSION, &record,
+             sizeof(record));
+  dirty = false;
+}
+
+void ParamStore::resetDefaults() {
+  for (uint8_t i = 0; i < PARAM_COUNT; i++) {
+    if (values[i] != PARAM_DEFS[i].defaultValue) dirty = true;
+    values[i] = PARAM_DEFS[i].defaultValue;
+  }
+}
+
+static size_t formatNumber(char *buf, size_t len, uint8_t type, float value) {
+  return formatDecimal(buf, len, value, type == PARAM_INT ? 0 : 4);
+}
+
+size_t ParamStore::formatValue(uint8_t id, char *buf, size_t len) {
+  int n = snprintf(buf, len, "%s=", PARAM_DEFS[id].key);
+  if (n < 0 || (size_t)n >= len) return 0;
+  return n + formatNumber(buf + n, len - n, PARAM_DEFS[id].type, values[id]);
+}
+
+size_t ParamStore::formatList(char *buf, size_t len) {
+  size_t used = 0;
+  buf[0] = 0;
+  for (uint8_t i = 0; i < PARAM_COUNT; i++) {
+    const ParamDef &def = PARAM_DEFS[i];
+    // Worst case entry: key + 3 numbers; stop rather than cut one in half
+    if (used + strlen(def.key) + 40 > len) break;
+    if (used) buf[used++] = ';';
+    used += formatValue(i, buf + used, len - used);
+    used += snprintf(buf + used, len - used, "|%s|",
+                     def.type == PARAM_INT ? "i" : "f");
+    used += formatNumber(buf + used, len - used, def.type, def.minValue);
+    buf[used++] = '|';
+    used += formatNumber(buf + used, len - used, def.type, def.maxValue);
+    buf[used] = 0;
+  }
+  return used;
+}
@@ -0,0 +1,96 @@
+#ifndef PARAM_STORE_H
+#define PARAM_STORE_H
+
+#include <Arduino.h>
+#include "Config.h"
+
+enum ParamType {
+  PARAM_INT,
+  PARAM_FLOAT
+};
+
+// Runtime-tunable parameters. Config.h values are the defaults; the live
+// values can be changed over UDP (PARAM:SET) and persisted (PARAM:SAVE).
+//   X(id, key, type, default, min, max)
+#define PARAM_TABLE(X)                                                         \
+  X(PARAM_PID_KP, "pid.kp", PARAM_FLOAT, PID_KP, 0, 10)                       \
+  X(PARAM_PID_KI, "pid.ki", PARAM_FLOAT, PID_KI, 0, 1)                        \
+  X(PARAM_PID_KD, "pid.kd", PARAM_FLOAT, PID_KD, 0, 50)                       \
+  X(PARAM_PID_MODE, "pid.mode", PARAM_INT, PID_MODE, 0, 1)                    \
+  X(PARAM_PID_KFF, "pid.kff", PARAM_FLOAT, PID_KFF, 0, 2)                     \
+  X(PARAM_BASE_SPEED, "speed.base", PARAM_INT, BASE_SPEED, 0, 255)            \
+  X(PARAM_MAX_SPEED, "speed.max", PARAM_INT, MAX_SPEED, 0, 255)               \
+  X(PARAM_TURN_SPEED, "speed.turn", PARAM_INT, TURN_SPEED, 0, 255)            \
+  X(PARAM_STRAIGHT_SPEED, "speed.straight", PARAM_INT, STRAIGHT_SPEED, 0,     \
+    255)                                                                       \
+  X(PARAM_SPEED_ACCEL, "speed.accel", PARAM_INT, SPEED_ACCEL, 0, 10000)       \
+  X(PARAM_SPEED_BRAKE, "speed.brake", PARAM_INT, SPEED_BRAKE, 0, 50000)       \
+  X(PARAM_GOV_KP_SCALE, "gov.kp_scale", PARAM_FLOAT, GOV_KP_SCALE, 0, 4)      \
+  X(PARAM_GOV_KD_SCALE, "gov.kd_scale", PARAM_FLOAT, GOV_KD_SCALE, 0, 4)      \
+  X(PARAM_MAX_PWM, "motor.max_pwm", PARAM_INT, MAX_PWM_LIMIT, 0, 255)         \
+  X(PARAM_MIN_PWM_L, "motor.min_l", PARAM_INT, MIN_PWM_L, 0, 255)             \
+  X(PARAM_MIN_PWM_R, "motor.min_r", PARAM_INT, MIN_PWM_R, 0, 255)             \
+  X(PARAM_FACTOR_L, "motor.factor_l", PARAM_FLOAT, SPEED_FACTOR_L, 0, 1.5)    \
+  X(PARAM_FACTOR_R, "motor.factor_r", PARAM_FLOAT, SPEED_FACTOR_R, 0, 1.5)    \
+  X(PARAM_BLACK_THRESHOLD, "sensor.black", PARAM_INT, LINE_BLACK_THRESHOLD,   \
+    0, 1000)                                                                   \
+  X(PARAM_SENSOR_MEDIAN, "sensor.median", PARAM_INT, SENSOR_MEDIAN, 1, 5)     \
+  X(PARAM_SENSOR_SMOOTH, "sensor.smooth", PARAM_INT, SENSOR_SMOOTH, 0,        \
+    SENSOR_SMOOTH_MAX)                                                        \
+  X(PARAM_LINE_ESTIMATOR, "line.estimator", PARAM_INT, LINE_ESTIMATOR, 0, 1) \
+  X(PARAM_NODE_COOLDOWN, "node.cooldown_ms", PARAM_INT, NODE_COOLDOWN_MS, 0,  \
+    10000)                                                                     \
+  X(PARAM_TURN_INNER, "turn.inner", PARAM_INT, TURN_INNER, -100, 0)           \
+  X(PARAM_TURN_CREEP, "turn.creep_ms", PARAM_INT, TURN_CREEP_MS, 0, 2000)     \
+  X(PARAM_TURN_ACCEL, "turn.accel", PARAM_INT, TURN_ACCEL, 100, 20000)        \
+  X(PARAM_TURN_TIMEOUT, "turn.timeout_ms", PARAM_INT, TURN_TIMEOUT_MS, 0,     \
+    10000)                                                                     \
+  X(PARAM_BATTERY_NOMINAL, "battery.nominal", PARAM_FLOAT, BATTERY_NOMINAL, 0, \
+    15)                                                                        \
+  X(PARAM_BATTERY_CUTOFF, "battery.cutoff", PARAM_FLOAT, BATTERY_CUTOFF, 0, 15) \
+  X(PARAM_TRACK_SPEED, "track.speed", PARAM_INT, TRACK_SPEED, 0, 255)          \
+  X(PARAM_ILC_GAIN, "ilc.gain", PARAM_FLOAT, ILC_GAIN, 0, 1)                   \
+  X(PARAM_ILC_FORGET, "ilc.forget", PARAM_FLOAT, ILC_FORGET, 0, 1)
+
+#define PARAM_ENUM_ENTRY(id, key, type, def, min, max) id,
+enum ParamId { PARAM_TABLE(PARAM_ENUM_ENTRY) PARAM_COUNT };
+#undef PARAM_ENUM_ENTRY
+
+struct ParamDef {
+  const char *key;
+  uint8_t type;
+  float defaultValue;
+  float minValue;
+  float maxValue;
+};
+
+class ParamStore {
+public:
+  ParamStore();
+  void begin(); // Loads the saved set, or defaults if missing/corrupt
+
+  float get(uint8_t id) { return values[id]; }
+  int32_t getInt(uint8_t id) { return (int32_t)values[id]; }
+  // False if out of range (value unchanged). Ints are rounded.
+  bool set(uint8_t id, float value);
+
+  int8_t find(const char *key); // -1 if unknown
+  const ParamDef &getDef(uint8_t id);
+
+  bool load();
+  void save();
+  void resetDefaults();
+  bool isDirty() { return dirty; } // Changed since load/save
+
+  // "key=value"
+  size_t formatValue(uint8_t id, char *buf, size_t len);
+  // "key=value|type|min|max;..." for every parameter
+  size_t formatList(char *buf, size_t len);
+
+private:
+  float values[PARAM_COUNT];
+  uint16_t schema; // CRC of the key list: a changed table drops saved data
+  bool dirty;
+};
+
+#endif
@@ -0,0 +1,134 @@
+#include "Profiler.h"
+
+static const char *const STAGE_NAMES[Profiler::STAGE_COUNT] = {
+    "sensors", "control", "network", "commands", "telemetry", "led", "debug"};
+
+Profiler::Profiler() {
+  cycleCounter = false;
+  cyclesPerUs = 1;
+  reset();
+}
+
+void Profiler::begin() {
+#if defined(ARDUINO_ARCH_RENESAS) && defined(DWT_CTRL_CYCCNTENA_Msk)
+  // Enable the DWT cycle counter (sub-microsecond, no interrupt cost)
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+  DWT->CYCCNT = 0;
+  DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+  cyclesPerUs = SystemCoreClock / 1000000;
+  cycleCounter = (DWT->CTRL & DWT_CTRL_CYCCNTENA_Msk) && cyclesPerUs > 0;
+#endif
+}
+
+uint32_t Profiler::timestamp() {
+#if defined(ARDUINO_ARCH_RENESAS) && defined(DWT_CTRL_CYCCNTENA_Msk)
+  if (cycleCounter) return DWT->CYCCNT;
+#endif
+  return micros();
+}
+
+uint32_t Profiler::elapsedUs(uint32_t start) {
+  uint32_t elapsed = timestamp() - start;
+  return cycleCounter ? elapsed / cyclesPerUs : elapsed;
+}
+
+void Profiler::reset() {
+  for (uint8_t s = 0; s < STAGE_COUNT; s++) {
+    memset(stats[s].buckets, 0, sizeof(stats[s].buckets));
+    stats[s].count = 0;
+    stats[s].minUs = 0xFFFFFFFF;
+    stats[s].maxUs = 0;
+  }
+}
+
+uint8_t Profiler::bucketFor(uint32_t us) {
+  if (us < 16) return us;
+
+  // Index of the highest set bit (4..31)
+  uint8_t octave = 31 - __builtin_clz(us);
+  uint8_t sub = (us >> (octave - 2)) & 0x3; // Next two bits below the MSB
+  uint16_t bucket = 16 + (octave - 4) * 4 + sub;
+  return bucket < PROFILE_BUCKETS ? bucket : PROFILE_BUCKETS - 1;
+}
+
+uint32_t Profiler::bucketMidpoint(uint8_t bucket) {
+  if (bucket < 16) return bucket;
+  uint8_t octave = (bucket - 16) / 4 + 4;
+  uint8_t sub = (bucket - 16) % 4;
+  uint32_t width = 1UL << (octave - 2);
+  return (1UL << octave) + sub * width + width / 2;
+}
+
+void Profiler::record(uint8_t stage, uint32_t us) {
+  if (stage >= STAGE_COUNT) return;
+  StageStats &s = stats[stage];
+
+  uint16_t &bucket = s.buckets[bucketFor(us)];
+  if (bucket == 0xFFFF) {
+    // Keep the shape, lose old weight: halve every bucket
+    for (uint8_t i = 0; i < PROFILE_BUCKETS; i++) s.buckets[i] >>= 1;
+  }
+  bucket++;
+
+  s.count++;
+  if (us < s.minUs) s.minUs = us;
+  if (us > s.maxUs) s.maxUs = us;
+}
+
+uint32_t Profiler::getPercentile(uint8_t stage, uint8_t percent) {
+  const StageStats &s = stats[stage];
+  uint32_t total = 0;
+  for (uint8_t i = 0; i < PROFILE_BUCKETS; i++) total += s.buckets[i];
+  if (total == 0) return 0;
+
+  uint32_t target = (total * percent + 99) / 100;
+  uint32_t seen = 0;
+  for (uint8_t i = 0; i < PROFILE_BUCKETS; i++) {
+    seen += s.buckets[i];
+    if (seen >= target) {
+      uint32_t value = bucketMidpoint(i);
+      // Never report outside the observed range
+      if (value < s.minUs) value = s.minUs;
+      if (value > s.maxUs) value = s.maxUs;
+      return value;
+    }
+  }
+  return s.maxUs;
+}
+
+const char *Profiler::getStageName(uint8_t stage) {
+  return stage < STAGE_COUNT ? STAGE_NAMES[stage] : "?";
+}
+
+void Profiler::format(char *buf, size_t len) {
+  size_t used = 0;
+  buf[0] = 0;
+  for (uint8_t s = 0; s < STAGE_COUNT && used < len; s++) {
+    if (stats[s].count == 0) continue;
+    int n = snprintf(buf + used, len - used,
+                     "%s%s n=%lu min=%lu p50=%lu p99=%lu max=%lu",
+                     used ? ";" : "", STAGE_NAMES[s],
+                     (unsigned long)stats[s].count,
+                     (unsigned long)stats[s].minUs,
+                     (unsigned long)getPercentile(s, 50),
+                     (unsigned long)getPercentile(s, 99),
+                     (unsigned long)stats[s].maxUs);
+    if (n < 0) break;
+    used += n;
+  }
+}
+
+void Profiler::printReport() {
+  Serial.println("PROFILE (us): stage count min p50 p99 max");
+  for (uint8_t s = 0; s < STAGE_COUNT; s++) {
+    if (stats[s].count == 0) continue;
+    char line[80];
+    snprintf(line, sizeof(line), "  %-9s %8lu %6lu %6lu %6lu %6lu",
+             STAGE_NAMES[s], (unsigned long)stats[s].count,
+             (unsigned long)stats[s].minUs,
+             (unsigned long)getPercentile(s, 50),
+             (unsigned long)getPercentile(s, 99),
+             (unsigned long)stats[s].maxUs);
+    Serial.println(line);
+  }
+}
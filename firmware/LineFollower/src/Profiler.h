@@ -0,0 +1,84 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <Arduino.h>
+#include "Config.h"
+
+// Log-linear histogram: 0-15 us exact, then 4 buckets per power of two up
+// to 65 ms; anything longer lands in the last bucket.
+#define PROFILE_BUCKETS 64
+
+// Lightweight stage profiler for the main loop. Each stage keeps a fixed
+// histogram (no heap), so percentiles cost nothing at record time.
+// Timestamps come from the Cortex-M4 DWT cycle counter on the Uno R4 and
+// from micros() elsewhere (host build).
+class Profiler {
+public:
+  enum Stage {
+    STAGE_SENSORS,   // readLine() + getState()
+    STAGE_CONTROL,   // Navigator + PID + motor output
+    STAGE_NETWORK,   // network.update()
+    STAGE_COMMANDS,  // Parsing and executing a received packet
+    STAGE_TELEMETRY, // Building + sending the telemetry packet
+    STAGE_LED,       // led.update()
+    STAGE_DEBUG,     // Serial debug block
+    STAGE_COUNT
+  };
+
+  Profiler();
+  void begin(); // Starts the cycle counter where available
+
+  uint32_t timestamp();                 // Opaque start mark
+  uint32_t elapsedUs(uint32_t start);   // Microseconds since a mark
+  void record(uint8_t stage, uint32_t us);
+  void reset();
+
+  uint32_t getCount(uint8_t stage) { return stats[stage].count; }
+  uint32_t getMin(uint8_t stage) { return stats[stage].minUs; }
+  uint32_t getMax(uint8_t stage) { return stats[stage].maxUs; }
+  uint32_t getPercentile(uint8_t stage, uint8_t percent);
+  static const char *getStageName(uint8_t stage);
+
+  // "sensors n=.. min=.. p50=.. p99=.. max=..;..." into buf
+  void format(char *buf, size_t len);
+  void printReport(); // Table on Serial
+
+private:
+  struct StageStats {
+    uint16_t buckets[PROFILE_BUCKETS];
+    uint32_t count;
+    uint32_t minUs;
+    uint32_t maxUs;
+  };
+
+  static uint8_t bucketFor(uint32_t us);
+  static uint32_t bucketMidpoint(uint8_t bucket);
+
+  StageStats stats[STAGE_COUNT];
+  bool cycleCounter;
+  uint32_t cyclesPerUs;
+};
+
+// RAII helper: records the enclosing scope into a stage
+class ProfileScope {
+public:
+  ProfileScope(Profiler &profiler, uint8_t stage)
+      : profiler(profiler), stage(stage), start(profiler.timestamp()) {}
+  ~ProfileScope() { profiler.record(stage, profiler.elapsedUs(start)); }
+
+private:
+  Profiler &profiler;
+  uint8_t stage;
+  uint32_t start;
+};
+
+#if ENABLE_PROFILER
+#define PROFILE_STAGE(profiler, stage)                                         \
+  ProfileScope profileScope_##stage(profiler, Profiler::stage)
+#else
+#define PROFILE_STAGE(profiler, stage)                                         \
+  do {                                                                         \
+  } while (0)
+#endif
+
+#endif
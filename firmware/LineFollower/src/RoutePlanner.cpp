@@ -0,0 +1,125 @@
+#include "RoutePlanner.h"
+
+static_assert(GRID_NODES * 4 <= 256, "states are uint8_t");
+
+static uint8_t stateOf(uint8_t node, Direction heading) {
+  return node * 4 + heading;
+}
+
+RoutePlanner::RoutePlanner() {
+  goal = 0;
+  heapSize = 0;
+}
+
+bool RoutePlanner::plan(const GridMap &map, uint8_t start, Direction heading,
+                        uint8_t goal, Route &route) {
+  route.goal = goal;
+  route.length = 0;
+  if (start == goal) return true;
+
+  this->goal = goal;
+  for (uint16_t s = 0; s < STATES; s++) {
+    cost[s] = UINT16_MAX;
+    slot[s] = NOT_QUEUED;
+  }
+  heapSize = 0;
+  uint8_t first = stateOf(start, heading);
+  cost[first] = 0;
+  previous[first] = first;
+  push(first);
+
+  while (heapSize > 0) {
+    uint8_t state = pop();
+    uint8_t node = state / 4;
+    Direction arrival = (Direction)(state % 4);
+    if (node == goal) {
+      // Walk back; each state's heading is the exit of the node before
+      uint8_t length = 0;
+      for (uint8_t s = state; s != first; s = previous[s]) length++;
+      if (length > ROUTE_MAX_STEPS) return false;
+      route.length = length;
+      for (uint8_t s = state; s != first; s = previous[s]) {
+        route.headings[--length] = s % 4;
+      }
+      return true;
+    }
+
+    // On, right, left; never back the way it came
+    const int8_t TURNS[] = {0, 1, -1};
+    for (uint8_t i = 0; i < 3; i++) {
+      Direction exit = rotate(arrival, TURNS[i]);
+      if (!map.hasEdge(node, exit)) continue;
+      uint8_t next = stateOf(GridMap::neighbor(node, exit), exit);
+      uint16_t nextCost =
+          cost[state] + ROUTE_EDGE_COST + (TURNS[i] ? ROUTE_TURN_COST : 0);
+      if (nextCost >= cost[next]) continue;
+      cost[next] = nextCost;
+      previous[next] = state;
+      push(next);
+    }
+  }
+  return false;
+}
+
+// Cost so far plus the Manhattan distance left
+uint16_t RoutePlanner::keyOf(uint8_t state) {
+  uint8_t node = state / 4;
+  return cost[state] + (abs(GridMap::nodeX(node) - GridMap::nodeX(goal)) +
+                        abs(GridMap::nodeY(node) - GridMap::nodeY(goal))) *
+                           ROUTE_EDGE_COST;
+}
+
+// Binary min-heap on keyOf(); a queued state moves up when its cost drops
+void RoutePlanner::push(uint8_t state) {
+  if (slot[state] == NOT_QUEUED) {
+    heap[heapSize] = state;
+    slot[state] = heapSize;
+    heapSize++;
+  }
+  siftUp(slot[state]);
+}
+
+uint8_t RoutePlanner::pop() {
+  uint8_t top = heap[0];
+  heapSize--;
+  if (heapSize > 0) {
+    heap[0] = heap[heapSize];
+    slot[heap[0]] = 0;
+    siftDown(0);
+  }
+  slot[top] = NOT_QUEUED;
+  return top;
+}
+
+void RoutePlanner::siftUp(uint16_t index) {
+  while (index > 0) {
+    uint16_t parent = (index - 1) / 2;
+    if (keyOf(heap[parent]) <= keyOf(heap[index])) break;
+    swap(parent, index);
+    index = parent;
+  }
+}
+
+void RoutePlanner::siftDown(uint16_t index) {
+  while (true) {
+    uint16_t smallest = index;
+    uint16_t left = 2 * index + 1, right = left + 1;
+    if (left < heapSize && keyOf(heap[left]) < keyOf(heap[smallest])) {
+      smallest = left;
+    }
+    if (right < heapSize && keyOf(heap[right]) < keyOf(heap[smallest])) {
+      smallest = right;
+    }
+    if (smallest == index) break;
+    swap(smallest, index);
+    index = smallest;
+  }
+}
+
+void RoutePlanner::swap(uint16_t a, uint16_t b) {
+  uint8_t state = heap[a];
+  heap[a] = heap[b];
+  heap[b] = state;
+  slot[heap[a]] = a;
+  slot[heap[b]] = b;
+}
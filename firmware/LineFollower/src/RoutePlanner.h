@@ -0,0 +1,48 @@
+#ifndef ROUTE_PLANNER_H
+#define ROUTE_PLANNER_H
+
+#include <Arduino.h>
+#include "Config.h"
+#include "GridMap.h"
+
+// The heading to leave each node on, from the first decision to the goal
+struct Route {
+  uint8_t goal;
+  uint8_t length; // Decisions; 0 = the start is the goal
+  uint8_t headings[ROUTE_MAX_STEPS]; // Direction
+};
+
+// A* over (node, arrival heading) on the known segments of a GridMap.
+// The cart cannot reverse on a segment, so at each node it may go on, turn
+// left or turn right; a turn costs ROUTE_TURN_COST on top of the segment.
+// Manhattan distance is the (consistent) heuristic. The work arrays are
+// members so planning does not need ~1.5 KB of stack.
+class RoutePlanner {
+public:
+  RoutePlanner();
+
+  // start: node of the first decision, reached heading `heading`.
+  // False if the goal cannot be reached or needs more than ROUTE_MAX_STEPS.
+  bool plan(const GridMap &map, uint8_t start, Direction heading, uint8_t goal,
+            Route &route);
+
+private:
+  static const uint16_t STATES = GRID_NODES * 4;
+  static const uint16_t NOT_QUEUED = 0xFFFF;
+
+  uint16_t keyOf(uint8_t state);
+  void push(uint8_t state);
+  uint8_t pop();
+  void siftUp(uint16_t index);
+  void siftDown(uint16_t index);
+  void swap(uint16_t a, uint16_t b);
+
+  uint8_t goal;
+  uint16_t cost[STATES];    // From the start, UINT16_MAX = not reached
+  uint8_t previous[STATES];
+  uint16_t slot[STATES];    // Heap index, NOT_QUEUED when not in the heap
+  uint8_t heap[STATES];
+  uint16_t heapSize;
+};
+
+#endif
@@ -0,0 +1,148 @@
+#include "Scheduler.h"
+
+Scheduler::Scheduler() {
+  taskCount = 0;
+  currentDtUs = 0;
+}
+
+int8_t Scheduler::addTask(const char *name, TaskFn fn, uint32_t periodUs,
+                          uint32_t budgetUs, bool hardRate) {
+  if (taskCount >= SCHEDULER_MAX_TASKS) return -1;
+  // Soft tasks only start in the slack after a hard tick; one that never
+  // fits there would either starve or make control late
+  for (uint8_t i = 0; i < taskCount; i++) {
+    if (tasks[i].hardRate == hardRate) continue;
+    uint32_t hardPeriod = hardRate ? periodUs : tasks[i].periodUs;
+    if (budgetUs + tasks[i].budgetUs > hardPeriod) return -1;
+  }
+
+  Task &task = tasks[taskCount];
+  task.name = name;
+  task.fn = fn;
+  task.periodUs = periodUs;
+  task.budgetUs = budgetUs;
+  task.hardRate = hardRate;
+  task.nextRunUs = micros();
+  task.lastStartUs = task.nextRunUs;
+
+  task.runs = 0;
+  task.overruns = 0;
+  task.missed = 0;
+  task.lastRunUs = 0;
+  task.maxRunUs = 0;
+  task.maxLateUs = 0;
+
+  return taskCount++;
+}
+
+void Scheduler::begin() {
+  uint32_t now = micros();
+  for (uint8_t i = 0; i < taskCount; i++) {
+    tasks[i].nextRunUs = now;
+    tasks[i].lastStartUs = now;
+  }
+}
+
+bool Scheduler::isDue(const Task &task, uint32_t now) {
+  // Signed difference keeps this correct across the micros() wrap (~71 min)
+  return (int32_t)(now - task.nextRunUs) >= 0;
+}
+
+uint32_t Scheduler::slackUntilHardDeadline(uint32_t now) {
+  uint32_t slack = 0xFFFFFFFF;
+  for (uint8_t i = 0; i < taskCount; i++) {
+    if (!tasks[i].hardRate) continue;
+    int32_t untilDue = (int32_t)(tasks[i].nextRunUs - now);
+    if (untilDue <= 0) return 0;
+    if ((uint32_t)untilDue < slack) slack = untilDue;
+  }
+  return slack;
+}
+
+uint32_t Scheduler::microsUntilNextTask() {
+  uint32_t now = micros();
+  uint32_t wait = 0xFFFFFFFF;
+  for (uint8_t i = 0; i < taskCount; i++) {
+    int32_t untilDue = (int32_t)(tasks[i].nextRunUs - now);
+    if (untilDue <= 0) return 0;
+    if ((uint32_t)untilDue < wait) wait = untilDue;
+  }
+  return taskCount ? wait : 0;
+}
+
+void Scheduler::execute(Task &task, uint32_t now) {
+  uint32_t late = now - task.nextRunUs;
+  if (late > task.maxLateUs) task.maxLateUs = late;
+
+  if (task.hardRate) currentDtUs = now - task.lastStartUs;
+  // Stay on the fixed grid, soft tasks too (waiting for slack must not
+  // stretch their period); skip (and count) slots we can no longer meet
+  task.nextRunUs += task.periodUs;
+  if ((int32_t)(now - task.nextRunUs) >= 0) {
+    uint32_t behind = (now - task.nextRunUs) / task.periodUs + 1;
+    task.missed += behind;
+    task.nextRunUs += behind * task.periodUs;
+  }
+  task.lastStartUs = now;
+
+  task.fn();
+
+  uint32_t elapsed = micros() - now;
+  task.lastRunUs = elapsed;
+  if (elapsed > task.maxRunUs) task.maxRunUs = elapsed;
+  if (elapsed > task.budgetUs) task.overruns++;
+  task.runs++;
+}
+
+void Scheduler::run() {
+  uint32_t now = micros();
+
+  // 1. Hard-rate tasks always go first
+  for (uint8_t i = 0; i < taskCount; i++) {
+    if (tasks[i].hardRate && isDue(tasks[i], now)) {
+      execute(tasks[i], now);
+      now = micros();
+    }
+  }
+
+  // 2. At most one soft task, and only if it fits before the next hard tick
+  uint32_t slack = slackUntilHardDeadline(now);
+  for (uint8_t i = 0; i < taskCount; i++) {
+    Task &task = tasks[i];
+    if (task.hardRate || !isDue(task, now)) continue;
+    if (task.budgetUs <= slack) {
+      execute(task, now);
+      return;
+    }
+  }
+}
+
+void Scheduler::resetStats() {
+  for (uint8_t i = 0; i < taskCount; i++) {
+    tasks[i].runs = 0;
+    tasks[i].overruns = 0;
+    tasks[i].missed = 0;
+    tasks[i].maxRunUs = 0;
+    tasks[i].maxLateUs = 0;
+  }
+}
+
+void Scheduler::formatStats(char *buf, size_t len) {
+  size_t used = 0;
+  buf[0] = 0;
+  for (uint8_t i = 0; i < taskCount && used < len; i++) {
+    const Task &t = tasks[i];
+    int n = snprintf(buf + used, len - used,
+                     "%s%s %lu/%lu/%lu max=%lu late=%lu", i ? ";" : "",
+                     t.name, (unsigned long)t.runs, (unsigned long)t.overruns,
+                     (unsigned long)t.missed, (unsigned long)t.maxRunUs,
+                     (unsigned long)t.maxLateUs);
+    if (n < 0) break;
+    if ((size_t)n >= len - used) {
+      buf[used] = 0;
+      if (len - used > 4) strcpy(buf + used, ";...");
+      break;
+    }
+    used += n;
+  }
+}
@@ -0,0 +1,78 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <Arduino.h>
+
+#define SCHEDULER_MAX_TASKS 8
+#define SCHEDULER_STATS_LEN 80 // Longest formatStats() entry, with its ";"
+
+// Cooperative fixed-rate scheduler.
+// - Hard-rate tasks run on a fixed micros() grid (next += period), so the
+//   control loop samples at a constant dt. Missed slots are skipped, not
+//   replayed, and counted.
+// - Soft tasks run in registration order (first = highest priority), one
+//   per run() call, and only when their time budget fits before the next
+//   hard deadline. They keep to their grid as well, so waiting for slack
+//   delays one run but not the ones after it. A soft task that could not
+//   fit even right after a hard tick is refused by addTask(), so none
+//   starves and none delays control; longer work has to be split into
+//   steps across runs.
+// No heap: tasks live in a fixed array.
+class Scheduler {
+public:
+  typedef void (*TaskFn)();
+
+  struct Task {
+    const char *name;
+    TaskFn fn;
+    uint32_t periodUs;
+    uint32_t budgetUs;  // Expected worst-case runtime
+    bool hardRate;
+
+    uint32_t nextRunUs;
+    uint32_t lastStartUs;
+
+    // Statistics
+    uint32_t runs;
+    uint32_t overruns;  // Runtime exceeded budget
+    uint32_t missed;    // Slots skipped because we were late
+    uint32_t lastRunUs;
+    uint32_t maxRunUs;
+    uint32_t maxLateUs; // Worst start delay past the scheduled time
+  };
+
+  Scheduler();
+
+  // Returns the task id, or -1 if the table is full or the task cannot
+  // share the period of a hard-rate task (soft budget + hard budget > period)
+  int8_t addTask(const char *name, TaskFn fn, uint32_t periodUs,
+                 uint32_t budgetUs, bool hardRate = false);
+
+  void begin(); // Aligns every task to start now
+  void run();   // Call from loop(); never blocks
+
+  uint8_t getTaskCount() { return taskCount; }
+  const Task &getTask(uint8_t id) { return tasks[id]; }
+
+  // Measured start-to-start interval of the running hard-rate task
+  uint32_t getCurrentDtUs() { return currentDtUs; }
+
+  // Time until the next task is due (0 if one is due now)
+  uint32_t microsUntilNextTask();
+
+  void resetStats();
+  // "name runs/overruns/missed max=us late=us;..." into buf. Whole entries
+  // only: one that does not fit ends the list with ";..."
+  void formatStats(char *buf, size_t len);
+
+private:
+  void execute(Task &task, uint32_t now);
+  bool isDue(const Task &task, uint32_t now);
+  uint32_t slackUntilHardDeadline(uint32_t now);
+
+  Task tasks[SCHEDULER_MAX_TASKS];
+  uint8_t taskCount;
+  uint32_t currentDtUs;
+};
+
+#endif
@@ -0,0 +1,119 @@
+#include "SensorFilter.h"
+
+static_assert(SENSOR_COUNT % 2 == 0, "packed filter needs channel pairs");
+
+// Per-halfword unsigned saturating subtract and halving add
+#if defined(__ARM_FEATURE_DSP)
+static inline uint32_t uqsub16(uint32_t a, uint32_t b) { return __UQSUB16(a, b); }
+static inline uint32_t uhadd16(uint32_t a, uint32_t b) { return __UHADD16(a, b); }
+#else
+static inline uint32_t uqsub16(uint32_t a, uint32_t b) {
+  uint32_t lo = (a & 0xFFFF) > (b & 0xFFFF) ? (a & 0xFFFF) - (b & 0xFFFF) : 0;
+  uint32_t hi = (a >> 16) > (b >> 16) ? (a >> 16) - (b >> 16) : 0;
+  return hi << 16 | lo;
+}
+static inline uint32_t uhadd16(uint32_t a, uint32_t b) {
+  uint32_t lo = ((a & 0xFFFF) + (b & 0xFFFF)) >> 1;
+  uint32_t hi = ((a >> 16) + (b >> 16)) >> 1;
+  return hi << 16 | lo;
+}
+#endif
+
+// Lane-wise min/max: a - (a -sat b) and b + (a -sat b) never cross lanes
+static inline uint32_t min16(uint32_t a, uint32_t b) { return a - uqsub16(a, b); }
+static inline uint32_t max16(uint32_t a, uint32_t b) { return b + uqsub16(a, b); }
+
+static inline uint32_t median3x16(uint32_t a, uint32_t b, uint32_t c) {
+  return max16(min16(a, b), min16(max16(a, b), c));
+}
+
+static inline uint16_t smin(uint16_t a, uint16_t b) { return a < b ? a : b; }
+static inline uint16_t smax(uint16_t a, uint16_t b) { return a < b ? b : a; }
+
+static inline uint16_t median3(uint16_t a, uint16_t b, uint16_t c) {
+  return smax(smin(a, b), smin(smax(a, b), c));
+}
+
+SensorFilter::SensorFilter() {
+  taps = 1;
+  shift = 0;
+  setMedian(SENSOR_MEDIAN);
+  setSmoothing(SENSOR_SMOOTH);
+  reset();
+}
+
+void SensorFilter::setMedian(uint8_t taps) {
+  uint8_t odd = taps >= 5 ? 5 : taps >= 3 ? 3 : 1;
+  if (odd != this->taps) primed = false;
+  this->taps = odd;
+}
+
+void SensorFilter::setSmoothing(uint8_t shift) {
+  this->shift = shift < SENSOR_SMOOTH_MAX ? shift : SENSOR_SMOOTH_MAX;
+}
+
+void SensorFilter::reset() {
+  primed = false;
+  head = 0;
+}
+
+void SensorFilter::prime(const uint16_t *values) {
+  for (uint8_t t = 0; t < 5; t++) memcpy(history[t].v, values, sizeof(history[t].v));
+  for (uint8_t i = 0; i < SENSOR_COUNT; i++) {
+    state.v[i] = values[i] << SENSOR_SMOOTH_FRACTION;
+  }
+  head = 0;
+  primed = true;
+}
+
+void SensorFilter::applyScalar(uint16_t *values) {
+  if (!primed) prime(values);
+  memcpy(history[head].v, values, sizeof(history[head].v));
+  head = (head + 1) % taps;
+
+  for (uint8_t i = 0; i < SENSOR_COUNT; i++) {
+    uint16_t x = values[i];
+    if (taps == 3) {
+      x = median3(history[0].v[i], history[1].v[i], history[2].v[i]);
+    } else if (taps == 5) {
+      const Lanes *h = history;
+      uint16_t lo = smax(smin(h[0].v[i], h[1].v[i]), smin(h[2].v[i], h[3].v[i]));
+      uint16_t hi = smin(smax(h[0].v[i], h[1].v[i]), smax(h[2].v[i], h[3].v[i]));
+      x = median3(h[4].v[i], lo, hi);
+    }
+
+    uint16_t y = x << SENSOR_SMOOTH_FRACTION;
+    for (uint8_t k = 0; k < shift; k++) y = (y + state.v[i]) >> 1;
+    state.v[i] = y;
+    values[i] = (y + (1 << (SENSOR_SMOOTH_FRACTION - 1))) >> SENSOR_SMOOTH_FRACTION;
+  }
+}
+
+void SensorFilter::applyPacked(uint16_t *values) {
+  if (!primed) prime(values);
+  memcpy(history[head].v, values, sizeof(history[head].v));
+  head = (head + 1) % taps;
+
+  const uint32_t round = 0x00010001UL << (SENSOR_SMOOTH_FRACTION - 1);
+  const uint32_t mask = 0x00010001UL * (0xFFFF >> SENSOR_SMOOTH_FRACTION);
+  Lanes frame;
+  memcpy(frame.v, values, sizeof(frame.v));
+  for (uint8_t w = 0; w < WORDS; w++) {
+    uint32_t x = frame.w[w];
+    if (taps == 3) {
+      x = median3x16(history[0].w[w], history[1].w[w], history[2].w[w]);
+    } else if (taps == 5) {
+      const Lanes *h = history;
+      uint32_t lo = max16(min16(h[0].w[w], h[1].w[w]), min16(h[2].w[w], h[3].w[w]));
+      uint32_t hi = min16(max16(h[0].w[w], h[1].w[w]), max16(h[2].w[w], h[3].w[w]));
+      x = median3x16(h[4].w[w], lo, hi);
+    }
+
+    // 10-bit readings shifted left stay inside their halfword
+    uint32_t y = x << SENSOR_SMOOTH_FRACTION;
+    for (uint8_t k = 0; k < shift; k++) y = uhadd16(y, state.w[w]);
+    state.w[w] = y;
+    frame.w[w] = ((y + round) >> SENSOR_SMOOTH_FRACTION) & mask;
+  }
+  memcpy(values, frame.v, sizeof(frame.v));
+}
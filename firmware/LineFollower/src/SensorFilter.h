@@ -0,0 +1,52 @@
+#ifndef SENSOR_FILTER_H
+#define SENSOR_FILTER_H
+
+#include <Arduino.h>
+#include "Config.h"
+
+// Per-channel cleanup of raw sensor frames before calibration: a running
+// median over the last 1, 3 or 5 frames (spikes from glare on glossy tape)
+// followed by a first-order IIR, y += (x - y) / 2^shift.
+//
+// Two implementations with bit-identical results: a scalar one, and a
+// packed one working on two channels per 32-bit word with the Cortex-M4
+// SIMD instructions (UQSUB16, UHADD16). Off target the packed one runs on
+// portable stand-ins for those, which is what the host benchmark compares.
+
+class SensorFilter {
+public:
+  SensorFilter();
+  void setMedian(uint8_t taps);      // 1 (off), 3 or 5; rounded down to odd
+  void setSmoothing(uint8_t shift);  // 0 (off) to SENSOR_SMOOTH_MAX
+  uint8_t getMedian() { return taps; }
+  uint8_t getSmoothing() { return shift; }
+  void reset(); // The next frame primes the history and the IIR
+
+  // In place, SENSOR_COUNT raw readings (0..1023)
+  void apply(uint16_t *values) {
+    if (SENSOR_FILTER_SIMD) applyPacked(values);
+    else applyScalar(values);
+  }
+  void applyScalar(uint16_t *values);
+  void applyPacked(uint16_t *values);
+
+private:
+  static const uint8_t WORDS = SENSOR_COUNT / 2;
+
+  // Two views of one frame; lane i of word w is channel 2w + i
+  union Lanes {
+    uint16_t v[SENSOR_COUNT];
+    uint32_t w[WORDS];
+  };
+
+  uint8_t taps;
+  uint8_t shift;
+  bool primed;
+  uint8_t head;           // Oldest entry of the ring
+  Lanes history[5];       // Last `taps` raw frames
+  Lanes state;            // IIR output, raw << SENSOR_SMOOTH_FRACTION
+
+  void prime(const uint16_t *values);
+};
+
+#endif
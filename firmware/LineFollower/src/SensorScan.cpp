@@ -0,0 +1,122 @@
+#include "SensorScan.h"
+
+// The scan averages in hardware, where ADADC only takes 1, 2 or 4
+static_assert(SENSOR_OVERSAMPLE == 1 || SENSOR_OVERSAMPLE == 2 ||
+                  SENSOR_OVERSAMPLE == 4,
+              "SENSOR_OVERSAMPLE must be 1, 2 or 4");
+
+#if defined(ARDUINO_ARCH_RENESAS)
+#include <FspTimer.h>
+
+// RA4M1 ADC0, single-scan mode with software start. Each timer tick
+// collects the scan started on the previous tick, then starts the next one,
+// so a frame is at most two periods old when the control task picks it up.
+
+// Analog channel (ANxxx) behind A0..A5 on the Uno R4 WiFi
+static const uint8_t ADC_CHANNELS[] = {9, 0, 1, 2, 21, 22};
+#define D10_ADC_CHANNEL 19 // P103, the battery divider
+
+static FspTimer scanTimer;
+static uint8_t scanChannels[SENSOR_COUNT];
+static uint8_t scanCount = 0;
+static int8_t auxChannel = -1;
+static bool scanStarted = false;
+static bool scanRunning = false;
+
+static int8_t adcChannel(uint8_t pin) {
+  if (pin >= A0 && pin - A0 < (int)sizeof(ADC_CHANNELS)) {
+    return ADC_CHANNELS[pin - A0];
+  }
+  return pin == 10 ? D10_ADC_CHANNEL : -1;
+}
+
+// The ISR fills buffers[writeIndex] while the reader copies the other one
+static SensorFrame buffers[2];
+static volatile uint8_t writeIndex = 0;
+static volatile uint32_t publishedSeq = 0;
+
+static void scanTick(timer_callback_args_t *) {
+  if (R_ADC0->ADCSR_b.ADST) return; // Still converting: try next tick
+
+  if (scanStarted) {
+    SensorFrame &frame = buffers[writeIndex];
+    for (uint8_t i = 0; i < scanCount; i++) {
+      frame.values[i] = R_ADC0->ADDR[scanChannels[i]] >> 2; // 12 -> 10 bit
+    }
+    frame.aux = auxChannel >= 0 ? R_ADC0->ADDR[auxChannel] >> 2 : 0;
+    frame.seq = publishedSeq + 1;
+    frame.timestampUs = micros();
+    publishedSeq = frame.seq;
+    writeIndex ^= 1;
+  }
+
+  R_ADC0->ADCSR_b.ADST = 1;
+  scanStarted = true;
+}
+
+bool sensorScanBegin(const uint8_t *pins, uint8_t count, uint32_t periodUs,
+                     uint8_t auxPin) {
+  if (count > SENSOR_COUNT) return false;
+  uint16_t mask[2] = {0, 0};
+  for (uint8_t i = 0; i < count; i++) {
+    int8_t channel = adcChannel(pins[i]);
+    if (channel < 0) return false;
+    scanChannels[i] = channel;
+    mask[channel / 16] |= 1 << (channel % 16);
+  }
+  scanCount = count;
+  auxChannel = auxPin == SCAN_NO_AUX ? -1 : adcChannel(auxPin);
+  if (auxChannel >= 0) mask[auxChannel / 16] |= 1 << (auxChannel % 16);
+
+  // Let the core power the ADC and switch the pins to analog first
+  for (uint8_t i = 0; i < count; i++) analogRead(pins[i]);
+  if (auxChannel >= 0) analogRead(auxPin);
+
+  R_ADC0->ADCSR = 0; // Single scan, software trigger
+  R_ADC0->ADANSA[0] = mask[0];
+  R_ADC0->ADANSA[1] = mask[1];
+  // Average SENSOR_OVERSAMPLE conversions per channel, as QTRSensors does
+  // with samplesPerSensor. ADADC: AVEE (bit 7) | count - 1 in ADC[2:0]
+  // (0 = 1, 1 = 2, 3 = 4; 2 and 5 only add, without averaging)
+  bool average = SENSOR_OVERSAMPLE > 1;
+  R_ADC0->ADADS[0] = average ? mask[0] : 0;
+  R_ADC0->ADADS[1] = average ? mask[1] : 0;
+  R_ADC0->ADADC = average ? 0x80 | (SENSOR_OVERSAMPLE - 1) : 0;
+  R_ADC0->ADCER_b.ADPRC = 0;  // 12-bit
+  R_ADC0->ADCER_b.ADRFMT = 0; // Right-aligned
+
+  publishedSeq = 0;
+  writeIndex = 0;
+  scanStarted = false;
+
+  uint8_t type;
+  int8_t channel = FspTimer::get_available_timer(type);
+  if (channel < 0) return false;
+  if (!scanTimer.begin(TIMER_MODE_PERIODIC, type, channel,
+                       1000000.0f / periodUs, 0.0f, scanTick)) {
+    return false;
+  }
+  scanRunning = scanTimer.setup_overflow_irq() && scanTimer.open() &&
+                scanTimer.start();
+  return scanRunning;
+}
+
+void sensorScanEnd() {
+  scanTimer.stop();
+  scanTimer.close();
+  scanStarted = false;
+  scanRunning = false;
+}
+
+bool sensorScanRunning() { return scanRunning; }
+
+bool sensorScanLatest(SensorFrame &frame) {
+  // Short enough to just hold off the ISR instead of retrying
+  noInterrupts();
+  uint32_t seq = publishedSeq;
+  if (seq) frame = buffers[writeIndex ^ 1];
+  interrupts();
+  return seq != 0;
+}
+
+#endif
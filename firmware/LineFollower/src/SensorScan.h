@@ -0,0 +1,34 @@
+#ifndef SENSOR_SCAN_H
+#define SENSOR_SCAN_H
+
+#include <Arduino.h>
+#include "Config.h"
+
+// Background acquisition of the line sensor array (SENSOR_ADC_SCAN).
+// A timer restarts an ADC scan of every sensor pin each period; completed
+// scans land in a double buffer, so the reader always gets one whole frame.
+// The RA4M1 implementation is in SensorScan.cpp, the host build links a
+// virtual-time stand-in instead.
+//
+// While the scan runs it owns the ADC: nothing else may call analogRead().
+// One extra pin (the battery divider) can ride along with every scan.
+
+#define SCAN_NO_AUX 0xFF
+
+struct SensorFrame {
+  uint16_t values[SENSOR_COUNT]; // Raw, same scale as analogRead() (10-bit)
+  uint16_t aux;                  // auxPin, 0 without
+  uint32_t seq;                  // Completed scans since begin, from 1
+  uint32_t timestampUs;          // micros() when the scan was collected
+};
+
+// False if the scan cannot run (no timer free, pin without an ADC channel)
+bool sensorScanBegin(const uint8_t *pins, uint8_t count, uint32_t periodUs,
+                     uint8_t auxPin = SCAN_NO_AUX);
+void sensorScanEnd();
+bool sensorScanRunning();
+
+// Copies the freshest complete frame. False until the first one is ready.
+bool sensorScanLatest(SensorFrame &frame);
+
+#endif
@@ -0,0 +1,91 @@
+#include "SpeedGovernor.h"
+
+// One-pole low-pass with separate rise and fall time constants
+static int32_t follow(int32_t level, int32_t input, uint32_t dtUs,
+                      uint32_t releaseUs) {
+  uint32_t tauUs = input > level ? GOV_ATTACK_US : releaseUs;
+  return level + (int32_t)((int64_t)(input - level) * dtUs / (tauUs + dtUs));
+}
+
+SpeedGovernor::SpeedGovernor() {
+  setLimits(BASE_SPEED, STRAIGHT_SPEED, SPEED_ACCEL, SPEED_BRAKE);
+  setPreview(-1, 0);
+  reset();
+}
+
+void SpeedGovernor::setLimits(int curveSpeed, int straightSpeed, int accel,
+                              int brake) {
+  this->curveSpeed = curveSpeed;
+  // speed.straight at or below speed.base turns the governor off
+  this->straightSpeed = straightSpeed > curveSpeed ? straightSpeed : curveSpeed;
+  this->accel = accel;
+  this->brake = brake;
+}
+
+void SpeedGovernor::reset() {
+  speedMilli = curveSpeed * 1000L;
+  errorLevel = 0;
+  rateLevel = 0;
+  lastError = 0;
+  primed = false;
+  curvature = 1000;
+}
+
+int SpeedGovernor::update(int error, uint32_t dtUs) {
+  if (dtUs == 0) return getSpeed();
+  // Long gaps (first call, a stall) say nothing about the rate
+  uint32_t rateDtUs = dtUs < CONTROL_PERIOD_US * 4 ? dtUs : CONTROL_PERIOD_US * 4;
+
+  // The map vouches for what is ahead: no need to hold back after a curve
+  uint32_t releaseUs = preview >= 0 ? GOV_ATTACK_US : GOV_RELEASE_US;
+  int32_t magnitude = abs(error);
+  errorLevel = follow(errorLevel, magnitude * 16, dtUs, releaseUs);
+  if (primed) {
+    int32_t rate = (int32_t)((int64_t)abs(error - lastError) * 1000000 / rateDtUs);
+    rateLevel = follow(rateLevel, rate, dtUs, releaseUs);
+  }
+  lastError = error;
+  primed = true;
+
+  int32_t estimate = errorLevel / 16 * 1000 / GOV_ERROR_FULL +
+                     rateLevel * 1000 / GOV_RATE_FULL;
+  curvature = constrain(estimate, 0, 1000);
+
+  // Target speed, then slew towards it within the limits
+  int32_t topSpeed = straightSpeed;
+  int32_t sharpest = curvature;
+  if (preview >= 0) {
+    if (previewTop > topSpeed) topSpeed = previewTop;
+    if (preview > sharpest) sharpest = preview;
+  }
+  int32_t target = topSpeed * 1000L - (topSpeed - curveSpeed) * sharpest;
+  int32_t step = target - speedMilli;
+  int32_t maxUp = (int32_t)((int64_t)accel * dtUs / 1000);
+  int32_t maxDown = (int32_t)((int64_t)brake * dtUs / 1000);
+  speedMilli += constrain(step, -maxDown, maxUp);
+  return getSpeed();
+}
+
+uint8_t SpeedGovernor::getGainBlend() {
+  int32_t span = straightSpeed - curveSpeed;
+  if (span <= 0) return 0;
+  int32_t above = speedMilli - curveSpeed * 1000L;
+  return constrain(above * 16 / (span * 1000L), 0, 16);
+}
+
+void SpeedGovernor::setPreview(int16_t curvature, int topSpeed) {
+  preview = curvature > 1000 ? 1000 : curvature;
+  previewTop = topSpeed;
+}
+
+uint32_t SpeedGovernor::getBrakingTravel() {
+  int64_t v = speedMilli;
+  int64_t curve = curveSpeed * 1000L;
+  int64_t travel = (int64_t)GOV_PREVIEW_LEAD_MS * v / 1000;
+  // v^2 - vc^2 = 2 a d, in speed x ms
+  if (v > curve) {
+    travel += brake > 0 ? (v * v - curve * curve) / (2000 * (int64_t)brake)
+                        : 1000000;
+  }
+  return travel;
+}
@@ -0,0 +1,63 @@
+#ifndef SPEED_GOVERNOR_H
+#define SPEED_GOVERNOR_H
+
+#include <Arduino.h>
+#include "Config.h"
+
+// Base speed for line following, from a curvature estimate. Sits between
+// the PID and the motors: the PID corrects around whatever it returns.
+//
+// Curvature (0..1000) is read off the position error: how far off centre
+// the line sits (holding a curve needs a standing error) plus how fast the
+// error is changing (a curve entry shows in the rate first). Both go
+// through fast-attack / slow-release filters, so the cart brakes as soon as
+// a curve shows up and only speeds up again after a settled stretch.
+// The target then slides from speed.straight (curvature 0) down to
+// speed.base (curvature 1000), and the output follows it within the
+// speed.accel / speed.brake limits (speed units per second).
+//
+// With a preview (a TrackMemory lap in step with the cart), the target
+// curvature is the higher of the measured one and the sharpest the map
+// shows within braking distance, so the cart is already at curve speed when
+// the curve arrives. The measured curvature may then fall as fast as it
+// rises, and the top speed is the preview's instead of speed.straight.
+//
+// PID gains are scheduled on the output: getGainBlend() goes 0..16 from
+// speed.base to speed.straight, for interpolating towards the gov.*_scale
+// multiples of the tuned gains.
+class SpeedGovernor {
+public:
+  SpeedGovernor();
+  void setLimits(int curveSpeed, int straightSpeed, int accel, int brake);
+  void reset(); // Back to the curve speed with no history
+
+  // error: position - centre; dtUs: measured time since the last call
+  int update(int error, uint32_t dtUs);
+
+  // curvature < 0: no preview (the reactive governor above)
+  void setPreview(int16_t curvature, int topSpeed);
+  // Travel (speed x ms) to brake from here to the curve speed, plus
+  // GOV_PREVIEW_LEAD_MS at this speed: how far ahead the preview must see
+  uint32_t getBrakingTravel();
+
+  int getSpeed() { return speedMilli / 1000; }
+  uint16_t getCurvature() { return curvature; }
+  uint8_t getGainBlend();
+
+private:
+  int curveSpeed;
+  int straightSpeed;
+  int32_t accel; // Speed units per second
+  int32_t brake;
+
+  int32_t speedMilli; // Output, 1/1000 speed unit
+  int32_t errorLevel; // Filtered |error|, counts x 16
+  int32_t rateLevel;  // Filtered |d error / dt|, counts/s
+  int32_t lastError;
+  bool primed;
+  uint16_t curvature;
+  int16_t preview;
+  int previewTop;
+};
+
+#endif
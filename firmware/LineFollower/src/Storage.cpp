@@ -0,0 +1,63 @@
+#include "Storage.h"
+#include <EEPROM.h>
+
+uint16_t crc16(const uint8_t *data, size_t len, uint16_t crc) {
+  // CRC-16/CCITT-FALSE, bitwise (records are small and rarely checked)
+  for (size_t i = 0; i < len; i++) {
+    crc ^= (uint16_t)data[i] << 8;
+    for (uint8_t bit = 0; bit < 8; bit++) {
+      crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+    }
+  }
+  return crc;
+}
+
+static uint16_t readU16(uint16_t addr) {
+  return EEPROM.read(addr) | (EEPROM.read(addr + 1) << 8);
+}
+
+static void writeU16(uint16_t addr, uint16_t value) {
+  EEPROM.update(addr, value & 0xFF);
+  EEPROM.update(addr + 1, value >> 8);
+}
+
+bool loadRecord(uint16_t addr, uint16_t magic, uint8_t version, void *data,
+                uint16_t len) {
+  if (addr + STORAGE_HEADER_SIZE + len > EEPROM.length()) return false;
+  if (readU16(addr) != magic || EEPROM.read(addr + 2) != version ||
+      readU16(addr + 4) != len) {
+    return false;
+  }
+
+  // Check the CRC before touching the caller's buffer
+  uint16_t crc = 0xFFFF;
+  for (uint16_t i = 0; i < len; i++) {
+    uint8_t byte = EEPROM.read(addr + STORAGE_HEADER_SIZE + i);
+    crc = crc16(&byte, 1, crc);
+  }
+  if (crc != readU16(addr + 6)) return false;
+
+  uint8_t *out = (uint8_t *)data;
+  for (uint16_t i = 0; i < len; i++) {
+    out[i] = EEPROM.read(addr + STORAGE_HEADER_SIZE + i);
+  }
+  return true;
+}
+
+void saveRecord(uint16_t addr, uint16_t magic, uint8_t version,
+                const void *data, uint16_t len) {
+  if (addr + STORAGE_HEADER_SIZE + len > EEPROM.length()) return;
+  const uint8_t *in = (const uint8_t *)data;
+
+  // Payload first: a reset mid-write leaves a header whose CRC mismatches
+  for (uint16_t i = 0; i < len; i++) {
+    EEPROM.update(addr + STORAGE_HEADER_SIZE + i, in[i]);
+  }
+  writeU16(addr, magic);
+  EEPROM.update(addr + 2, version);
+  EEPROM.update(addr + 3, 0);
+  writeU16(addr + 4, len);
+  writeU16(addr + 6, crc16(in, len));
+}
+
+void invalidateRecord(uint16_t addr) { writeU16(addr, 0xFFFF); }
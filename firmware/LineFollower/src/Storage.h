@@ -0,0 +1,26 @@
+#ifndef STORAGE_H
+#define STORAGE_H
+
+#include <Arduino.h>
+
+// Versioned, CRC-checked records in EEPROM (R4: emulated in data flash).
+// Each record is an 8-byte header followed by the payload:
+//   magic (u16), version (u8), reserved (u8), length (u16), crc16 (u16)
+// Addresses are allocated in Config.h (EEPROM_*_ADDR).
+
+#define STORAGE_HEADER_SIZE 8
+
+uint16_t crc16(const uint8_t *data, size_t len, uint16_t crc = 0xFFFF);
+
+// False (and data untouched) on wrong magic/version/length or bad CRC
+bool loadRecord(uint16_t addr, uint16_t magic, uint8_t version, void *data,
+                uint16_t len);
+
+// Only changed bytes are written, to spare flash erase cycles
+void saveRecord(uint16_t addr, uint16_t magic, uint8_t version,
+                const void *data, uint16_t len);
+
+// Corrupts the header so the next loadRecord() fails
+void invalidateRecord(uint16_t addr);
+
+#endif
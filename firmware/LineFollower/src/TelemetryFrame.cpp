@@ -0,0 +1,112 @@
+#include "TelemetryFrame.h"
+
+TelemetryFrame::TelemetryFrame() {
+  length = 0;
+  overflow = false;
+}
+
+void TelemetryFrame::begin(uint8_t type, uint16_t seq, uint32_t timestampMs) {
+  length = 0;
+  overflow = false;
+  putU8(TELEMETRY_MAGIC_0);
+  putU8(TELEMETRY_MAGIC_1);
+  putU8(TELEMETRY_VERSION);
+  putU8(type);
+  putU8(0); // Payload length, kept up to date by reserve()
+  putU16(seq);
+  putU32(timestampMs);
+}
+
+bool TelemetryFrame::reserve(uint8_t bytes) {
+  if (length + bytes > TELEMETRY_MAX_FRAME) {
+    overflow = true;
+    return false;
+  }
+  if (length >= TELEMETRY_HEADER_SIZE) {
+    buffer[4] = length + bytes - TELEMETRY_HEADER_SIZE;
+  }
+  return true;
+}
+
+void TelemetryFrame::putU8(uint8_t value) {
+  if (!reserve(1)) return;
+  buffer[length++] = value;
+}
+
+void TelemetryFrame::putU16(uint16_t value) {
+  if (!reserve(2)) return;
+  buffer[length++] = value & 0xFF;
+  buffer[length++] = value >> 8;
+}
+
+void TelemetryFrame::putI16(int32_t value) {
+  if (value > 32767) value = 32767;
+  if (value < -32768) value = -32768;
+  putU16((uint16_t)(int16_t)value);
+}
+
+void TelemetryFrame::putU32(uint32_t value) {
+  if (!reserve(4)) return;
+  buffer[length++] = value & 0xFF;
+  buffer[length++] = (value >> 8) & 0xFF;
+  buffer[length++] = (value >> 16) & 0xFF;
+  buffer[length++] = value >> 24;
+}
+
+void TelemetryFrame::encodeState(uint16_t seq, uint32_t timestampMs,
+                                 const TelemetryState &state) {
+  begin(FRAME_STATE, seq, timestampMs);
+  putU8(state.navState);
+  putU8(state.sensorState);
+  putU16(state.position);
+  for (uint8_t i = 0; i < SENSOR_COUNT; i++) putU16(state.sensors[i]);
+  // Clamp in float first: the integral term can exceed the int32 range
+  putI16((int32_t)constrain(state.pTerm, -32768.0f, 32767.0f));
+  putI16((int32_t)constrain(state.iTerm, -32768.0f, 32767.0f));
+  putI16((int32_t)constrain(state.dTerm, -32768.0f, 32767.0f));
+  putI16(state.motorLeft);
+  putI16(state.motorRight);
+  putU8(state.lineConfidence);
+  putU16(state.lineWidth);
+  putU16(state.batteryMv);
+  putU8(state.batteryState);
+  putU16(state.decisionAck);
+  putU8(state.decisionsQueued);
+}
+
+void TelemetryFrame::encodeCalibration(uint16_t seq, uint32_t timestampMs,
+                                       const TelemetryCalibration &calibration) {
+  begin(FRAME_CALIBRATION, seq, timestampMs);
+  putU8(calibration.state);
+  putU8(calibration.progress);
+  for (uint8_t i = 0; i < SENSOR_COUNT; i++) putU16(calibration.minimum[i]);
+  for (uint8_t i = 0; i < SENSOR_COUNT; i++) putU16(calibration.maximum[i]);
+}
+
+void TelemetryFrame::encodeNode(uint16_t seq, uint32_t timestampMs,
+                                const TelemetryNode &node) {
+  begin(FRAME_NODE, seq, timestampMs);
+  putU8(node.type);
+  putU8(node.confidence);
+  putU8(node.width);
+  putU32(node.edgeUs);
+  putU16(node.confirmUs > 0xFFFF ? 0xFFFF : node.confirmUs);
+}
+
+void TelemetryFrame::encodeMotorId(uint16_t seq, uint32_t timestampMs,
+                                   const TelemetryMotorId &motorId) {
+  begin(FRAME_MOTOR_ID, seq, timestampMs);
+  putU8(motorId.state);
+  putU8(motorId.progress);
+  putU16(MOTOR_PWM_PERIOD);
+  for (uint8_t side = 0; side < 2; side++) {
+    putU16(motorId.threshold[side]);
+    putU16(motorId.gain[side]);
+    putU16(motorId.tauMs[side]);
+  }
+  for (uint8_t side = 0; side < 2; side++) {
+    for (uint8_t i = 0; i < MOTOR_CURVE_POINTS; i++) {
+      putU16(motorId.curve[side][i]);
+    }
+  }
+}
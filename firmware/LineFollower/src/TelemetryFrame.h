@@ -0,0 +1,149 @@
+#ifndef TELEMETRY_FRAME_H
+#define TELEMETRY_FRAME_H
+
+#include <Arduino.h>
+#include "Config.h"
+
+// Binary telemetry protocol (little-endian, no padding).
+//
+// Header, 11 bytes:
+//   0  'C'  1  'T'          magic
+//   2  version              TELEMETRY_VERSION
+//   3  type                 TelemetryFrameType
+//   4  payload length       bytes after the header
+//   5  seq (u16)            per-frame counter, wraps
+//   7  timestamp (u32)      millis() on the cart
+//
+// FRAME_STATE payload, 35 bytes:
+//   0  nav state (u8)       NavState
+//   1  sensor state (u8)    LineSensor::SensorState
+//   2  position (u16)       0..5000
+//   4  sensors (6 x u16)    calibrated 0..1000
+//   16 P, I, D (3 x i16)    PID contributions, saturated
+//   22 left, right (2 x i16) signed PWM applied to the motors
+//   26 line confidence (u8) LineEstimator, 0..100
+//   27 line width (u16)     LineEstimator, 1000 = one sensor pitch
+//   29 battery (u16)        filtered VIN, mV
+//   31 battery state (u8)   Battery::State
+//   32 decision ack (u16)   last NAV:QUEUE decision taken, 0 before any
+//   34 decisions queued (u8) not yet taken
+//
+// FRAME_CALIBRATION payload, 26 bytes (sent instead of FRAME_STATE while
+// a CMD:CALIBRATE runs, plus once with the result):
+//   0  state (u8)           Calibrator::State
+//   1  progress (u8)        0..100 %
+//   2  minimum (6 x u16)    raw counts seen so far
+//   14 maximum (6 x u16)
+//
+// FRAME_NODE payload, 9 bytes (once per NodeDetector event, in place of a
+// FRAME_STATE):
+//   0  type (u8)            NodeEventType
+//   1  confidence (u8)      0..100
+//   2  width (u8)           black sensors
+//   3  edge (u32)           micros() of the leading edge on the cart
+//   7  confirm delay (u16)  us from the leading edge to the event
+//
+// FRAME_MOTOR_ID payload, 52 bytes (sent instead of FRAME_STATE while a
+// CMD:MOTOR_ID runs, plus once with the result; models and curves are the
+// ones installed, i.e. the previous set until a run succeeds):
+//   0  state (u8)           MotorIdentifier::State
+//   1  progress (u8)        0..100 %
+//   2  PWM period (u16)     compare counts at 100 % duty
+//   4  left model           threshold (u16, counts), gain (u16, position
+//                           counts/s per 8-bit PWM step), tau (u16, ms)
+//   10 right model
+//   16 left curve (9 x u16) compare counts, commands 0 (start) .. 255
+//   34 right curve (9 x u16)
+//
+// Decoders must accept a payload longer than they know (fields are only
+// ever appended) and skip unknown types. The version changes only when an
+// existing field moves or changes meaning. Mirrors: host/telemetry and
+// cart_controller/lib/services/telemetry_frame.dart.
+
+#define TELEMETRY_MAGIC_0 'C'
+#define TELEMETRY_MAGIC_1 'T'
+#define TELEMETRY_VERSION 1
+#define TELEMETRY_HEADER_SIZE 11
+#define TELEMETRY_MAX_FRAME 64
+
+enum TelemetryFrameType {
+  FRAME_STATE = 1,
+  FRAME_CALIBRATION = 2,
+  FRAME_NODE = 3,
+  FRAME_MOTOR_ID = 4
+};
+
+struct TelemetryState {
+  uint8_t navState;
+  uint8_t sensorState;
+  uint16_t position;
+  uint16_t sensors[SENSOR_COUNT];
+  float pTerm;
+  float iTerm;
+  float dTerm;
+  int16_t motorLeft;
+  int16_t motorRight;
+  uint8_t lineConfidence;
+  uint16_t lineWidth;
+  uint16_t batteryMv;
+  uint8_t batteryState;
+  uint16_t decisionAck;
+  uint8_t decisionsQueued;
+};
+
+struct TelemetryCalibration {
+  uint8_t state;
+  uint8_t progress;
+  const uint16_t *minimum; // SENSOR_COUNT values each
+  const uint16_t *maximum;
+};
+
+struct TelemetryNode {
+  uint8_t type;
+  uint8_t confidence;
+  uint8_t width;
+  uint32_t edgeUs;
+  uint32_t confirmUs; // Delay after the edge, saturated to u16
+};
+
+struct TelemetryMotorId {
+  uint8_t state;
+  uint8_t progress;
+  uint16_t threshold[2]; // MOTOR_LEFT, MOTOR_RIGHT
+  uint16_t gain[2];
+  uint16_t tauMs[2];
+  const uint16_t *curve[2]; // MOTOR_CURVE_POINTS values each
+};
+
+// Fixed-size frame writer; lives on the stack, never allocates.
+class TelemetryFrame {
+public:
+  TelemetryFrame();
+
+  void begin(uint8_t type, uint16_t seq, uint32_t timestampMs);
+  void putU8(uint8_t value);
+  void putU16(uint16_t value);
+  void putI16(int32_t value); // Saturates to the int16 range
+  void putU32(uint32_t value);
+
+  void encodeState(uint16_t seq, uint32_t timestampMs,
+                   const TelemetryState &state);
+  void encodeCalibration(uint16_t seq, uint32_t timestampMs,
+                         const TelemetryCalibration &calibration);
+  void encodeNode(uint16_t seq, uint32_t timestampMs, const TelemetryNode &node);
+  void encodeMotorId(uint16_t seq, uint32_t timestampMs,
+                     const TelemetryMotorId &motorId);
+
+  const uint8_t *data() { return buffer; }
+  size_t size() { return length; }
+  bool isValid() { return length >= TELEMETRY_HEADER_SIZE && !overflow; }
+
+private:
+  bool reserve(uint8_t bytes);
+
+  uint8_t buffer[TELEMETRY_MAX_FRAME];
+  uint8_t length;
+  bool overflow;
+};
+
+#endif
@@ -0,0 +1,236 @@
+#include "TrackMemory.h"
+#include "Storage.h"
+
+#define TRACK_MAGIC 0x4D54 // "TM"
+#define TRACK_VERSION 1
+
+struct TrackRecord {
+  uint8_t count;
+  uint8_t bins; // TRACK_BINS the segments were binned with
+  uint16_t reserved;
+  TrackSegment segments[TRACK_MAX_SEGMENTS];
+};
+
+static_assert(TRACK_BINS % 2 == 0 && TRACK_BINS <= TRACK_SLOTS,
+              "bins are packed in pairs, from at least as many slots");
+
+TrackMemory::TrackMemory() {
+  state = LEARN_IDLE;
+  failure = "";
+  target = 0;
+  recording = false;
+  count = 0;
+  memset(segments, 0, sizeof(segments));
+  segmentStart = 0;
+  travel = 0;
+  started = false;
+  synced = false;
+  index = 0;
+  errorLevel = 0;
+  memset(slots, 0, sizeof(slots));
+  slotTravel = TRACK_SLOT_TRAVEL;
+}
+
+bool TrackMemory::load() {
+  TrackRecord record;
+  if (!loadRecord(EEPROM_TRACK_ADDR, TRACK_MAGIC, TRACK_VERSION, &record,
+                  sizeof(record)) ||
+      record.bins != TRACK_BINS || record.count > TRACK_MAX_SEGMENTS) {
+    count = 0;
+    return false;
+  }
+  count = record.count;
+  memcpy(segments, record.segments, sizeof(segments));
+  restart();
+  return count > 0;
+}
+
+void TrackMemory::save() {
+  TrackRecord record;
+  record.count = count;
+  record.bins = TRACK_BINS;
+  record.reserved = 0;
+  memcpy(record.segments, segments, sizeof(segments));
+  saveRecord(EEPROM_TRACK_ADDR, TRACK_MAGIC, TRACK_VERSION, &record,
+             sizeof(record));
+}
+
+void TrackMemory::clear() {
+  if (state == LEARN_RUNNING) state = LEARN_IDLE;
+  count = 0;
+  synced = false;
+  invalidateRecord(EEPROM_TRACK_ADDR);
+}
+
+void TrackMemory::startLearning(uint8_t segments) {
+  target = segments;
+  count = 0; // The old map is no guide while relearning
+  recording = false;
+  synced = false;
+  failure = "";
+  state = LEARN_RUNNING;
+}
+
+void TrackMemory::cancel() {
+  if (state == LEARN_RUNNING) fail("cancelled");
+}
+
+void TrackMemory::clearResult() {
+  if (state != LEARN_RUNNING) state = LEARN_IDLE;
+}
+
+void TrackMemory::restart() {
+  started = false;
+  synced = false;
+  index = 0;
+}
+
+void TrackMemory::fail(const char *reason) {
+  failure = reason;
+  state = LEARN_FAILED;
+  load(); // Back to the saved lap, if any
+}
+
+uint8_t TrackMemory::getProgress() {
+  if (state == LEARN_DONE) return 100;
+  return target ? count * 100 / target : 0;
+}
+
+uint32_t TrackMemory::getLapMs() {
+  uint32_t total = 0;
+  for (uint8_t i = 0; i < count; i++) total += segments[i].durationMs;
+  return total;
+}
+
+void TrackMemory::update(int error, int speed, uint32_t dtUs) {
+  if (speed > 0) travel += (uint32_t)speed * dtUs / 1000;
+  if (state != LEARN_RUNNING || !recording) return;
+
+  int32_t magnitude = abs(error) * 16;
+  errorLevel += (int32_t)((int64_t)(magnitude - errorLevel) * dtUs /
+                          (TRACK_FILTER_US + dtUs));
+  int32_t curvature = errorLevel / 16 * 1000 / GOV_ERROR_FULL;
+  if (curvature > 1000) curvature = 1000;
+
+  while (travel / slotTravel >= TRACK_SLOTS) compactSlots();
+  uint16_t &slot = slots[travel / slotTravel];
+  if (curvature > slot) slot = curvature;
+}
+
+// Half the resolution: pairs of slots merge, keeping the sharper
+void TrackMemory::compactSlots() {
+  for (uint8_t i = 0; i < TRACK_SLOTS / 2; i++) {
+    slots[i] = max(slots[2 * i], slots[2 * i + 1]);
+  }
+  memset(slots + TRACK_SLOTS / 2, 0, sizeof(slots) / 2);
+  slotTravel *= 2;
+}
+
+void TrackMemory::nodeReached(unsigned long now, NodeAction action) {
+  if (state == LEARN_RUNNING) {
+    if (recording) recordSegment(now, action);
+    recording = true;
+    memset(slots, 0, sizeof(slots));
+    slotTravel = TRACK_SLOT_TRAVEL;
+  } else if (count > 0) {
+    if (!started) {
+      // First node of the run: taken as where the learning run started
+      started = true;
+      synced = true;
+      index = 0;
+    } else if (synced && matches(segments[index], action)) {
+      index = (index + 1) % count;
+    } else {
+      // Lost: the best match for the segment just driven, if any
+      uint32_t bestError = UINT32_MAX;
+      synced = false;
+      for (uint8_t i = 0; i < count; i++) {
+        if (!matches(segments[i], action)) continue;
+        uint32_t error = abs((int32_t)(travel / 100) - segments[i].travel);
+        if (error < bestError) {
+          bestError = error;
+          index = (i + 1) % count;
+          synced = true;
+        }
+      }
+    }
+  }
+  segmentStart = now;
+  travel = 0;
+}
+
+void TrackMemory::recordSegment(unsigned long now, NodeAction action) {
+  uint32_t duration = now - segmentStart;
+  if (duration > UINT16_MAX || travel / 100 > UINT16_MAX) {
+    fail("segment too long");
+    return;
+  }
+  TrackSegment &segment = segments[count];
+  segment.durationMs = duration;
+  segment.travel = travel / 100;
+  segment.action = action;
+
+  // Slots in use into TRACK_BINS bins, each the sharpest it covers
+  uint8_t used = travel / slotTravel + 1;
+  if (used > TRACK_SLOTS) used = TRACK_SLOTS;
+  memset(segment.curvature, 0, sizeof(segment.curvature));
+  for (uint8_t bin = 0; bin < TRACK_BINS; bin++) {
+    uint8_t first = bin * used / TRACK_BINS;
+    uint8_t last = (bin + 1) * used / TRACK_BINS;
+    if (last <= first) last = first + 1;
+    uint16_t sharpest = 0;
+    for (uint8_t s = first; s < last; s++) sharpest = max(sharpest, slots[s]);
+    uint8_t level = (sharpest * 15 + 500) / 1000;
+    segment.curvature[bin / 2] |= level << (bin % 2 ? 4 : 0);
+  }
+
+  if (++count >= target) {
+    // Lap closed on the node it started from: segment 0 is next
+    state = LEARN_DONE;
+    started = true;
+    synced = true;
+    index = 0;
+  }
+}
+
+bool TrackMemory::matches(const TrackSegment &segment, NodeAction action) {
+  // Stopping or not is up to the host; a turn is the track's
+  bool turned = action == NODE_LEFT || action == NODE_RIGHT;
+  bool learnedTurn = segment.action == NODE_LEFT || segment.action == NODE_RIGHT;
+  if ((turned || learnedTurn) && action != segment.action) return false;
+  int32_t driven = travel / 100;
+  return abs(driven - (int32_t)segment.travel) * 100 <=
+         (int32_t)segment.travel * TRACK_MATCH;
+}
+
+uint16_t TrackMemory::curvatureAt(const TrackSegment &segment, uint8_t bin) {
+  uint8_t level = segment.curvature[bin / 2] >> (bin % 2 ? 4 : 0) & 0x0F;
+  return level * 1000 / 15;
+}
+
+int16_t TrackMemory::preview(uint32_t ahead) {
+  if (state == LEARN_RUNNING || count == 0 || !synced) return -1;
+
+  uint16_t sharpest = 0;
+  uint8_t at = index;
+  uint32_t from = travel;
+  for (uint8_t n = 0; n <= count; n++) {
+    const TrackSegment &segment = segments[at];
+    uint32_t length = (uint32_t)segment.travel * 100;
+    uint32_t to = from + ahead;
+    if (length > 0) {
+      uint32_t first = from < length ? from * TRACK_BINS / length : TRACK_BINS - 1;
+      uint32_t last = to < length ? to * TRACK_BINS / length : TRACK_BINS - 1;
+      for (uint32_t bin = first; bin <= last; bin++) {
+        sharpest = max(sharpest, curvatureAt(segment, bin));
+      }
+    }
+    if (to < length) break;
+    // The end node is within reach
+    if (segment.action != NODE_THROUGH) return 1000;
+    ahead = from < length ? to - length : ahead;
+    from = 0;
+    at = (at + 1) % count;
+  }
+  return sharpest;
+}
@@ -0,0 +1,109 @@
+#ifndef TRACK_MEMORY_H
+#define TRACK_MEMORY_H
+
+#include <Arduino.h>
+#include "Config.h"
+
+// What the cart did at the node ending a segment
+enum NodeAction {
+  NODE_THROUGH, // Straight on without stopping
+  NODE_STOP,    // Stopped there (waited for the host, parked)
+  NODE_LEFT,
+  NODE_RIGHT
+};
+
+// One node-to-node stretch of a learned lap. Travel is the commanded speed
+// integrated over the segment, so it stands for distance whatever speed the
+// lap is driven at; curvature is sampled evenly over it.
+struct TrackSegment {
+  uint16_t durationMs;
+  uint16_t travel; // Speed x 100 ms
+  uint8_t action;  // NodeAction
+  uint8_t curvature[TRACK_BINS / 2]; // 0..15 (= 0..1000) per bin, low nibble first
+};
+
+// Track learning (CMD:LEARN): lap N is planned off lap 1.
+//
+// A learning run records the next `segments` node-to-node segments, from
+// the first node seen, as one lap: duration, travel, the curvature profile
+// (standing line error, as the SpeedGovernor reads it) and what the cart did
+// at the end node. The recording buffer halves its resolution whenever a
+// segment outgrows it, so segments of any length fit, then is binned.
+//
+// Afterwards the map is replayed: each node event moves on one segment, and
+// preview() gives the highest curvature the map has within a given travel
+// ahead, turns and stops counting as full curvature, so the governor brakes
+// before them and runs flat out where the map shows none. A run is assumed
+// to start like the learning one (segment 0 from its first node); a finished
+// segment whose travel or turn does not match sends the memory looking for
+// the segment that does match, and with none it stays out of the way.
+class TrackMemory {
+public:
+  enum State {
+    LEARN_IDLE,
+    LEARN_RUNNING,
+    LEARN_DONE,  // Map replaced, until clearResult()
+    LEARN_FAILED // Cancelled or a segment too long; saved map back
+  };
+
+  TrackMemory();
+
+  // Saved lap, if any (boot)
+  bool load();
+  void save(); // Parked only: stalls the loop
+  void clear(); // Forgets the map, here and in EEPROM
+
+  void startLearning(uint8_t segments);
+  void cancel();
+  void clearResult(); // DONE/FAILED -> IDLE once reported
+  void restart();     // New run: the next node starts segment 0
+
+  // Every following tick, with the commanded base speed
+  void update(int error, int speed, uint32_t dtUs);
+  // Every node the Navigator takes, with what it did there
+  void nodeReached(unsigned long now, NodeAction action);
+
+  // Highest curvature (0..1000) within `ahead` (speed x ms) from here, or -1
+  // without a map in step with the cart
+  int16_t preview(uint32_t ahead);
+
+  State getState() { return state; }
+  bool isLearning() { return state == LEARN_RUNNING; }
+  const char *getFailure() { return failure; }
+  uint8_t getProgress(); // 0..100
+  uint8_t getSegmentCount() { return count; }
+  const TrackSegment &getSegment(uint8_t index) { return segments[index]; }
+  bool isSynced() { return synced; }
+  uint8_t getSegmentIndex() { return index; } // Being driven, when synced
+  uint32_t getTravel() { return travel; } // Into it (speed x ms)
+  uint32_t getLapMs();
+
+private:
+  void recordSegment(unsigned long now, NodeAction action);
+  void compactSlots();
+  bool matches(const TrackSegment &segment, NodeAction action);
+  uint16_t curvatureAt(const TrackSegment &segment, uint8_t bin);
+  void fail(const char *reason);
+
+  State state;
+  const char *failure;
+  uint8_t target;  // Segments to learn
+  bool recording;  // Past the first node of the learning run
+
+  uint8_t count;   // Segments in the map
+  TrackSegment segments[TRACK_MAX_SEGMENTS];
+
+  // The segment being driven
+  unsigned long segmentStart;
+  uint32_t travel;      // Speed x ms
+  bool started;         // A node seen since restart()
+  bool synced;
+  uint8_t index;
+
+  // Recording
+  int32_t errorLevel;   // Filtered |error| x 16
+  uint16_t slots[TRACK_SLOTS];
+  uint32_t slotTravel;  // Travel per slot
+};
+
+#endif
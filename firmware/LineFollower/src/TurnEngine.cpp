@@ -0,0 +1,121 @@
+#include "TurnEngine.h"
+
+// Moves a wheel speed (x1000) towards target by at most accel over dtUs
+static int32_t slew(int32_t milli, int target, int accel, uint32_t dtUs) {
+  int32_t step = target * 1000L - milli;
+  int32_t max = (int32_t)((int64_t)accel * dtUs / 1000);
+  return milli + constrain(step, -max, max);
+}
+
+TurnEngine::TurnEngine() {
+  setProfile(TURN_SPEED, TURN_INNER, TURN_CREEP_MS, TURN_ACCEL, BASE_SPEED,
+             TURN_TIMEOUT_MS);
+  blackThreshold = LINE_BLACK_THRESHOLD;
+  phase = TURN_IDLE;
+  dir = DIR_LEFT;
+  startTime = 0;
+  leftMilli = rightMilli = 0;
+  left = right = 0;
+  cleared = false;
+  captured = false;
+  edge = 0;
+  edgeUs = 0;
+  pitchUs = 0;
+}
+
+void TurnEngine::setProfile(int cruise, int inner, unsigned long creepMs,
+                            int accel, int exitSpeed,
+                            unsigned long timeoutMs) {
+  this->cruise = cruise;
+  this->inner = inner;
+  // A pivot has to bring the axle, well behind the array, onto the node
+  if (creepMs == 0 && inner < 0) creepMs = TURN_PIVOT_CREEP_MS;
+  this->creepMs = creepMs;
+  this->accel = accel;
+  // Arriving faster than cruising would only speed the turn up at the end
+  this->exitSpeed = exitSpeed < cruise ? exitSpeed : cruise;
+  this->timeoutMs = timeoutMs;
+}
+
+void TurnEngine::start(Direction dir, int entrySpeed, unsigned long now) {
+  this->dir = dir;
+  startTime = now;
+  leftMilli = rightMilli = entrySpeed * 1000L;
+  left = right = entrySpeed;
+  cleared = false;
+  captured = false;
+  edge = 0;
+  pitchUs = 0;
+  phase = creepMs > 0 ? TURN_CREEP : TURN_SWEEP;
+}
+
+bool TurnEngine::update(const uint16_t *values, uint32_t dtUs,
+                        unsigned long now, uint32_t nowUs) {
+  if (phase == TURN_IDLE) return false;
+  if (now - startTime > timeoutMs) {
+    finish(false);
+    return false;
+  }
+
+  // Dark sensors counted from the outer end (high indexes are on the left),
+  // up to the innermost one: where the leading edge of the line is
+  uint8_t reached = 0;
+  for (uint8_t k = 0; k < SENSOR_COUNT; k++) {
+    uint8_t i = dir == DIR_LEFT ? SENSOR_COUNT - 1 - k : k;
+    if (values[i] > blackThreshold) reached = k + 1;
+  }
+
+  int outerTarget = cruise;
+  int innerTarget;
+  if (phase == TURN_CREEP) {
+    if (now - startTime >= creepMs) phase = TURN_SWEEP;
+    innerTarget = cruise;
+  }
+  if (phase == TURN_SWEEP) {
+    if (reached == 0) cleared = true;
+    // Past the first sensor already when the filter held it back
+    if (cleared && reached >= 1) {
+      phase = TURN_ALIGN;
+      edge = reached;
+      edgeUs = nowUs;
+    }
+  }
+  if (phase == TURN_ALIGN) {
+    if (reached > edge) {
+      pitchUs = (nowUs - edgeUs) / (reached - edge);
+      edge = reached;
+      edgeUs = nowUs;
+    }
+    // The centre lies between the middle two sensors
+    int32_t pitchesLeft = SENSOR_COUNT / 2 - edge;
+    if (pitchesLeft < 0) {
+      finish(true);
+      return false;
+    }
+    if (pitchUs > 0) {
+      int32_t arrivalUs = (int32_t)(pitchesLeft * pitchUs + pitchUs / 2) -
+                          (int32_t)(nowUs - edgeUs);
+      if (arrivalUs <= TURN_HANDOFF_US) {
+        finish(true);
+        return false;
+      }
+      // Slow enough to be down to the exit speed as the line arrives
+      int64_t reachable = exitSpeed + (int64_t)accel * arrivalUs / 1000000;
+      if (reachable < outerTarget) outerTarget = (int)reachable;
+    }
+  }
+  if (phase != TURN_CREEP) innerTarget = outerTarget * inner / 100;
+
+  int leftTarget = dir == DIR_LEFT ? innerTarget : outerTarget;
+  int rightTarget = dir == DIR_LEFT ? outerTarget : innerTarget;
+  leftMilli = slew(leftMilli, leftTarget, accel, dtUs);
+  rightMilli = slew(rightMilli, rightTarget, accel, dtUs);
+  left = leftMilli / 1000;
+  right = rightMilli / 1000;
+  return true;
+}
+
+void TurnEngine::finish(bool found) {
+  captured = found;
+  phase = TURN_IDLE;
+}
@@ -0,0 +1,85 @@
+#ifndef TURN_ENGINE_H
+#define TURN_ENGINE_H
+
+#include <Arduino.h>
+#include "Config.h"
+#include "GridMap.h"
+
+// Turns at a node (NAV_TURNING), driven by the line instead of a clock.
+//
+//  CREEP  straight on for turn.creep_ms, easing to speed.turn: brings the
+//         turning centre forward onto the node (the array is ahead of it).
+//         0 creeps TURN_PIVOT_CREEP_MS when the inner wheel reverses, and
+//         not at all about a stopped one, which is about as far back
+//  SWEEP  the outer wheel ramps up to speed.turn at turn.accel, the inner
+//         one to turn.inner % of it (-100: pivot on the axle centre, 0: on
+//         the inner wheel). Waits for the array to come off the old line
+//         and the new one to reach the outer sensor
+//  ALIGN  the new line's leading edge crosses the array towards the centre.
+//         The time it took from one sensor to the next predicts when it
+//         gets there, and the rotation slows down just in time to arrive
+//         at speed.base, the speed following restarts at
+//
+// The turn ends TURN_HANDOFF_US before the edge reaches the centre, still
+// turning: the PID takes over from there, with no stop in between. Wheel
+// speeds change at turn.accel at most, from the speed the turn started at.
+//
+// No wider arcs: the motor deadband keeps a forward inner wheel near the
+// outer one's speed, and the cart would run far past the new line before
+// the array came round to it.
+class TurnEngine {
+public:
+  enum Phase {
+    TURN_IDLE,
+    TURN_CREEP,
+    TURN_SWEEP,
+    TURN_ALIGN
+  };
+
+  TurnEngine();
+
+  // Speeds in speed units, accel in speed units per second
+  void setProfile(int cruise, int inner, unsigned long creepMs, int accel,
+                  int exitSpeed, unsigned long timeoutMs);
+  void setBlackThreshold(uint16_t threshold) { blackThreshold = threshold; }
+
+  // entrySpeed: both wheels' speed as the turn starts (0 from a stop)
+  void start(Direction dir, int entrySpeed, unsigned long now);
+  // One call per NAV_TURNING tick with the calibrated readings; false once
+  // the turn is over (see isCaptured())
+  bool update(const uint16_t *values, uint32_t dtUs, unsigned long now,
+              uint32_t nowUs);
+  void cancel() { phase = TURN_IDLE; }
+
+  bool isActive() { return phase != TURN_IDLE; }
+  Phase getPhase() { return phase; }
+  bool isCaptured() { return captured; } // Last turn found its line
+  int getLeftSpeed() { return left; }
+  int getRightSpeed() { return right; }
+
+private:
+  void finish(bool found);
+
+  int cruise;
+  int inner;   // % of the outer wheel
+  unsigned long creepMs;
+  int accel;
+  int exitSpeed;
+  unsigned long timeoutMs;
+  uint16_t blackThreshold;
+
+  Phase phase;
+  Direction dir;
+  unsigned long startTime;
+  int32_t leftMilli;  // Wheel speeds as commanded, x1000
+  int32_t rightMilli;
+  int left, right;
+  bool cleared;       // Array came off the old line
+  bool captured;
+
+  uint8_t edge;       // Sensors from the outer end the new line reached
+  uint32_t edgeUs;    // When it reached the last of them
+  uint32_t pitchUs;   // Time it took from the one before, 0 = not yet
+};
+
+#endif
@@ -0,0 +1,70 @@
+// Host stand-in for the RA4M1 background scan (LineFollower/src/SensorScan.h).
+// Scans complete on a fixed virtual-time grid starting at begin; a pickup
+// returns the latest one, sampled at pickup time through the analog inputs
+// (at most one period late, which the simulator cannot tell apart). The ISR
+// time of every scan completed since the previous pickup is charged then.
+#include "HostHal.h"
+#include "SensorScan.h"
+
+namespace {
+
+bool running = false;
+uint8_t scanPins[SENSOR_COUNT];
+uint8_t scanCount = 0;
+uint8_t scanAux = SCAN_NO_AUX;
+uint32_t scanPeriodUs = 1;
+uint64_t startUs = 0;
+uint32_t chargedSeq = 0;
+
+// Conversions averaged per channel, as the ADC does in hardware
+const uint8_t SCAN_AVERAGE = SENSOR_OVERSAMPLE;
+
+// Longer gaps between pickups are setup() or delays, where the ISR time
+// only stretches wall time; charging it all at once would show up as one
+// huge control tick
+const uint32_t SCAN_CHARGE_LIMIT = 16;
+
+} // namespace
+
+bool sensorScanBegin(const uint8_t *pins, uint8_t count, uint32_t periodUs,
+                     uint8_t auxPin) {
+  if (count > SENSOR_COUNT || periodUs == 0) return false;
+  memcpy(scanPins, pins, count);
+  scanCount = count;
+  scanAux = auxPin;
+  scanPeriodUs = periodUs;
+  startUs = host::nowMicros();
+  chargedSeq = 0;
+  running = true;
+  return true;
+}
+
+void sensorScanEnd() { running = false; }
+
+bool sensorScanRunning() { return running; }
+
+bool sensorScanLatest(SensorFrame &frame) {
+  if (!running) return false;
+
+  // The first scan is collected one period after it was started
+  uint64_t elapsed = host::nowMicros() - startUs;
+  uint32_t seq = elapsed / scanPeriodUs;
+  if (seq == 0) return false;
+
+  uint32_t pending = seq - chargedSeq;
+  if (pending > SCAN_CHARGE_LIMIT) pending = SCAN_CHARGE_LIMIT;
+  host::advanceMicros((uint64_t)pending * host::costModel().adcScanFrame);
+  chargedSeq = seq;
+
+  for (uint8_t i = 0; i < scanCount; i++) {
+    uint32_t sum = 0;
+    for (uint8_t j = 0; j < SCAN_AVERAGE; j++) {
+      sum += host::sampleAnalog(scanPins[i]);
+    }
+    frame.values[i] = (sum + SCAN_AVERAGE / 2) / SCAN_AVERAGE;
+  }
+  frame.aux = scanAux != SCAN_NO_AUX ? host::sampleAnalog(scanAux) : 0;
+  frame.seq = seq;
+  frame.timestampUs = (uint32_t)(startUs + (uint64_t)seq * scanPeriodUs);
+  return true;
+}
@@ -0,0 +1,3 @@
+// Builds the unmodified sketch as an ordinary translation unit so the host
+// runners can call setup()/loop() exactly as the Arduino core does.
+#include "../LineFollower/LineFollower.ino"
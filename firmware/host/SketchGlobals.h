@@ -0,0 +1,42 @@
+#ifndef HOST_SKETCH_GLOBALS_H
+#define HOST_SKETCH_GLOBALS_H
+
+// Globals and entry points defined by LineFollower.ino (see Sketch.cpp).
+// Runners link against the sketch and use these to inspect its state.
+
+#include "AutoTuner.h"
+#include "Battery.h"
+#include "Calibrator.h"
+#include "IterativeLearner.h"
+#include "LedController.h"
+#include "LineSensor.h"
+#include "MotorController.h"
+#include "MotorIdentifier.h"
+#include "Navigator.h"
+#include "NetworkManager.h"
+#include "PIDController.h"
+#include "Profiler.h"
+#include "Scheduler.h"
+#include "TrackMemory.h"
+#include "TurnEngine.h"
+
+extern NetworkManager network;
+extern LedController led;
+extern LineSensor sensors;
+extern MotorController motors;
+extern PIDController pid;
+extern Navigator navigator;
+extern Scheduler scheduler;
+extern Profiler profiler;
+extern Calibrator calibrator;
+extern MotorIdentifier motorId;
+extern AutoTuner autoTuner;
+extern Battery battery;
+extern TrackMemory trackMemory;
+extern IterativeLearner ilc;
+extern TurnEngine turnEngine;
+
+void setup();
+void loop();
+
+#endif
@@ -0,0 +1,239 @@
+#include "HostHal.h"
+
+#include <algorithm>
+#include <cinttypes>
+
+HardwareSerial Serial;
+
+namespace {
+
+uint64_t clockUs = 0;
+host::CostModel costs;
+
+int analogValues[NUM_DIGITAL_PINS] = {0};
+std::function<int(uint8_t)> analogHandler;
+int analogReadBits = 10;
+int analogWriteBits = 8;
+
+uint8_t pinLevels[NUM_DIGITAL_PINS] = {0};
+float pinDuties[NUM_DIGITAL_PINS] = {0};
+std::function<void(uint8_t)> outputListener;
+
+bool serialEcho = false;
+std::string serialBuffer;
+const size_t SERIAL_CAPTURE_LIMIT = 1 << 20;
+
+uint32_t rngState = 1;
+
+void charge(uint32_t us) { clockUs += us; }
+
+void notifyOutput(uint8_t pin) {
+  if (outputListener) outputListener(pin);
+}
+
+std::string formatInteger(unsigned long long value, bool negative, int base) {
+  char buf[72];
+  if (base == HEX) {
+    snprintf(buf, sizeof(buf), "%s%llX", negative ? "-" : "", value);
+  } else {
+    snprintf(buf, sizeof(buf), "%s%llu", negative ? "-" : "", value);
+  }
+  return buf;
+}
+
+std::string formatFloat(double value, int digits) {
+  char buf[64];
+  snprintf(buf, sizeof(buf), "%.*f", digits, value);
+  return buf;
+}
+
+} // namespace
+
+// --- host:: control surface ---
+
+namespace host {
+
+uint64_t nowMicros() { return clockUs; }
+void advanceMicros(uint64_t us) { clockUs += us; }
+void resetClock() { clockUs = 0; }
+CostModel &costModel() { return costs; }
+// Plain uint32_t fields only; the default initialisers make it non-trivial
+void zeroCostModel() { memset(static_cast<void *>(&costs), 0, sizeof(costs)); }
+
+void setAnalogValue(uint8_t pin, int value) {
+  if (pin < NUM_DIGITAL_PINS) analogValues[pin] = value;
+}
+
+void setAnalogReadHandler(std::function<int(uint8_t)> handler) {
+  analogHandler = std::move(handler);
+}
+
+int sampleAnalog(uint8_t pin) {
+  int value = analogHandler ? analogHandler(pin)
+                            : (pin < NUM_DIGITAL_PINS ? analogValues[pin] : 0);
+  int maxValue = (1 << analogReadBits) - 1;
+  return std::max(0, std::min(value, maxValue));
+}
+
+uint8_t pinLevel(uint8_t pin) {
+  return pin < NUM_DIGITAL_PINS ? pinLevels[pin] : 0;
+}
+
+float pinDuty(uint8_t pin) {
+  return pin < NUM_DIGITAL_PINS ? pinDuties[pin] : 0.0f;
+}
+
+void setDigitalInput(uint8_t pin, uint8_t level) {
+  if (pin < NUM_DIGITAL_PINS) pinLevels[pin] = level;
+}
+
+void writePinDuty(uint8_t pin, float duty) {
+  if (pin >= NUM_DIGITAL_PINS) return;
+  pinDuties[pin] = std::max(0.0f, std::min(duty, 1.0f));
+  notifyOutput(pin);
+}
+
+void setOutputListener(std::function<void(uint8_t)> listener) {
+  outputListener = std::move(listener);
+}
+
+void setSerialEcho(bool echo) { serialEcho = echo; }
+const std::string &serialOutput() { return serialBuffer; }
+void clearSerialOutput() { serialBuffer.clear(); }
+
+} // namespace host
+
+// --- Time ---
+
+unsigned long millis() { return (unsigned long)(clockUs / 1000); }
+unsigned long micros() { return (unsigned long)(uint32_t)clockUs; }
+void delay(unsigned long ms) { clockUs += (uint64_t)ms * 1000; }
+void delayMicroseconds(unsigned int us) { clockUs += us; }
+void yield() {}
+
+// --- GPIO ---
+
+void pinMode(uint8_t, uint8_t) {}
+
+void digitalWrite(uint8_t pin, uint8_t value) {
+  charge(costs.digitalWrite);
+  if (pin >= NUM_DIGITAL_PINS) return;
+  pinLevels[pin] = value ? HIGH : LOW;
+  notifyOutput(pin);
+}
+
+int digitalRead(uint8_t pin) {
+  return pin < NUM_DIGITAL_PINS ? pinLevels[pin] : LOW;
+}
+
+int analogRead(uint8_t pin) {
+  charge(costs.analogRead);
+  return host::sampleAnalog(pin);
+}
+
+void analogWrite(uint8_t pin, int value) {
+  charge(costs.analogWrite);
+  if (pin >= NUM_DIGITAL_PINS) return;
+  int maxValue = (1 << analogWriteBits) - 1;
+  value = std::max(0, std::min(value, maxValue));
+  pinDuties[pin] = (float)value / maxValue;
+  notifyOutput(pin);
+}
+
+void analogReadResolution(int bits) { analogReadBits = bits; }
+void analogWriteResolution(int bits) { analogWriteBits = bits; }
+
+unsigned long pulseIn(uint8_t, uint8_t, unsigned long timeout) {
+  // No echo ever arrives on the host: behave like a timed-out measurement
+  clockUs += timeout;
+  return 0;
+}
+
+long map(long x, long inMin, long inMax, long outMin, long outMax) {
+  return (x - inMin) * (outMax - outMin) / (inMax - inMin) + outMin;
+}
+
+void randomSeed(unsigned long seed) { rngState = seed ? (uint32_t)seed : 1; }
+
+long random(long howBig) {
+  if (howBig <= 0) return 0;
+  // xorshift32: deterministic across platforms
+  rngState ^= rngState << 13;
+  rngState ^= rngState >> 17;
+  rngState ^= rngState << 5;
+  return (long)(rngState % (uint32_t)howBig);
+}
+
+long random(long howSmall, long howBig) {
+  if (howSmall >= howBig) return howSmall;
+  return random(howBig - howSmall) + howSmall;
+}
+
+// --- String ---
+
+String::String(int value, unsigned char base)
+    : s(formatInteger(value < 0 ? -(long long)value : value, value < 0, base)) {}
+String::String(unsigned int value, unsigned char base)
+    : s(formatInteger(value, false, base)) {}
+String::String(long value, unsigned char base)
+    : s(formatInteger(value < 0 ? -(long long)value : value, value < 0, base)) {}
+String::String(unsigned long value, unsigned char base)
+    : s(formatInteger(value, false, base)) {}
+String::String(float value, unsigned char decimalPlaces)
+    : s(formatFloat(value, decimalPlaces)) {}
+String::String(double value, unsigned char decimalPlaces)
+    : s(formatFloat(value, decimalPlaces)) {}
+
+String IPAddress::toString() const {
+  char buf[16];
+  snprintf(buf, sizeof(buf), "%u.%u.%u.%u", addr[0], addr[1], addr[2], addr[3]);
+  return String(buf);
+}
+
+// --- Serial ---
+
+void HardwareSerial::begin(unsigned long) {}
+
+size_t HardwareSerial::write(uint8_t c) {
+  charge(costs.serialByte);
+  if (serialBuffer.size() >= SERIAL_CAPTURE_LIMIT) {
+    serialBuffer.erase(0, SERIAL_CAPTURE_LIMIT / 2);
+  }
+  serialBuffer += (char)c;
+  if (serialEcho) fputc(c, stdout);
+  return 1;
+}
+
+size_t HardwareSerial::write(const uint8_t *buffer, size_t size) {
+  for (size_t i = 0; i < size; i++) write(buffer[i]);
+  return size;
+}
+
+size_t HardwareSerial::write(const char *str) {
+  return write((const uint8_t *)str, strlen(str));
+}
+
+size_t HardwareSerial::print(const char *str) { return write(str); }
+size_t HardwareSerial::print(const String &str) { return write(str.c_str()); }
+size_t HardwareSerial::print(char c) { return write((uint8_t)c); }
+
+size_t HardwareSerial::print(int value, int base) {
+  return print(String((long)value, base));
+}
+size_t HardwareSerial::print(unsigned int value, int base) {
+  return print(String((unsigned long)value, base));
+}
+size_t HardwareSerial::print(long value, int base) {
+  return print(String(value, base));
+}
+size_t HardwareSerial::print(unsigned long value, int base) {
+  return print(String(value, base));
+}
+size_t HardwareSerial::print(double value, int digits) {
+  return print(String(value, digits));
+}
+size_t HardwareSerial::print(const IPAddress &ip) {
+  return print(ip.toString());
+}
+
+size_t HardwareSerial::println() { return write("\r\n"); }
@@ -0,0 +1,204 @@
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+// Host stand-in for the Arduino core (Uno R4 WiFi flavour).
+// Only the API surface used by the LineFollower firmware is provided.
+// Time is virtual: millis()/micros() only move when delay() is called or
+// when a HAL call charges its modelled cost (see HostHal.h).
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+typedef bool boolean;
+typedef uint8_t byte;
+
+#define HIGH 0x1
+#define LOW 0x0
+
+#define INPUT 0x0
+#define OUTPUT 0x1
+#define INPUT_PULLUP 0x2
+
+#define PI 3.1415926535897932384626433832795
+
+#define DEC 10
+#define HEX 16
+
+// Uno R4 WiFi analog pin numbering
+#define A0 14
+#define A1 15
+#define A2 16
+#define A3 17
+#define A4 18
+#define A5 19
+#define LED_BUILTIN 13
+
+#define NUM_DIGITAL_PINS 20
+
+#define constrain(amt, low, high)                                              \
+  ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+// As ArduinoCore-API: templates rather than macros in C++
+template <class T, class L>
+auto min(const T &a, const L &b) -> decltype((b < a) ? b : a) {
+  return (b < a) ? b : a;
+}
+template <class T, class L>
+auto max(const T &a, const L &b) -> decltype((b < a) ? b : a) {
+  return (a < b) ? b : a;
+}
+
+// --- Time ---
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+void yield();
+
+// --- GPIO ---
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+int digitalRead(uint8_t pin);
+int analogRead(uint8_t pin);
+void analogWrite(uint8_t pin, int value);
+void analogReadResolution(int bits);
+void analogWriteResolution(int bits);
+unsigned long pulseIn(uint8_t pin, uint8_t state, unsigned long timeout = 1000000UL);
+
+long map(long x, long inMin, long inMax, long outMin, long outMax);
+long random(long howBig);
+long random(long howSmall, long howBig);
+void randomSeed(unsigned long seed);
+
+// --- String ---
+class String {
+public:
+  String() {}
+  String(const char *cstr) : s(cstr ? cstr : "") {}
+  String(const std::string &str) : s(str) {}
+  String(char c) : s(1, c) {}
+  explicit String(int value, unsigned char base = 10);
+  explicit String(unsigned int value, unsigned char base = 10);
+  explicit String(long value, unsigned char base = 10);
+  explicit String(unsigned long value, unsigned char base = 10);
+  explicit String(float value, unsigned char decimalPlaces = 2);
+  explicit String(double value, unsigned char decimalPlaces = 2);
+
+  unsigned int length() const { return (unsigned int)s.size(); }
+  const char *c_str() const { return s.c_str(); }
+
+  String &operator+=(const String &rhs) {
+    s += rhs.s;
+    return *this;
+  }
+  String &operator+=(const char *rhs) {
+    s += rhs;
+    return *this;
+  }
+  String &operator+=(char c) {
+    s += c;
+    return *this;
+  }
+
+  bool operator==(const String &rhs) const { return s == rhs.s; }
+  bool operator==(const char *rhs) const { return s == rhs; }
+  bool operator!=(const String &rhs) const { return s != rhs.s; }
+  bool operator!=(const char *rhs) const { return s != rhs; }
+  bool operator<(const String &rhs) const { return s < rhs.s; }
+
+  bool startsWith(const String &prefix) const {
+    return s.compare(0, prefix.s.size(), prefix.s) == 0;
+  }
+  String substring(unsigned int from) const {
+    return from >= s.size() ? String() : String(s.substr(from));
+  }
+  String substring(unsigned int from, unsigned int to) const {
+    if (from > to) std::swap(from, to);
+    if (from >= s.size()) return String();
+    return String(s.substr(from, to - from));
+  }
+  int indexOf(char c) const {
+    size_t pos = s.find(c);
+    return pos == std::string::npos ? -1 : (int)pos;
+  }
+  char charAt(unsigned int index) const {
+    return index < s.size() ? s[index] : 0;
+  }
+  long toInt() const { return atol(s.c_str()); }
+  float toFloat() const { return (float)atof(s.c_str()); }
+
+  friend String operator+(const String &lhs, const String &rhs) {
+    return String(lhs.s + rhs.s);
+  }
+  friend String operator+(const String &lhs, const char *rhs) {
+    return String(lhs.s + rhs);
+  }
+  friend String operator+(const char *lhs, const String &rhs) {
+    return String(lhs + rhs.s);
+  }
+
+private:
+  std::string s;
+};
+
+// --- IPAddress ---
+class IPAddress {
+public:
+  IPAddress() : addr{0, 0, 0, 0} {}
+  IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d) : addr{a, b, c, d} {}
+
+  uint8_t operator[](int index) const { return addr[index]; }
+  uint8_t &operator[](int index) { return addr[index]; }
+  bool operator==(const IPAddress &rhs) const {
+    return memcmp(addr, rhs.addr, sizeof(addr)) == 0;
+  }
+  bool operator!=(const IPAddress &rhs) const { return !(*this == rhs); }
+
+  String toString() const;
+
+private:
+  uint8_t addr[4];
+};
+
+// --- Serial ---
+class HardwareSerial {
+public:
+  void begin(unsigned long baud);
+  explicit operator bool() const { return true; }
+
+  size_t write(uint8_t c);
+  size_t write(const char *str);
+  size_t write(const uint8_t *buffer, size_t size);
+
+  size_t print(const char *str);
+  size_t print(const String &str);
+  size_t print(char c);
+  size_t print(int value, int base = DEC);
+  size_t print(unsigned int value, int base = DEC);
+  size_t print(long value, int base = DEC);
+  size_t print(unsigned long value, int base = DEC);
+  size_t print(double value, int digits = 2);
+  size_t print(const IPAddress &ip);
+
+  size_t println();
+  template <typename T> size_t println(const T &value) {
+    size_t n = print(value);
+    return n + println();
+  }
+  template <typename T> size_t println(const T &value, int format) {
+    size_t n = print(value, format);
+    return n + println();
+  }
+
+  int available() { return 0; }
+  int read() { return -1; }
+  void flush() {}
+};
+
+extern HardwareSerial Serial;
+
+#endif
@@ -0,0 +1,29 @@
+#include "Arduino_LED_Matrix.h"
+#include "HostHal.h"
+
+namespace {
+uint32_t currentFrame[3] = {0, 0, 0};
+}
+
+namespace host {
+const uint32_t *matrixFrame() { return currentFrame; }
+} // namespace host
+
+void ArduinoLEDMatrix::loadFrame(const uint32_t buffer[3]) {
+  host::advanceMicros(host::costModel().matrixFrame);
+  memcpy(currentFrame, buffer, sizeof(currentFrame));
+}
+
+void ArduinoLEDMatrix::loadPixels(uint8_t *pixels, uint32_t size) {
+  // Pack row-major pixels MSB-first into three 32-bit words like the core
+  uint32_t frame[3] = {0, 0, 0};
+  for (uint32_t i = 0; i < size && i < 96; i++) {
+    if (pixels[i]) frame[i / 32] |= 1UL << (31 - (i % 32));
+  }
+  loadFrame(frame);
+}
+
+void ArduinoLEDMatrix::clear() {
+  const uint32_t blank[3] = {0, 0, 0};
+  loadFrame(blank);
+}
@@ -0,0 +1,20 @@
+#ifndef HOST_ARDUINO_LED_MATRIX_H
+#define HOST_ARDUINO_LED_MATRIX_H
+
+// Host stand-in for the Uno R4 WiFi 12x8 LED matrix. Frames are only
+// recorded so runners can inspect what the firmware last displayed.
+
+#include <Arduino.h>
+
+#define renderBitmap(bitmap, rows, columns)                                    \
+  loadPixels(&bitmap[0][0], rows *columns)
+
+class ArduinoLEDMatrix {
+public:
+  void begin() {}
+  void loadFrame(const uint32_t buffer[3]);
+  void loadPixels(uint8_t *pixels, uint32_t size);
+  void clear();
+};
+
+#endif
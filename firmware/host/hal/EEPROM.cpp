@@ -0,0 +1,39 @@
+#include "EEPROM.h"
+#include "HostHal.h"
+
+namespace {
+uint8_t storage[EEPROM_SIZE];
+bool initialized = false;
+uint32_t writes = 0;
+
+uint8_t *cells() {
+  if (!initialized) {
+    memset(storage, 0xFF, sizeof(storage));
+    initialized = true;
+  }
+  return storage;
+}
+} // namespace
+
+namespace host {
+uint8_t *eepromData() { return cells(); }
+void eraseEeprom() { memset(cells(), 0xFF, EEPROM_SIZE); }
+uint32_t eepromWrites() { return writes; }
+} // namespace host
+
+EEPROMClass EEPROM;
+
+uint8_t EEPROMClass::read(int idx) {
+  if (idx < 0 || idx >= EEPROM_SIZE) return 0xFF;
+  return cells()[idx];
+}
+
+void EEPROMClass::write(int idx, uint8_t val) {
+  if (idx < 0 || idx >= EEPROM_SIZE) return;
+  cells()[idx] = val;
+  writes++;
+}
+
+void EEPROMClass::update(int idx, uint8_t val) {
+  if (read(idx) != val) write(idx, val);
+}
@@ -0,0 +1,34 @@
+#ifndef HOST_EEPROM_H
+#define HOST_EEPROM_H
+
+// Host stand-in for the Arduino EEPROM library. On the Uno R4 it emulates
+// EEPROM in the RA4M1's 8 KB data flash; here it is a RAM array that
+// starts erased (0xFF) and lives for the process (see host::eepromData()).
+
+#include <Arduino.h>
+
+#define EEPROM_SIZE 8192
+
+class EEPROMClass {
+public:
+  uint8_t read(int idx);
+  void write(int idx, uint8_t val);
+  void update(int idx, uint8_t val);
+  uint16_t length() { return EEPROM_SIZE; }
+
+  template <typename T> T &get(int idx, T &t) {
+    uint8_t *p = (uint8_t *)&t;
+    for (size_t i = 0; i < sizeof(T); i++) p[i] = read(idx + i);
+    return t;
+  }
+
+  template <typename T> const T &put(int idx, const T &t) {
+    const uint8_t *p = (const uint8_t *)&t;
+    for (size_t i = 0; i < sizeof(T); i++) update(idx + i, p[i]);
+    return t;
+  }
+};
+
+extern EEPROMClass EEPROM;
+
+#endif
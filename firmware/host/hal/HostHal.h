@@ -0,0 +1,95 @@
+#ifndef HOST_HAL_H
+#define HOST_HAL_H
+
+// Control surface of the host HAL. The firmware never includes this file;
+// runners and simulators use it to drive virtual time, feed the analog
+// inputs, observe the outputs and talk to the sketch over "UDP".
+
+#include <Arduino.h>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace host {
+
+// --- Virtual time ---
+uint64_t nowMicros();
+void advanceMicros(uint64_t us);
+void resetClock();
+
+// Approximate execution cost of HAL calls, charged to the virtual clock so
+// that loop latency measured in micros() resembles the Uno R4 WiFi.
+// All values in microseconds. zeroCostModel() sets every field to 0 (not a
+// positional initialiser, which silently misses fields added later).
+struct CostModel {
+  uint32_t analogRead = 10;   // RA4M1 ADC conversion + core overhead
+  uint32_t analogWrite = 2;
+  uint32_t pwmWrite = 1;      // GPT compare update through PwmOut
+  uint32_t digitalWrite = 1;
+  uint32_t serialByte = 1;    // USB CDC, no UART throttling
+  uint32_t udpParse = 300;    // WiFiS3 goes through the ESP32-S3 modem link
+  uint32_t udpBeginPacket = 500; // Each send step is one modem command
+  uint32_t udpWrite = 500;
+  uint32_t udpEndPacket = 500;
+  uint32_t wifiStatus = 200;
+  uint32_t matrixFrame = 5;
+  uint32_t adcScanFrame = 3;  // ISR time per background scan (SensorScan)
+  uint32_t loopOverhead = 2;  // charged by runners once per loop() call
+};
+CostModel &costModel();
+void zeroCostModel();
+
+// --- Pins ---
+// Analog inputs: either a fixed per-pin value or a handler that computes
+// the reading from the current virtual time (used by the simulator).
+void setAnalogValue(uint8_t pin, int value);
+void setAnalogReadHandler(std::function<int(uint8_t pin)> handler);
+// The value analogRead() would return now, without charging for it
+int sampleAnalog(uint8_t pin);
+
+// Output state as last written by the firmware. PWM duty is normalised to
+// 0.0..1.0 regardless of the analogWrite resolution in use.
+uint8_t pinLevel(uint8_t pin);
+float pinDuty(uint8_t pin);
+void setDigitalInput(uint8_t pin, uint8_t level);
+// For the PwmOut stand-in: sets the duty and notifies the output listener,
+// without charging anything
+void writePinDuty(uint8_t pin, float duty);
+
+// Called after the firmware writes an output pin; the new value is already
+// visible through pinLevel()/pinDuty().
+void setOutputListener(std::function<void(uint8_t pin)> listener);
+
+// --- Serial ---
+void setSerialEcho(bool echo);
+const std::string &serialOutput();
+void clearSerialOutput();
+
+// --- WiFi / UDP ---
+struct Datagram {
+  std::vector<uint8_t> data;
+  IPAddress ip;
+  uint16_t port = 0;
+
+  std::string text() const { return std::string(data.begin(), data.end()); }
+};
+
+void setWifiAvailable(bool available);
+IPAddress localIp();
+void injectPacket(const std::string &payload,
+                  IPAddress from = IPAddress(192, 168, 1, 10),
+                  uint16_t port = 4210);
+void setPacketSentListener(std::function<void(const Datagram &)> listener);
+size_t pendingPackets();
+
+// --- EEPROM (data flash) ---
+uint8_t *eepromData(); // EEPROM_SIZE bytes, erased to 0xFF at start
+void eraseEeprom();
+uint32_t eepromWrites(); // Cells actually changed since start
+
+// --- LED matrix ---
+const uint32_t *matrixFrame(); // Last frame pushed, 3 words
+
+} // namespace host
+
+#endif
@@ -0,0 +1,152 @@
+#include "QTRSensors.h"
+
+void QTRSensors::setTypeAnalog() {
+  type = QTRType::Analog;
+  maxValue = 1023;
+}
+
+void QTRSensors::setSensorPins(const uint8_t *pins, uint8_t count) {
+  if (count > QTRMaxSensors) count = QTRMaxSensors;
+  memcpy(sensorPins, pins, count);
+  sensorCount = count;
+  calibrationOn.initialized = false;
+  calibrationOff.initialized = false;
+}
+
+void QTRSensors::setEmitterPin(uint8_t pin) {
+  emitterPin = pin;
+  pinMode(emitterPin, OUTPUT);
+}
+
+void QTRSensors::setSamplesPerSensor(uint8_t samples) {
+  if (samples > 64) samples = 64;
+  samplesPerSensor = samples ? samples : 1;
+}
+
+void QTRSensors::emittersOn() {
+  if (emitterPin != QTRNoEmitterPin) digitalWrite(emitterPin, HIGH);
+}
+
+void QTRSensors::emittersOff() {
+  if (emitterPin != QTRNoEmitterPin) digitalWrite(emitterPin, LOW);
+}
+
+void QTRSensors::resetCalibration() {
+  for (uint8_t i = 0; i < sensorCount; i++) {
+    if (calibrationOn.maximum) calibrationOn.maximum[i] = 0;
+    if (calibrationOn.minimum) calibrationOn.minimum[i] = maxValue;
+  }
+}
+
+void QTRSensors::calibrate(QTRReadMode mode) {
+  if (mode != QTRReadMode::On) return; // Only emitter-on calibration is used
+
+  if (!calibrationOn.initialized) {
+    calibrationOn.maximum = calMaximum;
+    calibrationOn.minimum = calMinimum;
+    for (uint8_t i = 0; i < sensorCount; i++) {
+      calibrationOn.maximum[i] = 0;
+      calibrationOn.minimum[i] = maxValue;
+    }
+    calibrationOn.initialized = true;
+  }
+
+  uint16_t sensorValues[QTRMaxSensors];
+  uint16_t maxSensorValues[QTRMaxSensors];
+  uint16_t minSensorValues[QTRMaxSensors];
+
+  for (uint8_t j = 0; j < 10; j++) {
+    read(sensorValues, mode);
+    for (uint8_t i = 0; i < sensorCount; i++) {
+      if (j == 0 || sensorValues[i] > maxSensorValues[i])
+        maxSensorValues[i] = sensorValues[i];
+      if (j == 0 || sensorValues[i] < minSensorValues[i])
+        minSensorValues[i] = sensorValues[i];
+    }
+  }
+
+  // Only widen the range by values seen in all ten reads (noise rejection)
+  for (uint8_t i = 0; i < sensorCount; i++) {
+    if (minSensorValues[i] > calibrationOn.maximum[i])
+      calibrationOn.maximum[i] = minSensorValues[i];
+    if (maxSensorValues[i] < calibrationOn.minimum[i])
+      calibrationOn.minimum[i] = maxSensorValues[i];
+  }
+}
+
+void QTRSensors::read(uint16_t *sensorValues, QTRReadMode mode) {
+  if (type == QTRType::Undefined) return;
+  if (mode == QTRReadMode::On || mode == QTRReadMode::OnAndOff) emittersOn();
+  readPrivate(sensorValues);
+}
+
+void QTRSensors::readPrivate(uint16_t *sensorValues) {
+  for (uint8_t i = 0; i < sensorCount; i++) sensorValues[i] = 0;
+
+  for (uint8_t j = 0; j < samplesPerSensor; j++) {
+    for (uint8_t i = 0; i < sensorCount; i++) {
+      sensorValues[i] += analogRead(sensorPins[i]);
+    }
+  }
+
+  for (uint8_t i = 0; i < sensorCount; i++) {
+    sensorValues[i] = (sensorValues[i] + (samplesPerSensor >> 1)) /
+                      samplesPerSensor;
+  }
+}
+
+void QTRSensors::readCalibrated(uint16_t *sensorValues, QTRReadMode mode) {
+  if (!calibrationOn.initialized) return;
+
+  read(sensorValues, mode);
+
+  for (uint8_t i = 0; i < sensorCount; i++) {
+    uint16_t calmin = calibrationOn.minimum[i];
+    uint16_t calmax = calibrationOn.maximum[i];
+    uint16_t denominator = calmax - calmin;
+    int16_t value = 0;
+
+    if (calmax > calmin && denominator != 0) {
+      value = (((int32_t)sensorValues[i]) - calmin) * 1000 / denominator;
+    }
+
+    if (value < 0) value = 0;
+    else if (value > 1000) value = 1000;
+
+    sensorValues[i] = value;
+  }
+}
+
+uint16_t QTRSensors::readLinePrivate(uint16_t *sensorValues, QTRReadMode mode,
+                                     bool invertReadings) {
+  bool onLine = false;
+  uint32_t avg = 0;
+  uint16_t sum = 0;
+
+  readCalibrated(sensorValues, mode);
+
+  for (uint8_t i = 0; i < sensorCount; i++) {
+    uint16_t value = sensorValues[i];
+    if (invertReadings) value = 1000 - value;
+
+    if (value > 200) onLine = true;
+
+    // Only average in values above a noise threshold
+    if (value > 50) {
+      avg += (uint32_t)value * (i * 1000);
+      sum += value;
+    }
+  }
+
+  if (!onLine) {
+    // Off the line: report the edge the line was last seen on
+    if (lastPosition < (sensorCount - 1) * 1000 / 2) {
+      return 0;
+    } else {
+      return (sensorCount - 1) * 1000;
+    }
+  }
+
+  lastPosition = avg / sum;
+  return lastPosition;
+}
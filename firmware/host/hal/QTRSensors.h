@@ -0,0 +1,71 @@
+#ifndef HOST_QTRSENSORS_H
+#define HOST_QTRSENSORS_H
+
+// Host stand-in for Pololu's QTRSensors library (analog sensors only).
+// Sampling, calibration and line-position maths follow the library's
+// documented behaviour so that the firmware sees the same numbers.
+
+#include <Arduino.h>
+
+enum class QTRType : uint8_t { Undefined, RC, Analog };
+
+enum class QTRReadMode : uint8_t { Off, On, OnAndOff, Manual };
+
+const uint8_t QTRNoEmitterPin = 255;
+const uint8_t QTRMaxSensors = 31;
+
+class QTRSensors {
+public:
+  void setTypeAnalog();
+  QTRType getType() { return type; }
+
+  void setSensorPins(const uint8_t *pins, uint8_t sensorCount);
+  void setEmitterPin(uint8_t emitterPin);
+  void setSamplesPerSensor(uint8_t samples);
+
+  void emittersOn();
+  void emittersOff();
+
+  void calibrate(QTRReadMode mode = QTRReadMode::On);
+  void resetCalibration();
+
+  void read(uint16_t *sensorValues, QTRReadMode mode = QTRReadMode::On);
+  void readCalibrated(uint16_t *sensorValues,
+                      QTRReadMode mode = QTRReadMode::On);
+  uint16_t readLineBlack(uint16_t *sensorValues,
+                         QTRReadMode mode = QTRReadMode::On) {
+    return readLinePrivate(sensorValues, mode, false);
+  }
+  uint16_t readLineWhite(uint16_t *sensorValues,
+                         QTRReadMode mode = QTRReadMode::On) {
+    return readLinePrivate(sensorValues, mode, true);
+  }
+
+  struct CalibrationData {
+    bool initialized = false;
+    uint16_t *minimum = nullptr;
+    uint16_t *maximum = nullptr;
+  };
+
+  CalibrationData calibrationOn;
+  CalibrationData calibrationOff;
+
+private:
+  void readPrivate(uint16_t *sensorValues);
+  uint16_t readLinePrivate(uint16_t *sensorValues, QTRReadMode mode,
+                           bool invertReadings);
+
+  QTRType type = QTRType::Undefined;
+  uint8_t sensorPins[QTRMaxSensors] = {0};
+  uint8_t sensorCount = 0;
+  uint8_t emitterPin = QTRNoEmitterPin;
+  uint8_t samplesPerSensor = 4;
+  uint16_t maxValue = 1023;
+  uint16_t lastPosition = 0;
+
+  // Backing store for calibrationOn; the real library heap-allocates
+  uint16_t calMinimum[QTRMaxSensors];
+  uint16_t calMaximum[QTRMaxSensors];
+};
+
+#endif
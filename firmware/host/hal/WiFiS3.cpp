@@ -0,0 +1,143 @@
+#include "WiFiS3.h"
+#include "HostHal.h"
+
+#include <deque>
+
+CWifi WiFi;
+
+namespace {
+
+bool wifiAvailable = true;
+std::deque<host::Datagram> inbox;
+std::function<void(const host::Datagram &)> sentListener;
+
+const IPAddress HOST_LOCAL_IP(192, 168, 1, 50);
+
+} // namespace
+
+namespace host {
+
+void setWifiAvailable(bool available) { wifiAvailable = available; }
+
+IPAddress localIp() { return HOST_LOCAL_IP; }
+
+void injectPacket(const std::string &payload, IPAddress from, uint16_t port) {
+  Datagram d;
+  d.data.assign(payload.begin(), payload.end());
+  d.ip = from;
+  d.port = port;
+  inbox.push_back(std::move(d));
+}
+
+void setPacketSentListener(std::function<void(const Datagram &)> listener) {
+  sentListener = std::move(listener);
+}
+
+size_t pendingPackets() { return inbox.size(); }
+
+} // namespace host
+
+// --- CWifi ---
+
+uint8_t CWifi::status() {
+  host::advanceMicros(host::costModel().wifiStatus);
+  return wifiAvailable ? currentStatus : (uint8_t)WL_DISCONNECTED;
+}
+
+int CWifi::begin(const char *ssid, const char *) {
+  currentSsid = ssid;
+  currentStatus = wifiAvailable ? WL_CONNECTED : WL_CONNECT_FAILED;
+  return currentStatus;
+}
+
+uint8_t CWifi::beginAP(const char *ssid, const char *) {
+  currentSsid = ssid;
+  currentStatus = WL_AP_LISTENING;
+  return currentStatus;
+}
+
+int CWifi::disconnect() {
+  currentStatus = WL_DISCONNECTED;
+  return currentStatus;
+}
+
+IPAddress CWifi::localIP() {
+  return currentStatus == WL_CONNECTED || currentStatus == WL_AP_LISTENING
+             ? HOST_LOCAL_IP
+             : IPAddress();
+}
+
+const char *CWifi::SSID() { return currentSsid; }
+
+// --- WiFiUDP ---
+
+uint8_t WiFiUDP::begin(uint16_t port) {
+  localPort = port;
+  return 1;
+}
+
+int WiFiUDP::parsePacket() {
+  host::advanceMicros(host::costModel().udpParse);
+  rxData.clear();
+  rxOffset = 0;
+  if (inbox.empty()) return 0;
+
+  host::Datagram d = std::move(inbox.front());
+  inbox.pop_front();
+  rxData = std::move(d.data);
+  rxIp = d.ip;
+  rxPort = d.port;
+  return (int)rxData.size();
+}
+
+int WiFiUDP::available() { return (int)(rxData.size() - rxOffset); }
+
+int WiFiUDP::read() {
+  if (rxOffset >= rxData.size()) return -1;
+  return rxData[rxOffset++];
+}
+
+int WiFiUDP::read(unsigned char *buffer, size_t len) {
+  size_t n = std::min(len, rxData.size() - rxOffset);
+  if (n == 0) return -1;
+  memcpy(buffer, rxData.data() + rxOffset, n);
+  rxOffset += n;
+  return (int)n;
+}
+
+int WiFiUDP::beginPacket(IPAddress ip, uint16_t port) {
+  host::advanceMicros(host::costModel().udpBeginPacket);
+  txOpen = true;
+  txData.clear();
+  txIp = ip;
+  txPort = port;
+  return 1;
+}
+
+int WiFiUDP::beginPacket(const char *, uint16_t port) {
+  return beginPacket(IPAddress(255, 255, 255, 255), port);
+}
+
+size_t WiFiUDP::write(uint8_t byte) { return write(&byte, 1); }
+
+size_t WiFiUDP::write(const uint8_t *buffer, size_t size) {
+  host::advanceMicros(host::costModel().udpWrite);
+  if (!txOpen) return 0;
+  txData.insert(txData.end(), buffer, buffer + size);
+  return size;
+}
+
+int WiFiUDP::endPacket() {
+  if (!txOpen) return 0;
+  txOpen = false;
+  host::advanceMicros(host::costModel().udpEndPacket);
+  if (sentListener) {
+    host::Datagram d;
+    d.data = std::move(txData);
+    d.ip = txIp;
+    d.port = txPort;
+    sentListener(d);
+  }
+  txData.clear();
+  return 1;
+}
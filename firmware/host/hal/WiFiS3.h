@@ -0,0 +1,83 @@
+#ifndef HOST_WIFIS3_H
+#define HOST_WIFIS3_H
+
+// Host stand-in for the Uno R4 WiFi "WiFiS3" library. Association is
+// instantaneous; UDP traffic is exchanged with the host through the
+// injectPacket()/setPacketSentListener() hooks in HostHal.h.
+
+#include <Arduino.h>
+#include <vector>
+
+#define WIFI_FIRMWARE_LATEST_VERSION "0.4.1"
+
+enum wl_status_t {
+  WL_NO_SHIELD = 255,
+  WL_NO_MODULE = WL_NO_SHIELD,
+  WL_IDLE_STATUS = 0,
+  WL_NO_SSID_AVAIL,
+  WL_SCAN_COMPLETED,
+  WL_CONNECTED,
+  WL_CONNECT_FAILED,
+  WL_CONNECTION_LOST,
+  WL_DISCONNECTED,
+  WL_AP_LISTENING,
+  WL_AP_CONNECTED,
+  WL_AP_FAILED
+};
+
+class CWifi {
+public:
+  uint8_t status();
+  String firmwareVersion() { return String(WIFI_FIRMWARE_LATEST_VERSION); }
+  int begin(const char *ssid, const char *passphrase);
+  uint8_t beginAP(const char *ssid, const char *passphrase);
+  int disconnect();
+  IPAddress localIP();
+  const char *SSID();
+
+private:
+  uint8_t currentStatus = WL_IDLE_STATUS;
+  const char *currentSsid = "";
+};
+
+extern CWifi WiFi;
+
+class WiFiUDP {
+public:
+  uint8_t begin(uint16_t port);
+  void stop() {}
+
+  int parsePacket();
+  int available();
+  int read();
+  int read(unsigned char *buffer, size_t len);
+  int read(char *buffer, size_t len) {
+    return read((unsigned char *)buffer, len);
+  }
+  IPAddress remoteIP() { return rxIp; }
+  uint16_t remotePort() { return rxPort; }
+
+  int beginPacket(IPAddress ip, uint16_t port);
+  int beginPacket(const char *host, uint16_t port);
+  size_t write(uint8_t byte);
+  size_t write(const uint8_t *buffer, size_t size);
+  size_t write(const char *str) {
+    return write((const uint8_t *)str, strlen(str));
+  }
+  int endPacket();
+
+private:
+  uint16_t localPort = 0;
+
+  std::vector<uint8_t> rxData;
+  size_t rxOffset = 0;
+  IPAddress rxIp;
+  uint16_t rxPort = 0;
+
+  bool txOpen = false;
+  std::vector<uint8_t> txData;
+  IPAddress txIp;
+  uint16_t txPort = 0;
+};
+
+#endif
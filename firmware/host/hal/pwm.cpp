@@ -0,0 +1,45 @@
+#include "pwm.h"
+#include "HostHal.h"
+
+PwmOut::PwmOut(int pinNumber)
+    : pin(pinNumber), running(false), period(0), pulse(0) {}
+
+bool PwmOut::begin(uint32_t period_width, uint32_t pulse_width, bool raw,
+                   timer_source_div_t) {
+  // Microsecond mode is not used by the firmware
+  if (!raw || period_width == 0 || pin < 0 || pin >= NUM_DIGITAL_PINS) {
+    return false;
+  }
+  period = period_width;
+  pulse = pulse_width;
+  running = true;
+  publish();
+  return true;
+}
+
+void PwmOut::end() {
+  if (!running) return;
+  pulse = 0;
+  publish();
+  running = false;
+}
+
+bool PwmOut::period_raw(int period) {
+  if (!running || period <= 0) return false;
+  this->period = period;
+  publish();
+  return true;
+}
+
+bool PwmOut::pulseWidth_raw(int pulse) {
+  if (!running || pulse < 0) return false;
+  this->pulse = pulse;
+  publish();
+  return true;
+}
+
+void PwmOut::publish() {
+  host::advanceMicros(host::costModel().pwmWrite);
+  float duty = pulse >= period ? 1.0f : (float)pulse / period;
+  host::writePinDuty(pin, duty);
+}
@@ -0,0 +1,37 @@
+#ifndef HOST_PWM_H
+#define HOST_PWM_H
+
+// Host stand-in for the Uno R4 core's PwmOut (GPT timer PWM). Only raw
+// mode is modelled: the duty is pulse / period, published through
+// host::pinDuty() like analogWrite().
+
+#include <Arduino.h>
+
+typedef enum {
+  TIMER_SOURCE_DIV_1 = 0,
+  TIMER_SOURCE_DIV_4 = 2,
+  TIMER_SOURCE_DIV_16 = 4,
+  TIMER_SOURCE_DIV_64 = 6,
+  TIMER_SOURCE_DIV_256 = 8,
+  TIMER_SOURCE_DIV_1024 = 10
+} timer_source_div_t;
+
+class PwmOut {
+public:
+  PwmOut(int pinNumber);
+  bool begin(uint32_t period_width, uint32_t pulse_width, bool raw = false,
+             timer_source_div_t sd = TIMER_SOURCE_DIV_1);
+  void end();
+  bool period_raw(int period);
+  bool pulseWidth_raw(int pulse);
+
+private:
+  int pin;
+  bool running;
+  uint32_t period;
+  uint32_t pulse;
+
+  void publish();
+};
+
+#endif
@@ -0,0 +1,165 @@
+// cart_host: runs the LineFollower sketch on the workstation in virtual time
+// and reports control-task timing, per-task scheduler statistics and the
+// firmware's per-stage profiler histograms. Telemetry frames broadcast by
+// the sketch are decoded and counted.
+//
+//   cart_host [--seconds N] [--serial] [--zero-cost] [--no-auto]
+//
+// The analog inputs see a line sweeping sinusoidally across the array, so
+// calibration finds a usable range and the PID path is exercised. Results
+// depend only on the firmware and the HAL cost model, never on the host.
+
+#include "HostHal.h"
+#include "SketchGlobals.h"
+#include "TelemetryDecoder.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <vector>
+
+namespace {
+
+const double SWEEP_PERIOD_S = 0.8;
+const double LINE_SIGMA = 0.35; // Line width seen by the array, in sensors
+
+int sweepingLine(uint8_t pin) {
+  int index = -1;
+  for (uint8_t i = 0; i < SENSOR_COUNT; i++) {
+    if (SENSOR_PINS[i] == pin) index = i;
+  }
+  if (index < 0) return 0;
+
+  double t = host::nowMicros() / 1e6;
+  double center = 2.5 + 2.0 * std::sin(2 * M_PI * t / SWEEP_PERIOD_S);
+  double d = index - center;
+  return 100 + (int)(800 * std::exp(-d * d / (2 * LINE_SIGMA * LINE_SIGMA)));
+}
+
+void usage() {
+  printf("usage: cart_host [--seconds N] [--serial] [--zero-cost] "
+         "[--no-auto]\n");
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  double seconds = 10.0;
+  bool autoStart = true;
+
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    if (arg == "--seconds" && i + 1 < argc) {
+      seconds = atof(argv[++i]);
+    } else if (arg == "--serial") {
+      host::setSerialEcho(true);
+    } else if (arg == "--zero-cost") {
+      host::zeroCostModel();
+    } else if (arg == "--no-auto") {
+      autoStart = false;
+    } else {
+      usage();
+      return arg == "--help" ? 0 : 1;
+    }
+  }
+
+  host::setAnalogReadHandler(sweepingLine);
+
+  telemetry::SequenceTracker frames;
+  uint64_t badFrames = 0;
+  host::setPacketSentListener([&](const host::Datagram &d) {
+    if (!telemetry::isFrame(d.data.data(), d.data.size())) return;
+    // Every frame type shares the sequence counter
+    telemetry::StateFrame state;
+    telemetry::CalibrationFrame calibration;
+    telemetry::NodeFrame node;
+    telemetry::MotorIdFrame motorId;
+    if (telemetry::decodeState(d.data.data(), d.data.size(), state)) {
+      frames.update(state.header.seq);
+    } else if (telemetry::decodeCalibration(d.data.data(), d.data.size(),
+                                            calibration)) {
+      frames.update(calibration.header.seq);
+    } else if (telemetry::decodeNode(d.data.data(), d.data.size(), node)) {
+      frames.update(node.header.seq);
+    } else if (telemetry::decodeMotorId(d.data.data(), d.data.size(),
+                                        motorId)) {
+      frames.update(motorId.header.seq);
+    } else {
+      badFrames++;
+    }
+  });
+
+  auto wallStart = std::chrono::steady_clock::now();
+
+  setup();
+  uint64_t setupUs = host::nowMicros();
+  if (autoStart) host::injectPacket("CMD:AUTO");
+
+  uint64_t endUs = setupUs + (uint64_t)(seconds * 1e6);
+  std::vector<uint32_t> controlDt;
+  controlDt.reserve((size_t)(seconds * 1000));
+  uint32_t controlRuns = scheduler.getTask(0).runs;
+  uint64_t loopCalls = 0;
+
+  while (host::nowMicros() < endUs) {
+    loop();
+    loopCalls++;
+    if (scheduler.getTask(0).runs != controlRuns) {
+      controlRuns = scheduler.getTask(0).runs;
+      controlDt.push_back(scheduler.getCurrentDtUs());
+    }
+    // Skip idle spinning: jump straight to the next due task. At least 1 us,
+    // so a zero-cost loop waiting on a soft task that does not fit yet
+    // still moves time on
+    host::advanceMicros(std::max({host::costModel().loopOverhead,
+                                  scheduler.microsUntilNextTask(), 1u}));
+  }
+
+  double wallS = std::chrono::duration<double>(
+                     std::chrono::steady_clock::now() - wallStart)
+                     .count();
+
+  if (controlDt.size() < 2) return 0;
+  controlDt.erase(controlDt.begin()); // First interval spans setup()
+
+  std::vector<uint32_t> sorted = controlDt;
+  std::sort(sorted.begin(), sorted.end());
+  double total = 0;
+  for (uint32_t us : controlDt) total += us;
+
+  auto percentile = [&](double p) {
+    return sorted[std::min(sorted.size() - 1, (size_t)(p * sorted.size()))];
+  };
+
+  double virtualS = (host::nowMicros() - setupUs) / 1e6;
+  printf("setup():      %.3f s (virtual)\n", setupUs / 1e6);
+  printf("loop() calls: %llu in %.3f s (virtual)\n",
+         (unsigned long long)loopCalls, virtualS);
+  printf("control dt:   min %u  mean %.1f  p50 %u  p99 %u  max %u us "
+         "(%.0f Hz)\n",
+         sorted.front(), total / controlDt.size(), percentile(0.50),
+         percentile(0.99), sorted.back(), controlDt.size() / virtualS);
+  printf("%-10s %8s %8s %8s %8s %8s %8s\n", "task", "runs", "overrun",
+         "missed", "last", "max", "late");
+  for (uint8_t i = 0; i < scheduler.getTaskCount(); i++) {
+    const Scheduler::Task &t = scheduler.getTask(i);
+    printf("%-10s %8u %8u %8u %8u %8u %8u\n", t.name, t.runs, t.overruns,
+           t.missed, t.lastRunUs, t.maxRunUs, t.maxLateUs);
+  }
+  printf("%-10s %8s %8s %8s %8s %8s\n", "stage", "count", "min", "p50",
+         "p99", "max");
+  for (uint8_t s = 0; s < Profiler::STAGE_COUNT; s++) {
+    if (profiler.getCount(s) == 0) continue;
+    printf("%-10s %8u %8u %8u %8u %8u\n", Profiler::getStageName(s),
+           profiler.getCount(s), profiler.getMin(s),
+           profiler.getPercentile(s, 50), profiler.getPercentile(s, 99),
+           profiler.getMax(s));
+  }
+  printf("telemetry:    %llu frames (%.1f Hz), %llu lost, %llu undecodable\n",
+         (unsigned long long)frames.received(), frames.received() / virtualS,
+         (unsigned long long)frames.lost(), (unsigned long long)badFrames);
+  printf("nav state:    %d\n", navigator.getState());
+  printf("wall time:    %.3f s (%.0fx real time)\n", wallS,
+         (host::nowMicros() / 1e6) / std::max(wallS, 1e-9));
+  return 0;
+}
@@ -0,0 +1,135 @@
+#include "CartModel.h"
+
+#include "HostHal.h"
+
+#include <cmath>
+
+namespace sim {
+
+namespace {
+const double MAX_STEP_S = 0.0005;    // Integration step
+const uint64_t MIN_DEFER_US = 250;   // Motion over 250 us is < 0.1 mm
+}
+
+CartModel::CartModel(const Track &track, const CartParams &params,
+                     uint32_t seed)
+    : track(track), params(params), supply(params.nominalVolts),
+      rng(seed ? seed : 1) {}
+
+void CartModel::reset(const Pose &pose) {
+  state = pose;
+  vLeft = vRight = 0;
+  dutyLeft = dutyRight = 0;
+  distance = 0;
+  started = false;
+  poseVersion++;
+}
+
+double CartModel::arrayX() const {
+  return state.x + params.sensorOffset * std::cos(state.theta);
+}
+
+double CartModel::arrayY() const {
+  return state.y + params.sensorOffset * std::sin(state.theta);
+}
+
+double CartModel::commandedVelocity(double signedDuty,
+                                    const MotorParams &motor) const {
+  // The bridge chops the supply: a sagging pack is a smaller duty
+  double duty = std::fabs(signedDuty) * supply / params.nominalVolts;
+  if (duty <= motor.stallDuty) return 0;
+  double v = motor.gain * params.fullDutySpeed * (duty - motor.stallDuty) /
+             (1.0 - motor.stallDuty);
+  return signedDuty < 0 ? -v : v;
+}
+
+void CartModel::latchMotorCommands(const MotorPins &leftPins,
+                                   const MotorPins &rightPins,
+                                   uint64_t nowUs) {
+  // L298N: IN1 high / IN2 low drives forward, equal levels coast
+  auto signedDuty = [](const MotorPins &p) {
+    uint8_t a = host::pinLevel(p.in1), b = host::pinLevel(p.in2);
+    if (a == b) return 0.0;
+    double duty = host::pinDuty(p.enable);
+    return a ? duty : -duty;
+  };
+  double left = signedDuty(leftPins), right = signedDuty(rightPins);
+  if (left == dutyLeft && right == dutyRight) return;
+
+  advanceTo(nowUs, true);
+  dutyLeft = left;
+  dutyRight = right;
+}
+
+void CartModel::advanceTo(uint64_t nowUs, bool exact) {
+  if (!started) {
+    started = true;
+    lastUs = nowUs;
+    return;
+  }
+  if (nowUs <= lastUs) return;
+  if (!exact && nowUs - lastUs < MIN_DEFER_US) return;
+
+  double remaining = (nowUs - lastUs) / 1e6;
+  lastUs = nowUs;
+  while (remaining > 0) {
+    double dt = remaining > MAX_STEP_S ? MAX_STEP_S : remaining;
+    step(dt);
+    remaining -= dt;
+  }
+}
+
+void CartModel::step(double dt) {
+  double alpha = dt / (params.wheelTau + dt);
+  vLeft += (commandedVelocity(dutyLeft, params.left) - vLeft) * alpha;
+  vRight += (commandedVelocity(dutyRight, params.right) - vRight) * alpha;
+
+  double v = (vLeft + vRight) / 2;
+  double omega = (vRight - vLeft) / params.wheelBase;
+
+  // Midpoint integration of the unicycle model
+  double midTheta = state.theta + omega * dt / 2;
+  state.x += v * std::cos(midTheta) * dt;
+  state.y += v * std::sin(midTheta) * dt;
+  state.theta += omega * dt;
+
+  // The array sits ahead of the axle and also sweeps sideways when turning
+  double arraySpeed = std::hypot(v, omega * params.sensorOffset);
+  distance += arraySpeed * dt;
+  if (v != 0 || omega != 0) poseVersion++;
+}
+
+int CartModel::readSensor(uint8_t index, uint8_t count, double lateralShift) {
+  // Index 0 sits on the cart's right: the firmware steers left wheel faster
+  // for low positions, so this is the orientation in which its loop closes.
+  // Oversampling reads each sensor several times per pose: cache the level
+  int level;
+  if (lateralShift == 0 && index < MAX_SENSORS &&
+      cacheVersion[index] == poseVersion) {
+    level = levelCache[index];
+  } else {
+    double lateral =
+        ((double)index - (count - 1) / 2.0) * params.sensorPitch +
+        lateralShift;
+    double c = std::cos(state.theta), s = std::sin(state.theta);
+    double x = state.x + params.sensorOffset * c - lateral * s;
+    double y = state.y + params.sensorOffset * s + lateral * c;
+    float dark = track.darkness(x, y);
+    level = params.whiteLevel +
+            (int)std::lround((params.blackLevel - params.whiteLevel) * dark);
+    if (lateralShift == 0 && index < MAX_SENSORS) {
+      levelCache[index] = level;
+      cacheVersion[index] = poseVersion;
+    }
+  }
+
+  rng ^= rng << 13;
+  rng ^= rng >> 17;
+  rng ^= rng << 5;
+  int noise = params.noise ? (int)(rng % (2 * params.noise + 1)) - params.noise
+                           : 0;
+
+  return level + noise;
+}
+
+} // namespace sim
@@ -0,0 +1,97 @@
+#ifndef SIM_CART_MODEL_H
+#define SIM_CART_MODEL_H
+
+// Differential-drive cart on a Track: L298N + DC motor model driven from the
+// firmware's pin outputs, first-order wheel dynamics, and a synthesised QTR
+// analog array mounted ahead of the axle.
+
+#include "Track.h"
+
+#include <cstdint>
+
+namespace sim {
+
+struct MotorParams {
+  double stallDuty;  // Duty below which the wheel does not turn
+  double gain;       // Relative strength (manufacturing spread)
+};
+
+struct CartParams {
+  double wheelBase = 0.13;        // m
+  double sensorOffset = 0.075;    // Array ahead of the axle (m)
+  double sensorPitch = 0.009525;  // QTR-8A spacing (m)
+  double fullDutySpeed = 2.2;     // Wheel speed at 100% duty, no load (m/s)
+  double wheelTau = 0.08;         // Wheel velocity time constant (s)
+  double nominalVolts = 11.1;     // Supply the speeds above are quoted at
+  MotorParams left = {60.0 / 255, 1.00};
+  MotorParams right = {56.0 / 255, 1.08};
+
+  // Analog levels as read by analogRead() (10-bit)
+  int whiteLevel = 120;
+  int blackLevel = 880;
+  int noise = 15;                 // Uniform +/- counts
+};
+
+struct MotorPins {
+  uint8_t enable, in1, in2;
+};
+
+class CartModel {
+public:
+  CartModel(const Track &track, const CartParams &params, uint32_t seed);
+
+  void reset(const Pose &pose);
+
+  // Integrates the motion from the last call up to `nowUs`, using the motor
+  // commands that were in force over that interval. Unless `exact` is set,
+  // intervals shorter than one integration step are deferred.
+  void advanceTo(uint64_t nowUs, bool exact = false);
+
+  // Re-reads the motor driver pins after the firmware wrote one of them.
+  // Motion up to `nowUs` is integrated with the previous commands first.
+  void latchMotorCommands(const MotorPins &leftPins, const MotorPins &rightPins,
+                          uint64_t nowUs);
+
+  // Synthesised reading of array sensor `index` (0..count-1) at the
+  // current pose. `lateralShift` moves the whole array sideways (m),
+  // used to emulate the calibration sweep by hand.
+  int readSensor(uint8_t index, uint8_t count, double lateralShift = 0);
+
+  // Motor supply (V); the effective duty scales with it
+  void setSupplyVolts(double volts) { supply = volts; }
+  double supplyVolts() const { return supply; }
+
+  const Pose &pose() const { return state; }
+  double arrayX() const;
+  double arrayY() const;
+  double leftVelocity() const { return vLeft; }
+  double rightVelocity() const { return vRight; }
+  double odometer() const { return distance; }
+
+private:
+  double commandedVelocity(double signedDuty, const MotorParams &motor) const;
+  void step(double dt);
+
+  const Track &track;
+  CartParams params;
+  Pose state;
+  uint64_t lastUs = 0;
+  bool started = false;
+
+  double dutyLeft = 0, dutyRight = 0; // Signed, -1..1
+  double supply;                      // V
+  double vLeft = 0, vRight = 0;       // m/s
+  double distance = 0;                // m travelled by the array centre
+
+  // Noise-free reading of each sensor, valid until the pose next changes
+  static const uint8_t MAX_SENSORS = 16;
+  int levelCache[MAX_SENSORS];
+  uint32_t cacheVersion[MAX_SENSORS] = {0};
+  uint32_t poseVersion = 1;
+
+  uint32_t rng;
+};
+
+} // namespace sim
+
+#endif
@@ -0,0 +1,388 @@
+#include "Simulator.h"
+
+#include "HostHal.h"
+#include "SketchGlobals.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <string>
+
+namespace sim {
+
+namespace {
+
+const MotorPins LEFT_PINS = {PIN_M1_EN, PIN_M1_IN1, PIN_M1_IN2};
+const MotorPins RIGHT_PINS = {PIN_M2_EN, PIN_M2_IN3, PIN_M2_IN4};
+
+// Calibration by hand: the array is swept across the tape during setup()
+const double CALIB_SWEEP_M = 0.04;
+const double CALIB_SWEEP_PERIOD_S = 0.6;
+
+// A detection counts for a node if the array centre is within this window
+// around the bar (m, measured along the track)
+const double NODE_LEAD_WINDOW = 0.010;
+const double NODE_TRAIL_WINDOW = 0.050;
+
+const double DERAIL_LATERAL_M = 0.15;
+const double DERAIL_TIMEOUT_S = 1.0;
+const double STALL_TIMEOUT_S = 15.0;
+const double MOTOR_ID_TIMEOUT_S = 60.0;
+
+bool isMotorPin(uint8_t pin) {
+  return pin == LEFT_PINS.enable || pin == LEFT_PINS.in1 ||
+         pin == LEFT_PINS.in2 || pin == RIGHT_PINS.enable ||
+         pin == RIGHT_PINS.in1 || pin == RIGHT_PINS.in2;
+}
+
+int sensorIndex(uint8_t pin) {
+  for (uint8_t i = 0; i < SENSOR_COUNT; i++) {
+    if (SENSOR_PINS[i] == pin) return i;
+  }
+  return -1;
+}
+
+} // namespace
+
+Simulator::Simulator(const SimConfig &config) : config(config) {}
+
+bool Simulator::run(SimResult &result) {
+  if (!Track::build(config.layout, trackMap)) return false;
+
+  result = SimResult();
+  CartModel cart(trackMap, config.cart, config.seed);
+  cart.reset(trackMap.startPose());
+
+  bool calibrating = true;
+  double volts = config.batteryStart > 0 ? config.batteryStart
+                                         : config.cart.nominalVolts;
+  cart.setSupplyVolts(volts);
+
+  host::setAnalogReadHandler([&](uint8_t pin) {
+    if (pin == PIN_BATTERY_SENSE) {
+      return (int)std::lround(std::min(
+          1023.0, volts * 1000 / BATTERY_DIVIDER / BATTERY_ADC_REF_MV * 1023));
+    }
+    int index = sensorIndex(pin);
+    if (index < 0) return 0;
+    cart.advanceTo(host::nowMicros());
+    double shift = 0;
+    if (calibrating) {
+      double t = host::nowMicros() / 1e6;
+      shift = CALIB_SWEEP_M * std::sin(2 * M_PI * t / CALIB_SWEEP_PERIOD_S);
+    }
+    return cart.readSensor(index, SENSOR_COUNT, shift);
+  });
+
+  host::setOutputListener([&](uint8_t pin) {
+    if (!isMotorPin(pin)) return;
+    cart.latchMotorCommands(LEFT_PINS, RIGHT_PINS, host::nowMicros());
+  });
+
+  auto wallStart = std::chrono::steady_clock::now();
+
+  setup();
+  calibrating = false;
+  for (const std::string &command : config.commands) {
+    host::injectPacket(command);
+  }
+
+  if (config.motorId) {
+    // The cart pivots in place over the start straight; AUTO only after
+    double idStart = host::nowMicros() / 1e6;
+    uint64_t idEndUs = host::nowMicros() + (uint64_t)(MOTOR_ID_TIMEOUT_S * 1e6);
+    host::injectPacket("CMD:MOTOR_ID");
+    bool started = false;
+    while (host::nowMicros() < idEndUs) {
+      loop();
+      host::advanceMicros(std::max(host::costModel().loopOverhead,
+                                   scheduler.microsUntilNextTask()));
+      if (motorId.isRunning()) started = true;
+      else if (started) break;
+    }
+    motorId.cancel();
+    result.motorIdSeconds = host::nowMicros() / 1e6 - idStart;
+    result.motorIdOk = started && motorId.hasCurves();
+    for (uint8_t side = 0; side < 2; side++) {
+      const MotorIdentifier::Model &m = motorId.getModel(side);
+      result.motorStart[side] = m.threshold * 255.0 / MOTOR_PWM_PERIOD;
+      result.motorGain[side] = m.gain;
+      result.motorTauMs[side] = m.tauMs;
+    }
+  }
+  // First, so the tuner is armed by the time the cart follows
+  if (config.autotune) {
+    host::injectPacket(config.autotuneArgs.empty()
+                           ? "CMD:AUTOTUNE"
+                           : "CMD:AUTOTUNE:" + config.autotuneArgs);
+  }
+  if (config.learn) {
+    host::injectPacket("CMD:LEARN:" +
+                       std::to_string(std::max<size_t>(trackMap.nodes().size(), 1)));
+  }
+  host::injectPacket("CMD:AUTO");
+  bool tuning = config.autotune;
+  double tuneStart = -1;
+  bool learning = config.learn, learnStarted = false;
+  double learnStart = host::nowMicros() / 1e6;
+
+  double maxSeconds =
+      config.maxSeconds > 0 ? config.maxSeconds : 30.0 + config.laps * 300.0;
+  uint64_t endUs = host::nowMicros() + (uint64_t)(maxSeconds * 1e6);
+
+  const double L = trackMap.length();
+  const std::vector<Track::Node> &nodes = trackMap.nodes();
+  const double halfArray =
+      (SENSOR_COUNT - 1) / 2.0 * config.cart.sensorPitch;
+  const double lostLateral = halfArray + trackMap.lineWidth / 2;
+
+  size_t hint = (size_t)-1;
+  double lateral = 0;
+  double lastS = trackMap.project(cart.arrayX(), cart.arrayY(), hint, lateral);
+  double progress = lastS; // Unwrapped arc length of the array centre
+  double progressOrigin = lastS;
+
+  // Absolute node positions are lap * L + node.s; `nodeCursor` counts them
+  size_t nodeCursor = 0;
+  bool nodeMatched = false;
+  double nodeLeadTime = -1;
+  double latencySum = 0;
+
+  auto nodeAbsolute = [&](size_t k) {
+    return (k / nodes.size()) * L + nodes[k % nodes.size()].s;
+  };
+
+  double lapStart = -1;
+  double lastLapMark = 0;
+  double lapSquares = 0; // lateral^2 over the lap's control ticks
+  long lapTicks = 0;
+  bool wasLost = false;
+  double farSince = -1;
+  double lastProgressTime = host::nowMicros() / 1e6, bestProgress = progress;
+
+  NavState lastState = navigator.getState();
+  uint16_t lastAck = navigator.getDecisionAck();
+  double hostReplyAt = -1;
+  double queueRefillAt = -1;
+  double prevNow = host::nowMicros() / 1e6;
+  uint32_t controlRuns = scheduler.getTask(0).runs;
+
+  while (host::nowMicros() < endUs) {
+    loop();
+    // Skip idle spinning: jump straight to the next due task
+    host::advanceMicros(std::max(host::costModel().loopOverhead,
+                                 scheduler.microsUntilNextTask()));
+
+    // Score once per control tick; nothing observable changes in between
+    if (scheduler.getTask(0).runs == controlRuns) continue;
+    controlRuns = scheduler.getTask(0).runs;
+    cart.advanceTo(host::nowMicros());
+
+    double now = host::nowMicros() / 1e6;
+    NavState state = navigator.getState();
+
+    // --- Track progress ---
+    double s = trackMap.project(cart.arrayX(), cart.arrayY(), hint, lateral);
+    double ds = s - lastS;
+    if (ds > L / 2) ds -= L;
+    if (ds < -L / 2) ds += L;
+    progress += ds;
+    lastS = s;
+
+    // --- Battery: drains with the distance covered in the timed laps ---
+    if (config.batteryStart > 0 && lapStart >= 0) {
+      double end =
+          config.batteryEnd > 0 ? config.batteryEnd : config.batteryStart;
+      double done =
+          std::min(1.0, (progress - progressOrigin) / (config.laps * L));
+      volts = config.batteryStart + (end - config.batteryStart) * done;
+      cart.setSupplyVolts(volts);
+    }
+    if (battery.getState() != Battery::VIN_ABSENT) {
+      result.batteryLast = battery.getMillivolts() / 1000.0;
+      if (result.batteryFirst == 0) result.batteryFirst = result.batteryLast;
+    }
+    if (battery.isCutOff()) {
+      result.batteryCutoff = true;
+      result.abortReason = "battery cutoff";
+      break;
+    }
+
+    // --- CMD:AUTOTUNE: laps start with the tuned gains ---
+    if (tuning) {
+      if (tuneStart < 0 && autoTuner.isRunning()) tuneStart = now;
+      if (tuneStart < 0 && state == NAV_FOLLOWING && !autoTuner.isRunning()) {
+        tuning = false;
+        result.autotuneFailure = "not started"; // Refused the arguments
+      } else if (tuneStart >= 0 && !autoTuner.isRunning()) {
+        tuning = false;
+        result.autotuneSeconds = now - tuneStart;
+        result.autotuneFailure = autoTuner.getFailure();
+        result.autotuneOk = result.autotuneFailure.empty();
+        result.ultimateGain = autoTuner.getUltimateGain();
+        result.ultimatePeriodMs = autoTuner.getUltimatePeriodUs() / 1000.0;
+        result.tunedKp = autoTuner.getKp();
+        result.tunedKi = autoTuner.getKi();
+        result.tunedKd = autoTuner.getKd();
+      }
+    }
+
+    // --- CMD:LEARN: laps start on the learned map ---
+    if (learning && trackMemory.isLearning()) {
+      learnStarted = true;
+    } else if (learning && learnStarted) {
+      learning = false;
+      result.learnSeconds = now - learnStart;
+      result.learnFailure = trackMemory.getFailure();
+      // The telemetry task may have reported (cleared) the result already
+      result.learnOk = result.learnFailure.empty();
+      result.learnSegments = trackMemory.getSegmentCount();
+    }
+
+    if (lapStart < 0 && state == NAV_FOLLOWING && !tuning && !learning) {
+      lapStart = now;
+      lastLapMark = now;
+      progressOrigin = progress;
+    }
+    if (lapStart >= 0) {
+      lapSquares += lateral * lateral;
+      lapTicks++;
+    }
+    if (lapStart >= 0 &&
+        progress - progressOrigin >= (result.lapTimes.size() + 1) * L) {
+      result.lapTimes.push_back(now - lastLapMark);
+      result.lapRmsMm.push_back(std::sqrt(lapSquares / lapTicks) * 1000);
+      lapSquares = 0;
+      lapTicks = 0;
+      lastLapMark = now;
+      if ((int)result.lapTimes.size() >= config.laps) break;
+    }
+
+    // --- Line loss / derailment ---
+    bool lost = std::fabs(lateral) > lostLateral;
+    if (lost) {
+      if (!wasLost) result.lineLossEvents++;
+      result.offLineSeconds += now - prevNow;
+    }
+    wasLost = lost;
+
+    if (std::fabs(lateral) > DERAIL_LATERAL_M) {
+      if (farSince < 0) farSince = now;
+      if (now - farSince > DERAIL_TIMEOUT_S) {
+        result.derailed = true;
+        result.abortReason = "left the track";
+        break;
+      }
+    } else {
+      farSince = -1;
+    }
+
+    if (progress > bestProgress + 0.01) {
+      bestProgress = progress;
+      lastProgressTime = now;
+    } else if (lapStart >= 0 && now - lastProgressTime > STALL_TIMEOUT_S) {
+      result.derailed = true;
+      result.abortReason = "stalled";
+      break;
+    }
+
+    // --- Node ground truth ---
+    if (!nodes.empty()) {
+      double target = nodeAbsolute(nodeCursor);
+      if (nodeLeadTime < 0 && progress >= target - trackMap.nodeLength / 2) {
+        nodeLeadTime = now;
+      }
+      if (progress > target + trackMap.nodeLength / 2 + NODE_TRAIL_WINDOW) {
+        result.nodesExpected++;
+        if (!nodeMatched) result.missedNodes++;
+        nodeCursor++;
+        nodeMatched = false;
+        nodeLeadTime = -1;
+      }
+    }
+
+    // --- Node detections reported by the firmware ---
+    // (a queued decision is taken on the fly: the state may not change)
+    uint16_t ack = navigator.getDecisionAck();
+    bool detected = (lastState == NAV_FOLLOWING &&
+                     (state == NAV_WAITING_HOST || state == NAV_AT_NODE)) ||
+                    ack != lastAck;
+    lastAck = ack;
+    if (detected) {
+      double target = nodes.empty() ? -1e9 : nodeAbsolute(nodeCursor);
+      bool inWindow =
+          progress >= target - trackMap.nodeLength / 2 - NODE_LEAD_WINDOW &&
+          progress <= target + trackMap.nodeLength / 2 + NODE_TRAIL_WINDOW;
+      if (inWindow && !nodeMatched) {
+        nodeMatched = true;
+        result.nodesDetected++;
+        latencySum += now - (nodeLeadTime >= 0 ? nodeLeadTime : now);
+      } else {
+        result.falseNodes++;
+      }
+    }
+
+    // --- Host app stand-in: answer WAITING_HOST like main.dart does ---
+    if (state == NAV_WAITING_HOST) {
+      if (hostReplyAt < 0) hostReplyAt = now + config.hostLatencyMs / 1000.0;
+      if (now >= hostReplyAt && host::pendingPackets() == 0) {
+        char decision =
+            nodes.empty() ? 'S' : nodes[nodeCursor % nodes.size()].decision;
+        host::injectPacket(decision == 'L'   ? "NAV:GO_LEFT"
+                           : decision == 'R' ? "NAV:GO_RIGHT"
+                                             : "NAV:GO_STRAIGHT");
+        hostReplyAt = now + 1.0; // Retry if the command is lost
+      }
+    } else {
+      hostReplyAt = -1;
+    }
+    if (config.lookahead > 0 &&
+        navigator.getQueuedDecisions() * 2 <= config.lookahead) {
+      if (queueRefillAt < 0) {
+        queueRefillAt = now + config.hostLatencyMs / 1000.0;
+      }
+      if (now >= queueRefillAt && host::pendingPackets() == 0) {
+        int count = std::min(config.lookahead, DECISION_QUEUE_SIZE) -
+                    navigator.getQueuedDecisions();
+        // Decision n is for the n-th node from the start
+        uint16_t seq = navigator.getNextDecisionSeq();
+        std::string decisions;
+        for (int i = 0; i < count; i++) {
+          decisions += nodes.empty() ? 'S'
+                                     : nodes[(seq - 1 + i) % nodes.size()].decision;
+        }
+        host::injectPacket("NAV:QUEUE:" + std::to_string(seq) + "," +
+                           decisions);
+        queueRefillAt = now + 1.0; // Retry if the command is lost
+      }
+    } else {
+      queueRefillAt = -1;
+    }
+
+    lastState = state;
+    prevNow = now;
+  }
+
+  // Stopped on a node already seen (a lap may end right at one)
+  if (nodeMatched) result.nodesExpected++;
+
+  result.virtualSeconds = host::nowMicros() / 1e6;
+  result.wallSeconds = std::chrono::duration<double>(
+                           std::chrono::steady_clock::now() - wallStart)
+                           .count();
+  result.distance = cart.odometer();
+  result.trackSynced = trackMemory.isSynced();
+  if (result.nodesDetected > 0) {
+    result.detectionLatencyMs = latencySum * 1000 / result.nodesDetected;
+  }
+  if (result.abortReason.empty() &&
+      (int)result.lapTimes.size() < config.laps) {
+    result.abortReason = "time limit";
+  }
+
+  host::setAnalogReadHandler(nullptr);
+  host::setOutputListener(nullptr);
+  return true;
+}
+
+} // namespace sim
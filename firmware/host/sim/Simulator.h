@@ -0,0 +1,99 @@
+#ifndef SIM_SIMULATOR_H
+#define SIM_SIMULATOR_H
+
+// Runs the real sketch (setup()/loop()) against a CartModel on a Track in
+// virtual time and scores the run. The sketch keeps its state in globals,
+// so a process can only host one Simulator run.
+
+#include "CartModel.h"
+#include "Track.h"
+
+#include <string>
+#include <vector>
+
+namespace sim {
+
+struct SimConfig {
+  std::string layout = "oval";
+  int laps = 10;
+  double maxSeconds = 0;      // 0 = derived from the lap count
+  uint32_t seed = 1;
+  uint32_t hostLatencyMs = 50; // App reply delay to NAV_WAITING_HOST
+  // > 0: the app keeps this many decisions queued ahead (NAV:QUEUE), topped
+  // up a host latency after half were taken, instead of answering the nodes
+  int lookahead = 0;
+  std::vector<std::string> commands; // Injected after setup(), before AUTO
+  bool motorId = false; // Run CMD:MOTOR_ID to completion before AUTO
+  bool autotune = false; // CMD:AUTOTUNE with AUTO; laps count from its end
+  std::string autotuneArgs; // e.g. "NORMAL,30", empty for the defaults
+  // CMD:LEARN over one lap with AUTO; laps count from its end, planned on it
+  bool learn = false;
+  // Pack voltage, drained linearly over the timed laps; 0 = a steady
+  // cart.nominalVolts
+  double batteryStart = 0, batteryEnd = 0;
+  CartParams cart;
+};
+
+struct SimResult {
+  std::vector<double> lapTimes; // s
+  std::vector<double> lapRmsMm; // Array to tape centre per lap, RMS
+
+  double virtualSeconds = 0;
+  double wallSeconds = 0;
+  double distance = 0;          // m travelled by the array
+
+  int lineLossEvents = 0;       // Array fully off the tape
+  double offLineSeconds = 0;
+
+  int nodesExpected = 0;
+  int nodesDetected = 0;        // Detections matched to a real node
+  int falseNodes = 0;           // Detections away from any node
+  int missedNodes = 0;
+  double detectionLatencyMs = 0; // Mean, leading edge -> detection
+
+  // CMD:MOTOR_ID, when SimConfig::motorId is set (left, right)
+  bool motorIdOk = false;
+  double motorIdSeconds = 0;
+  double motorStart[2] = {};  // 8-bit PWM
+  double motorGain[2] = {};   // Position counts/s per PWM step
+  double motorTauMs[2] = {};
+
+  // CMD:AUTOTUNE, when SimConfig::autotune is set
+  bool autotuneOk = false;
+  double autotuneSeconds = 0;   // Following time until the gains were set
+  std::string autotuneFailure;
+  double ultimateGain = 0;
+  double ultimatePeriodMs = 0;
+  double tunedKp = 0, tunedKi = 0, tunedKd = 0;
+
+  // CMD:LEARN, when SimConfig::learn is set
+  bool learnOk = false;
+  double learnSeconds = 0;
+  int learnSegments = 0;
+  std::string learnFailure;
+  bool trackSynced = false; // Still in step with the map at the end
+
+  double batteryFirst = 0, batteryLast = 0; // V, as the firmware filtered it
+  bool batteryCutoff = false;
+
+  bool derailed = false;
+  std::string abortReason;
+};
+
+class Simulator {
+public:
+  explicit Simulator(const SimConfig &config);
+
+  // Returns false if the layout is unknown
+  bool run(SimResult &result);
+
+  const Track &track() const { return trackMap; }
+
+private:
+  SimConfig config;
+  Track trackMap;
+};
+
+} // namespace sim
+
+#endif
@@ -0,0 +1,248 @@
+#include "Track.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace sim {
+
+namespace {
+
+const double SAMPLE_SPACING = 0.005; // Centreline resolution (m)
+const double RASTER_MARGIN = 0.15;
+const size_t PROJECT_WINDOW = 12; // Samples searched either side of a hint
+
+double clamp01(double v) { return v < 0 ? 0 : (v > 1 ? 1 : v); }
+
+} // namespace
+
+bool Track::build(const std::string &name, Track &track) {
+  track = Track();
+
+  if (name == "oval") {
+    // 1 m straights with a node in the middle of each, R = 0.3 m ends
+    track.addStraight(0.5);
+    track.addNode();
+    track.addStraight(0.5);
+    track.addArc(0.3, M_PI);
+    track.addStraight(0.5);
+    track.addNode();
+    track.addStraight(0.5);
+    track.addArc(0.3, M_PI);
+  } else if (name == "square") {
+    // 0.9 m sides, tight R = 0.1 m corners, nodes on every side
+    for (int side = 0; side < 4; side++) {
+      track.addStraight(0.45);
+      track.addNode();
+      track.addStraight(0.45);
+      track.addArc(0.1, M_PI / 2);
+    }
+  } else if (name == "slalom") {
+    // Oval whose back straight is replaced by alternating S-bends
+    track.addStraight(0.6);
+    track.addNode();
+    track.addStraight(0.6);
+    track.addArc(0.3, M_PI);
+    for (int i = 0; i < 2; i++) {
+      track.addArc(0.15, M_PI / 3);
+      track.addArc(0.15, -2 * M_PI / 3);
+      track.addArc(0.15, M_PI / 3);
+    }
+    // Two S-bends advance 4 * 0.15 * sin(60) along the straight
+    track.addStraight(1.2 - 8 * 0.15 * std::sin(M_PI / 3));
+    track.addArc(0.3, M_PI);
+  } else if (name == "corners") {
+    // L-shaped, 0.9 x 0.9 m, sides meeting at right angles with a node on
+    // each corner: the line cannot be followed round, the cart has to turn
+    // there (five times left, once right)
+    const double sides[] = {0.9, 0.45, 0.45, 0.45, 0.45, 0.9};
+    const char turns[] = "LLRLLL";
+    for (int side = 0; side < 6; side++) {
+      track.addStraight(sides[side]);
+      track.addNode(turns[side]);
+      track.addArc(0, turns[side] == 'L' ? M_PI / 2 : -M_PI / 2);
+    }
+  } else {
+    return false;
+  }
+
+  track.close();
+  return true;
+}
+
+const char *Track::layoutNames() { return "oval, square, slalom, corners"; }
+
+Track::Track() { appendSample(0, 0, 0); }
+
+void Track::appendSample(double x, double y, double heading) {
+  if (!samples.empty()) {
+    const Sample &last = samples.back();
+    totalLength += std::hypot(x - last.x, y - last.y);
+  }
+  samples.push_back({x, y, heading, totalLength});
+  cursorX = x;
+  cursorY = y;
+  cursorHeading = heading;
+}
+
+void Track::addStraight(double length) {
+  int steps = std::max(1, (int)std::ceil(length / SAMPLE_SPACING));
+  double x0 = cursorX, y0 = cursorY, h = cursorHeading;
+  for (int i = 1; i <= steps; i++) {
+    double d = length * i / steps;
+    appendSample(x0 + d * std::cos(h), y0 + d * std::sin(h), h);
+  }
+}
+
+void Track::addArc(double radius, double angle) {
+  double arcLength = radius * std::fabs(angle);
+  int steps = std::max(1, (int)std::ceil(arcLength / SAMPLE_SPACING));
+  double side = angle > 0 ? 1.0 : -1.0;
+  double h0 = cursorHeading;
+  // Centre of rotation lies `radius` to the left (or right) of the cursor
+  double cx = cursorX - side * radius * std::sin(h0);
+  double cy = cursorY + side * radius * std::cos(h0);
+  for (int i = 1; i <= steps; i++) {
+    double h = h0 + angle * i / steps;
+    appendSample(cx + side * radius * std::sin(h),
+                 cy - side * radius * std::cos(h), h);
+  }
+}
+
+void Track::addNode(char decision) {
+  nodeList.push_back({totalLength, decision});
+}
+
+Pose Track::startPose() const {
+  return {samples.front().x, samples.front().y, samples.front().heading};
+}
+
+void Track::close() {
+  // Join the end back to the start if the layout does not close exactly
+  const Sample &first = samples.front();
+  const Sample &last = samples.back();
+  totalLength += std::hypot(first.x - last.x, first.y - last.y);
+
+  double minX = first.x, maxX = first.x, minY = first.y, maxY = first.y;
+  for (const Sample &p : samples) {
+    minX = std::min(minX, p.x);
+    maxX = std::max(maxX, p.x);
+    minY = std::min(minY, p.y);
+    maxY = std::max(maxY, p.y);
+  }
+  originX = minX - RASTER_MARGIN;
+  originY = minY - RASTER_MARGIN;
+  width = (int)std::ceil((maxX - minX + 2 * RASTER_MARGIN) / cellSize) + 1;
+  height = (int)std::ceil((maxY - minY + 2 * RASTER_MARGIN) / cellSize) + 1;
+  raster.assign((size_t)width * height, 0);
+
+  for (size_t i = 0; i + 1 < samples.size(); i++) {
+    stampSegment(samples[i], samples[i + 1]);
+  }
+  stampSegment(samples.back(), samples.front());
+
+  for (const Node &node : nodeList) {
+    auto it = std::lower_bound(
+        samples.begin(), samples.end(), node.s,
+        [](const Sample &p, double s) { return p.s < s; });
+    stampNode(it == samples.end() ? samples.back() : *it);
+  }
+}
+
+void Track::stampPixel(int cx, int cy, float value) {
+  if (cx < 0 || cy < 0 || cx >= width || cy >= height) return;
+  uint8_t v = (uint8_t)std::lround(clamp01(value) * 255);
+  uint8_t &cell = raster[(size_t)cy * width + cx];
+  if (v > cell) cell = v;
+}
+
+void Track::stampSegment(const Sample &a, const Sample &b) {
+  double reach = lineWidth / 2 + edgeBlur;
+  int x0 = (int)std::floor((std::min(a.x, b.x) - reach - originX) / cellSize);
+  int x1 = (int)std::ceil((std::max(a.x, b.x) + reach - originX) / cellSize);
+  int y0 = (int)std::floor((std::min(a.y, b.y) - reach - originY) / cellSize);
+  int y1 = (int)std::ceil((std::max(a.y, b.y) + reach - originY) / cellSize);
+
+  double dx = b.x - a.x, dy = b.y - a.y;
+  double len2 = dx * dx + dy * dy;
+
+  for (int cy = y0; cy <= y1; cy++) {
+    for (int cx = x0; cx <= x1; cx++) {
+      double px = originX + cx * cellSize, py = originY + cy * cellSize;
+      double t = len2 > 0 ? ((px - a.x) * dx + (py - a.y) * dy) / len2 : 0;
+      t = clamp01(t);
+      double d = std::hypot(px - (a.x + t * dx), py - (a.y + t * dy));
+      stampPixel(cx, cy, (float)((lineWidth / 2 + edgeBlur / 2 - d) / edgeBlur));
+    }
+  }
+}
+
+void Track::stampNode(const Sample &at) {
+  double reach = std::hypot(nodeWidth, nodeLength) / 2 + edgeBlur;
+  int x0 = (int)std::floor((at.x - reach - originX) / cellSize);
+  int x1 = (int)std::ceil((at.x + reach - originX) / cellSize);
+  int y0 = (int)std::floor((at.y - reach - originY) / cellSize);
+  int y1 = (int)std::ceil((at.y + reach - originY) / cellSize);
+  double c = std::cos(at.heading), s = std::sin(at.heading);
+
+  for (int cy = y0; cy <= y1; cy++) {
+    for (int cx = x0; cx <= x1; cx++) {
+      double px = originX + cx * cellSize - at.x;
+      double py = originY + cy * cellSize - at.y;
+      double along = std::fabs(px * c + py * s);
+      double across = std::fabs(-px * s + py * c);
+      double va = (nodeLength / 2 + edgeBlur / 2 - along) / edgeBlur;
+      double vc = (nodeWidth / 2 + edgeBlur / 2 - across) / edgeBlur;
+      stampPixel(cx, cy, (float)std::min(va, vc));
+    }
+  }
+}
+
+float Track::darkness(double x, double y) const {
+  double fx = (x - originX) / cellSize, fy = (y - originY) / cellSize;
+  int cx = (int)std::floor(fx), cy = (int)std::floor(fy);
+  if (cx < 0 || cy < 0 || cx + 1 >= width || cy + 1 >= height) return 0.0f;
+
+  double tx = fx - cx, ty = fy - cy;
+  const uint8_t *row0 = &raster[(size_t)cy * width + cx];
+  const uint8_t *row1 = row0 + width;
+  double top = row0[0] + (row0[1] - row0[0]) * tx;
+  double bottom = row1[0] + (row1[1] - row1[0]) * tx;
+  return (float)((top + (bottom - top) * ty) / 255.0);
+}
+
+double Track::project(double x, double y, size_t &hint, double &lateral) const {
+  size_t n = samples.size();
+  size_t best = 0;
+  double bestD2 = 1e30;
+
+  auto consider = [&](size_t i) {
+    double dx = x - samples[i].x, dy = y - samples[i].y;
+    double d2 = dx * dx + dy * dy;
+    if (d2 < bestD2) {
+      bestD2 = d2;
+      best = i;
+    }
+  };
+
+  if (hint >= n || n <= 2 * PROJECT_WINDOW) {
+    for (size_t i = 0; i < n; i++) consider(i);
+  } else {
+    // Wrap by hand: a division per candidate shows up in the profile
+    size_t i = hint >= PROJECT_WINDOW ? hint - PROJECT_WINDOW
+                                      : hint + n - PROJECT_WINDOW;
+    for (size_t k = 0; k <= 2 * PROJECT_WINDOW; k++) {
+      consider(i);
+      if (++i == n) i = 0;
+    }
+  }
+  hint = best;
+
+  const Sample &p = samples[best];
+  double dx = x - p.x, dy = y - p.y;
+  double c = std::cos(p.heading), s = std::sin(p.heading);
+  lateral = -dx * s + dy * c;
+  double along = std::fmod(p.s + dx * c + dy * s + totalLength, totalLength);
+  return along;
+}
+
+} // namespace sim
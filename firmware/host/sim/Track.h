@@ -0,0 +1,81 @@
+#ifndef SIM_TRACK_H
+#define SIM_TRACK_H
+
+// Closed track made of straights and arcs, with node markers (thick tape
+// bars across the line). The track is rasterised once into a darkness map
+// so that sensor synthesis is a constant-time lookup.
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace sim {
+
+struct Pose {
+  double x = 0;     // m
+  double y = 0;     // m
+  double theta = 0; // rad, 0 = +x, counter-clockwise positive
+};
+
+class Track {
+public:
+  struct Node {
+    double s;  // Arc length of the bar centre along the centreline (m)
+    char decision; // What the host answers there: 'S', 'L' or 'R'
+  };
+
+  // Built-in layouts: "oval", "square", "slalom", "corners". Returns false
+  // if unknown.
+  static bool build(const std::string &name, Track &track);
+  static const char *layoutNames();
+
+  Track();
+
+  void addStraight(double length);
+  void addArc(double radius, double angle); // angle > 0 turns left
+  void addNode(char decision = 'S');        // Bar at the current end
+  void close();                             // Rasterise; call once at the end
+
+  double length() const { return totalLength; }
+  const std::vector<Node> &nodes() const { return nodeList; }
+  Pose startPose() const;
+
+  // Darkness in 0..1 at a world point (1 = fully over tape)
+  float darkness(double x, double y) const;
+
+  // Nearest centreline sample, searching around a previous hint index.
+  // Returns the arc length and writes the signed lateral offset (m, left
+  // of the direction of travel positive).
+  double project(double x, double y, size_t &hint, double &lateral) const;
+
+  double lineWidth = 0.019;   // 3/4" electrical tape
+  double nodeWidth = 0.080;   // Across the track, wider than the array
+  double nodeLength = 0.025;  // Along the track
+  double edgeBlur = 0.004;    // Sensor footprint softening the tape edge
+
+private:
+  struct Sample {
+    double x, y, heading, s;
+  };
+
+  void appendSample(double x, double y, double heading);
+  void stampSegment(const Sample &a, const Sample &b);
+  void stampNode(const Sample &at);
+  void stampPixel(int cx, int cy, float value);
+
+  std::vector<Sample> samples;
+  std::vector<Node> nodeList;
+  double totalLength = 0;
+
+  double cursorX = 0, cursorY = 0, cursorHeading = 0;
+
+  // Raster
+  double cellSize = 0.001;
+  double originX = 0, originY = 0;
+  int width = 0, height = 0;
+  std::vector<uint8_t> raster;
+};
+
+} // namespace sim
+
+#endif
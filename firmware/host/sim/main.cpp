@@ -0,0 +1,195 @@
+// cart_sim: drives the unmodified firmware around a simulated track in
+// virtual time and reports lap time, line loss and node detection quality.
+//
+//   cart_sim [--track oval|square|slalom|corners] [--laps N] [--seed N]
+//            [--host-latency MS] [--lookahead N] [--max-seconds S]
+//            [--param key=value]... [--motor-id]
+//            [--autotune[=RULE[,RELAY]]] [--learn] [--battery V[,V]]
+//            [--serial] [--csv]
+//
+// --motor-id runs CMD:MOTOR_ID on the start straight first and compares
+// the identified motors with the model's. --autotune sends CMD:AUTOTUNE
+// with AUTO; the laps are then timed from the end of the tuning run, with
+// the gains it set. --battery START,END drains the pack linearly over the
+// laps (END defaults to START); see battery.nominal for the compensation.
+// --learn records a lap with CMD:LEARN first; the laps are then timed on
+// the learned map (see track.speed). --lookahead N keeps the layout's
+// next N decisions queued ahead (NAV:QUEUE) instead of answering each node
+// after --host-latency.
+//
+// Runs are deterministic for a given seed. One run per process: the sketch
+// keeps its state in globals.
+
+#include "HostHal.h"
+#include "Simulator.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+namespace {
+
+void usage() {
+  printf("usage: cart_sim [--track %s] [--laps N] [--seed N]\n"
+         "                [--host-latency MS] [--lookahead N]\n"
+         "                [--max-seconds S]\n"
+         "                [--param key=value]... [--motor-id]\n"
+         "                [--autotune[=RULE[,RELAY]]] [--learn]\n"
+         "                [--battery V[,V]]\n"
+         "                [--serial] [--csv]\n",
+         sim::Track::layoutNames());
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  sim::SimConfig config;
+  bool csv = false;
+
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    bool hasValue = i + 1 < argc;
+    if (arg == "--track" && hasValue) {
+      config.layout = argv[++i];
+    } else if (arg == "--laps" && hasValue) {
+      config.laps = atoi(argv[++i]);
+    } else if (arg == "--seed" && hasValue) {
+      config.seed = (uint32_t)strtoul(argv[++i], nullptr, 10);
+    } else if (arg == "--host-latency" && hasValue) {
+      config.hostLatencyMs = (uint32_t)strtoul(argv[++i], nullptr, 10);
+    } else if (arg == "--lookahead" && hasValue) {
+      config.lookahead = atoi(argv[++i]);
+    } else if (arg == "--max-seconds" && hasValue) {
+      config.maxSeconds = atof(argv[++i]);
+    } else if (arg == "--param" && hasValue) {
+      // Sent as PARAM:SET after setup(), e.g. --param speed.base=60
+      std::string param = argv[++i];
+      size_t eq = param.find('=');
+      if (eq == std::string::npos) {
+        usage();
+        return 1;
+      }
+      param[eq] = ',';
+      config.commands.push_back("PARAM:SET:" + param);
+    } else if (arg == "--motor-id") {
+      config.motorId = true;
+    } else if (arg.compare(0, 10, "--autotune") == 0 &&
+               (arg.size() == 10 || arg[10] == '=')) {
+      config.autotune = true;
+      if (arg.size() > 11) config.autotuneArgs = arg.substr(11);
+    } else if (arg == "--learn") {
+      config.learn = true;
+    } else if (arg == "--battery" && hasValue) {
+      char *end;
+      config.batteryStart = strtod(argv[++i], &end);
+      config.batteryEnd = *end == ',' ? strtod(end + 1, nullptr) : 0;
+    } else if (arg == "--serial") {
+      host::setSerialEcho(true);
+    } else if (arg == "--csv") {
+      csv = true;
+    } else {
+      usage();
+      return arg == "--help" ? 0 : 1;
+    }
+  }
+
+  sim::Simulator simulator(config);
+  sim::SimResult r;
+  if (!simulator.run(r)) {
+    fprintf(stderr, "unknown track '%s' (known: %s)\n", config.layout.c_str(),
+            sim::Track::layoutNames());
+    return 1;
+  }
+
+  size_t laps = r.lapTimes.size();
+  double best = 0, worst = 0, mean = 0;
+  if (laps) {
+    best = *std::min_element(r.lapTimes.begin(), r.lapTimes.end());
+    worst = *std::max_element(r.lapTimes.begin(), r.lapTimes.end());
+    for (double t : r.lapTimes) mean += t;
+    mean /= laps;
+  }
+  double accuracy =
+      r.nodesExpected ? 100.0 * r.nodesDetected / r.nodesExpected : 0;
+  double speedup = r.virtualSeconds / std::max(r.wallSeconds, 1e-9);
+
+  if (csv) {
+    printf("track,seed,laps,lap_mean_s,lap_best_s,lap_worst_s,loss_events,"
+           "offline_s,nodes_expected,nodes_detected,nodes_false,nodes_missed,"
+           "detect_latency_ms,derailed,virtual_s,wall_s\n");
+    printf("%s,%u,%zu,%.3f,%.3f,%.3f,%d,%.3f,%d,%d,%d,%d,%.1f,%d,%.1f,%.3f\n",
+           config.layout.c_str(), config.seed, laps, mean, best, worst,
+           r.lineLossEvents, r.offLineSeconds, r.nodesExpected,
+           r.nodesDetected, r.falseNodes, r.missedNodes, r.detectionLatencyMs,
+           r.derailed ? 1 : 0, r.virtualSeconds, r.wallSeconds);
+  } else {
+    printf("track:        %s (%.2f m, %zu nodes), seed %u\n",
+           config.layout.c_str(), simulator.track().length(),
+           simulator.track().nodes().size(), config.seed);
+    printf("laps:         %zu/%d", laps, config.laps);
+    if (!r.abortReason.empty()) printf(" (stopped: %s)", r.abortReason.c_str());
+    printf("\n");
+    if (laps) {
+      printf("lap time:     mean %.2f s  best %.2f s  worst %.2f s\n", mean,
+             best, worst);
+    }
+    if (laps) {
+      printf("tracking:     RMS %.1f mm first lap, %.1f mm last\n",
+             r.lapRmsMm.front(), r.lapRmsMm.back());
+    }
+    printf("line loss:    %d events, %.2f s off the line (%.2f / lap)\n",
+           r.lineLossEvents, r.offLineSeconds,
+           laps ? (double)r.lineLossEvents / laps : 0.0);
+    printf("nodes:        %d/%d detected (%.1f%%), %d false, %d missed, "
+           "latency %.0f ms\n",
+           r.nodesDetected, r.nodesExpected, accuracy, r.falseNodes,
+           r.missedNodes, r.detectionLatencyMs);
+    if (config.motorId) {
+      // Truth: stall duty, relative gain and time constant of the model
+      const sim::MotorParams *truth[] = {&config.cart.left, &config.cart.right};
+      printf("motor id:     %s in %.1f s\n", r.motorIdOk ? "done" : "FAILED",
+             r.motorIdSeconds);
+      for (int side = 0; side < 2; side++) {
+        printf("  %-5s       start %.1f PWM (model %.1f), gain %.0f, "
+               "tau %.0f ms (model %.0f)\n",
+               side ? "right" : "left", r.motorStart[side],
+               truth[side]->stallDuty * 255, r.motorGain[side],
+               r.motorTauMs[side], config.cart.wheelTau * 1000);
+      }
+      if (r.motorGain[0] > 0) {
+        printf("  gain ratio  R/L %.3f (model %.3f)\n",
+               r.motorGain[1] / r.motorGain[0],
+               config.cart.right.gain / config.cart.left.gain);
+      }
+    }
+    if (config.autotune) {
+      if (r.autotuneOk) {
+        printf("autotune:     done in %.1f s, Ku %.4f, Tu %.0f ms -> "
+               "kp %.4f ki %.4f kd %.3f\n",
+               r.autotuneSeconds, r.ultimateGain, r.ultimatePeriodMs,
+               r.tunedKp, r.tunedKi, r.tunedKd);
+      } else {
+        printf("autotune:     FAILED (%s)\n", r.autotuneFailure.c_str());
+      }
+    }
+    if (config.learn) {
+      if (r.learnOk) {
+        printf("learn:        %d segments in %.1f s, %s at the end\n",
+               r.learnSegments, r.learnSeconds,
+               r.trackSynced ? "in step" : "LOST");
+      } else {
+        printf("learn:        FAILED (%s)\n", r.learnFailure.c_str());
+      }
+    }
+    if (config.batteryStart > 0) {
+      printf("battery:      %.2f -> %.2f V measured%s\n", r.batteryFirst,
+             r.batteryLast, r.batteryCutoff ? ", cut off" : "");
+    }
+    printf("distance:     %.1f m\n", r.distance);
+    printf("time:         %.1f s virtual in %.2f s wall (%.0fx real time)\n",
+           r.virtualSeconds, r.wallSeconds, speedup);
+  }
+
+  return r.derailed ? 2 : 0;
+}
@@ -0,0 +1,220 @@
+#include "TelemetryDecoder.h"
+
+#include <cstdio>
+
+namespace telemetry {
+
+namespace {
+
+uint16_t readU16(const uint8_t *p) { return p[0] | (p[1] << 8); }
+
+int16_t readI16(const uint8_t *p) { return (int16_t)readU16(p); }
+
+uint32_t readU32(const uint8_t *p) {
+  return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+} // namespace
+
+bool isFrame(const uint8_t *data, size_t len) {
+  return len >= HEADER_SIZE && data[0] == MAGIC_0 && data[1] == MAGIC_1;
+}
+
+bool decodeHeader(const uint8_t *data, size_t len, Header &header) {
+  if (!isFrame(data, len)) return false;
+  header.version = data[2];
+  header.type = data[3];
+  header.payloadLength = data[4];
+  header.seq = readU16(data + 5);
+  header.timestampMs = readU32(data + 7);
+  return header.version == VERSION &&
+         HEADER_SIZE + header.payloadLength <= len;
+}
+
+bool decodeState(const uint8_t *data, size_t len, StateFrame &frame) {
+  if (!decodeHeader(data, len, frame.header)) return false;
+  if (frame.header.type != FRAME_STATE ||
+      frame.header.payloadLength < STATE_PAYLOAD_SIZE) {
+    return false;
+  }
+
+  const uint8_t *p = data + HEADER_SIZE;
+  frame.navState = p[0];
+  frame.sensorState = p[1];
+  frame.position = readU16(p + 2);
+  for (int i = 0; i < SENSOR_COUNT; i++) frame.sensors[i] = readU16(p + 4 + 2 * i);
+  frame.pTerm = readI16(p + 16);
+  frame.iTerm = readI16(p + 18);
+  frame.dTerm = readI16(p + 20);
+  frame.motorLeft = readI16(p + 22);
+  frame.motorRight = readI16(p + 24);
+  if (frame.header.payloadLength >= STATE_LINE_PAYLOAD_SIZE) {
+    frame.lineConfidence = p[26];
+    frame.lineWidth = readU16(p + 27);
+  }
+  if (frame.header.payloadLength >= STATE_BATTERY_PAYLOAD_SIZE) {
+    frame.batteryMv = readU16(p + 29);
+    frame.batteryState = p[31];
+  }
+  if (frame.header.payloadLength >= STATE_QUEUE_PAYLOAD_SIZE) {
+    frame.decisionAck = readU16(p + 32);
+    frame.decisionsQueued = p[34];
+  }
+  return true;
+}
+
+bool decodeCalibration(const uint8_t *data, size_t len,
+                       CalibrationFrame &frame) {
+  if (!decodeHeader(data, len, frame.header)) return false;
+  if (frame.header.type != FRAME_CALIBRATION ||
+      frame.header.payloadLength < CALIBRATION_PAYLOAD_SIZE) {
+    return false;
+  }
+
+  const uint8_t *p = data + HEADER_SIZE;
+  frame.state = p[0];
+  frame.progress = p[1];
+  for (int i = 0; i < SENSOR_COUNT; i++) {
+    frame.minimum[i] = readU16(p + 2 + 2 * i);
+    frame.maximum[i] = readU16(p + 14 + 2 * i);
+  }
+  return true;
+}
+
+bool decodeNode(const uint8_t *data, size_t len, NodeFrame &frame) {
+  if (!decodeHeader(data, len, frame.header)) return false;
+  if (frame.header.type != FRAME_NODE ||
+      frame.header.payloadLength < NODE_PAYLOAD_SIZE) {
+    return false;
+  }
+
+  const uint8_t *p = data + HEADER_SIZE;
+  frame.type = p[0];
+  frame.confidence = p[1];
+  frame.width = p[2];
+  frame.edgeUs = readU32(p + 3);
+  frame.confirmDelayUs = readU16(p + 7);
+  return true;
+}
+
+bool decodeMotorId(const uint8_t *data, size_t len, MotorIdFrame &frame) {
+  if (!decodeHeader(data, len, frame.header)) return false;
+  if (frame.header.type != FRAME_MOTOR_ID ||
+      frame.header.payloadLength < MOTOR_ID_PAYLOAD_SIZE) {
+    return false;
+  }
+
+  const uint8_t *p = data + HEADER_SIZE;
+  frame.state = p[0];
+  frame.progress = p[1];
+  frame.period = readU16(p + 2);
+  MotorModel *models[] = {&frame.left, &frame.right};
+  for (int side = 0; side < 2; side++) {
+    models[side]->threshold = readU16(p + 4 + 6 * side);
+    models[side]->gain = readU16(p + 6 + 6 * side);
+    models[side]->tauMs = readU16(p + 8 + 6 * side);
+    for (int i = 0; i < CURVE_POINTS; i++) {
+      models[side]->curve[i] =
+          readU16(p + 16 + 2 * CURVE_POINTS * side + 2 * i);
+    }
+  }
+  return true;
+}
+
+std::string describe(const StateFrame &f) {
+  static const char *BATTERY[] = {"none", "ok", "low", "cutoff"};
+  char buf[256];
+  snprintf(buf, sizeof(buf),
+           "#%u t=%u nav=%u line=%u pos=%u [%u %u %u %u %u %u] "
+           "pid=%d/%d/%d motors=%d/%d conf=%u width=%u vin=%umV %s "
+           "decisions=%u+%u",
+           f.header.seq, f.header.timestampMs, f.navState, f.sensorState,
+           f.position, f.sensors[0], f.sensors[1], f.sensors[2], f.sensors[3],
+           f.sensors[4], f.sensors[5], f.pTerm, f.iTerm, f.dTerm, f.motorLeft,
+           f.motorRight, f.lineConfidence, f.lineWidth, f.batteryMv,
+           f.batteryState < 4 ? BATTERY[f.batteryState] : "?",
+           f.decisionAck, f.decisionsQueued);
+  return buf;
+}
+
+std::string describe(const CalibrationFrame &f) {
+  static const char *STATES[] = {"idle", "running", "done", "failed"};
+  char buf[160];
+  int n = snprintf(buf, sizeof(buf), "#%u t=%u calibration %s %u%%",
+                   f.header.seq, f.header.timestampMs,
+                   f.state < 4 ? STATES[f.state] : "?", f.progress);
+  for (int i = 0; i < SENSOR_COUNT && n < (int)sizeof(buf); i++) {
+    n += snprintf(buf + n, sizeof(buf) - n, " %u-%u", f.minimum[i],
+                  f.maximum[i]);
+  }
+  return buf;
+}
+
+std::string describe(const NodeFrame &f) {
+  static const char *TYPES[] = {"none", "node", "fork"};
+  char buf[128];
+  snprintf(buf, sizeof(buf),
+           "#%u t=%u %s conf=%u width=%u edge=%uus confirmed +%uus",
+           f.header.seq, f.header.timestampMs, f.type < 3 ? TYPES[f.type] : "?",
+           f.confidence, f.width, f.edgeUs, f.confirmDelayUs);
+  return buf;
+}
+
+std::string describe(const MotorIdFrame &f) {
+  static const char *STATES[] = {"idle", "running", "done", "failed"};
+  // Thresholds and curves in 8-bit PWM units, like the motor.* parameters
+  double scale = f.period ? 255.0 / f.period : 0;
+  char buf[320];
+  int n = snprintf(buf, sizeof(buf), "#%u t=%u motor id %s %u%%",
+                   f.header.seq, f.header.timestampMs,
+                   f.state < 4 ? STATES[f.state] : "?", f.progress);
+  const MotorModel *models[] = {&f.left, &f.right};
+  for (int side = 0; side < 2 && n < (int)sizeof(buf); side++) {
+    const MotorModel &m = *models[side];
+    n += snprintf(buf + n, sizeof(buf) - n,
+                  " | %s start=%.1f gain=%u tau=%ums curve", side ? "R" : "L",
+                  m.threshold * scale, m.gain, m.tauMs);
+    for (int i = 0; i < CURVE_POINTS && n < (int)sizeof(buf); i++) {
+      n += snprintf(buf + n, sizeof(buf) - n, " %.1f", m.curve[i] * scale);
+    }
+  }
+  return buf;
+}
+
+std::string csvHeader() {
+  return "seq,t_ms,nav,line,position,s0,s1,s2,s3,s4,s5,p,i,d,left,right,"
+         "confidence,width,battery_mv,battery_state,decision_ack,"
+         "decisions_queued";
+}
+
+std::string csvRow(const StateFrame &f) {
+  char buf[224];
+  snprintf(buf, sizeof(buf),
+           "%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,%d,%d,%d,%d,%d,%u,%u,%u,%u,%u,%u",
+           f.header.seq, f.header.timestampMs, f.navState, f.sensorState,
+           f.position, f.sensors[0], f.sensors[1], f.sensors[2], f.sensors[3],
+           f.sensors[4], f.sensors[5], f.pTerm, f.iTerm, f.dTerm, f.motorLeft,
+           f.motorRight, f.lineConfidence, f.lineWidth, f.batteryMv,
+           f.batteryState, f.decisionAck, f.decisionsQueued);
+  return buf;
+}
+
+void SequenceTracker::update(uint16_t seq) {
+  received_++;
+  if (!started_) {
+    started_ = true;
+    expected_ = seq + 1;
+    return;
+  }
+  int16_t delta = (int16_t)(seq - expected_);
+  if (delta >= 0) {
+    lost_ += delta;
+    expected_ = seq + 1;
+  } else {
+    // Late arrival of a frame already counted as lost
+    reordered_++;
+    if (lost_ > 0) lost_--;
+  }
+}
+
+} // namespace telemetry
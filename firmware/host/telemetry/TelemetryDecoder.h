@@ -0,0 +1,134 @@
+#ifndef HOST_TELEMETRY_DECODER_H
+#define HOST_TELEMETRY_DECODER_H
+
+// Decoder for the cart's binary telemetry frames. The layout is defined in
+// firmware/LineFollower/src/TelemetryFrame.h; this library has no Arduino
+// dependency so tools can link it without the HAL.
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace telemetry {
+
+const uint8_t MAGIC_0 = 'C';
+const uint8_t MAGIC_1 = 'T';
+const uint8_t VERSION = 1;
+const size_t HEADER_SIZE = 11;
+const size_t STATE_PAYLOAD_SIZE = 26;
+const size_t STATE_LINE_PAYLOAD_SIZE = 29; // + line confidence and width
+const size_t STATE_BATTERY_PAYLOAD_SIZE = 32; // + battery
+const size_t STATE_QUEUE_PAYLOAD_SIZE = 35;   // + decision queue
+const size_t CALIBRATION_PAYLOAD_SIZE = 26;
+const size_t NODE_PAYLOAD_SIZE = 9;
+const size_t MOTOR_ID_PAYLOAD_SIZE = 52;
+const int SENSOR_COUNT = 6;
+const int CURVE_POINTS = 9;
+
+enum FrameType : uint8_t {
+  FRAME_STATE = 1,
+  FRAME_CALIBRATION = 2,
+  FRAME_NODE = 3,
+  FRAME_MOTOR_ID = 4
+};
+
+struct Header {
+  uint8_t version = 0;
+  uint8_t type = 0;
+  uint8_t payloadLength = 0;
+  uint16_t seq = 0;
+  uint32_t timestampMs = 0;
+};
+
+struct StateFrame {
+  Header header;
+  uint8_t navState = 0;
+  uint8_t sensorState = 0;
+  uint16_t position = 0;
+  uint16_t sensors[SENSOR_COUNT] = {};
+  int16_t pTerm = 0;
+  int16_t iTerm = 0;
+  int16_t dTerm = 0;
+  int16_t motorLeft = 0;
+  int16_t motorRight = 0;
+  uint8_t lineConfidence = 0; // 0 when sent by older firmware
+  uint16_t lineWidth = 0;
+  uint16_t batteryMv = 0;   // 0 when sent by older firmware
+  uint8_t batteryState = 0; // 0 absent, 1 ok, 2 low, 3 cut off
+  uint16_t decisionAck = 0; // 0 when sent by older firmware
+  uint8_t decisionsQueued = 0;
+};
+
+struct CalibrationFrame {
+  Header header;
+  uint8_t state = 0; // 0 idle, 1 running, 2 done, 3 failed
+  uint8_t progress = 0;
+  uint16_t minimum[SENSOR_COUNT] = {};
+  uint16_t maximum[SENSOR_COUNT] = {};
+};
+
+struct NodeFrame {
+  Header header;
+  uint8_t type = 0; // 1 node, 2 fork
+  uint8_t confidence = 0;
+  uint8_t width = 0;
+  uint32_t edgeUs = 0;       // Leading edge, cart micros()
+  uint16_t confirmDelayUs = 0;
+};
+
+struct MotorModel {
+  uint16_t threshold = 0; // Compare counts where the wheel starts turning
+  uint16_t gain = 0;      // Line position counts/s per 8-bit PWM step
+  uint16_t tauMs = 0;
+  uint16_t curve[CURVE_POINTS] = {}; // Compare counts, commands 0..255
+};
+
+struct MotorIdFrame {
+  Header header;
+  uint8_t state = 0; // 0 idle, 1 running, 2 done, 3 failed
+  uint8_t progress = 0;
+  uint16_t period = 0; // Compare counts at 100 % duty
+  MotorModel left;
+  MotorModel right;
+};
+
+// Cheap check used to tell frames apart from text messages
+bool isFrame(const uint8_t *data, size_t len);
+
+// False on bad magic, unknown version or a truncated payload
+bool decodeHeader(const uint8_t *data, size_t len, Header &header);
+bool decodeState(const uint8_t *data, size_t len, StateFrame &frame);
+bool decodeCalibration(const uint8_t *data, size_t len,
+                       CalibrationFrame &frame);
+bool decodeNode(const uint8_t *data, size_t len, NodeFrame &frame);
+bool decodeMotorId(const uint8_t *data, size_t len, MotorIdFrame &frame);
+
+// One-line human-readable rendering and a matching CSV row/header
+std::string describe(const StateFrame &frame);
+std::string describe(const CalibrationFrame &frame);
+std::string describe(const NodeFrame &frame);
+std::string describe(const MotorIdFrame &frame);
+std::string csvHeader();
+std::string csvRow(const StateFrame &frame);
+
+// Counts lost and out-of-order frames from the 16-bit sequence number
+class SequenceTracker {
+public:
+  void update(uint16_t seq);
+  void reset() { *this = SequenceTracker(); }
+
+  uint64_t received() const { return received_; }
+  uint64_t lost() const { return lost_; }
+  uint64_t reordered() const { return reordered_; }
+
+private:
+  bool started_ = false;
+  uint16_t expected_ = 0;
+  uint64_t received_ = 0;
+  uint64_t lost_ = 0;
+  uint64_t reordered_ = 0;
+};
+
+} // namespace telemetry
+
+#endif
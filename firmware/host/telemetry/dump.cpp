@@ -0,0 +1,130 @@
+// telemetry_dump: listens for cart telemetry on the LAN and prints every
+// decoded frame. Text packets (ACK:, PONG:, ...) are shown as-is.
+//
+//   telemetry_dump [--port N] [--csv]
+//
+// Ctrl-C prints a summary of received/lost frames per cart.
+
+#include "TelemetryDecoder.h"
+
+#include <arpa/inet.h>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <netinet/in.h>
+#include <string>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace {
+
+volatile sig_atomic_t stopRequested = 0;
+
+void onSignal(int) { stopRequested = 1; }
+
+void usage() { printf("usage: telemetry_dump [--port N] [--csv]\n"); }
+
+} // namespace
+
+int main(int argc, char **argv) {
+  int port = 4210;
+  bool csv = false;
+
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    if (arg == "--port" && i + 1 < argc) {
+      port = atoi(argv[++i]);
+    } else if (arg == "--csv") {
+      csv = true;
+    } else {
+      usage();
+      return arg == "--help" ? 0 : 1;
+    }
+  }
+
+  int sock = socket(AF_INET, SOCK_DGRAM, 0);
+  if (sock < 0) {
+    perror("socket");
+    return 1;
+  }
+  int yes = 1;
+  setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+
+  sockaddr_in addr = {};
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_ANY);
+  addr.sin_port = htons(port);
+  if (bind(sock, (sockaddr *)&addr, sizeof(addr)) < 0) {
+    perror("bind");
+    close(sock);
+    return 1;
+  }
+
+  struct sigaction sa = {};
+  sa.sa_handler = onSignal; // No SA_RESTART: recvfrom returns on Ctrl-C
+  sigaction(SIGINT, &sa, nullptr);
+
+  fprintf(stderr, "listening on udp/%d\n", port);
+  if (csv) printf("ip,%s\n", telemetry::csvHeader().c_str());
+
+  std::map<std::string, telemetry::SequenceTracker> carts;
+  uint8_t buf[1500];
+
+  while (!stopRequested) {
+    sockaddr_in from = {};
+    socklen_t fromLen = sizeof(from);
+    ssize_t len =
+        recvfrom(sock, buf, sizeof(buf), 0, (sockaddr *)&from, &fromLen);
+    if (len < 0) continue;
+
+    char ip[INET_ADDRSTRLEN];
+    inet_ntop(AF_INET, &from.sin_addr, ip, sizeof(ip));
+
+    telemetry::StateFrame frame;
+    telemetry::CalibrationFrame calibration;
+    telemetry::NodeFrame node;
+    telemetry::MotorIdFrame motorId;
+    if (telemetry::decodeState(buf, len, frame)) {
+      carts[ip].update(frame.header.seq);
+      if (csv) {
+        printf("%s,%s\n", ip, telemetry::csvRow(frame).c_str());
+      } else {
+        printf("%-15s %s\n", ip, telemetry::describe(frame).c_str());
+      }
+    } else if (telemetry::decodeCalibration(buf, len, calibration)) {
+      // All frame types share the sequence counter
+      carts[ip].update(calibration.header.seq);
+      if (!csv) {
+        printf("%-15s %s\n", ip, telemetry::describe(calibration).c_str());
+      }
+    } else if (telemetry::decodeNode(buf, len, node)) {
+      carts[ip].update(node.header.seq);
+      if (!csv) printf("%-15s %s\n", ip, telemetry::describe(node).c_str());
+    } else if (telemetry::decodeMotorId(buf, len, motorId)) {
+      carts[ip].update(motorId.header.seq);
+      if (!csv) printf("%-15s %s\n", ip, telemetry::describe(motorId).c_str());
+    } else if (telemetry::isFrame(buf, len)) {
+      telemetry::Header header;
+      if (telemetry::decodeHeader(buf, len, header)) {
+        carts[ip].update(header.seq);
+      }
+      if (!csv) {
+        printf("%-15s frame v%u type %u (%zd bytes, skipped)\n", ip,
+               header.version, header.type, len);
+      }
+    } else if (!csv) {
+      printf("%-15s %.*s\n", ip, (int)len, (const char *)buf);
+    }
+    fflush(stdout);
+  }
+
+  close(sock);
+  for (const auto &cart : carts) {
+    fprintf(stderr, "%s: %llu frames, %llu lost, %llu reordered\n",
+            cart.first.c_str(), (unsigned long long)cart.second.received(),
+            (unsigned long long)cart.second.lost(),
+            (unsigned long long)cart.second.reordered());
+  }
+  return 0;
+}